@@ -0,0 +1,41 @@
+// include/blend_kernels.h
+#pragma once
+
+#include <cstdint>
+#include "cpu_features.h"
+
+// Source-over compositing of premultiplied ARGB spans (the format
+// UpdateLayeredWindow expects with AC_SRC_ALPHA):
+//     dst = src + dst * (255 - src.alpha) / 255
+// Rasterizers hand over whole spans; the kernels blend 4 (SSE2) or
+// 8 (AVX2) pixels per step. Every kernel rounds exactly like the scalar
+// one, so results do not depend on the CPU. SSE2 is the default even
+// where AVX2 runs: the spans are too short for the wider lanes to pay.
+
+// x * y / 255, rounded (x, y in 0..255)
+inline uint32_t MulDiv255(uint32_t x, uint32_t y)
+{
+    uint32_t t = x * y + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+// Straight-alpha ARGB to premultiplied ARGB
+inline uint32_t PremultiplyARGB(uint32_t argb)
+{
+    uint32_t a = argb >> 24;
+    return (a << 24) |
+           (MulDiv255((argb >> 16) & 0xFF, a) << 16) |
+           (MulDiv255((argb >> 8) & 0xFF, a) << 8) |
+           MulDiv255(argb & 0xFF, a);
+}
+
+// dst[i] = src over dst[i]
+void BlendSpanSolid(uint32_t* dst, int count, uint32_t src);
+
+// dst[i] = (src * coverage[i] / 255) over dst[i]
+void BlendSpanCoverage(uint32_t* dst, const uint8_t* coverage, int count, uint32_t src);
+
+// Forces a specific kernel (e.g. for benchmarking). Returns false and
+// keeps the current kernel if the level is not supported here.
+bool SetBlendKernelLevel(SimdLevel level);
+SimdLevel GetBlendKernelLevel();
@@ -0,0 +1,24 @@
+// include/core_types.h
+#pragma once
+
+#include <cstdint>
+
+// Platform-neutral stand-ins for the Win32 types the particle core used
+// to depend on (POINT, RECT, COLORREF), so it can build without <windows.h>.
+
+// Color packed as 0x00BBGGRR, bit-compatible with COLORREF.
+typedef uint32_t Color;
+
+constexpr Color MakeRGB(int r, int g, int b)
+{
+    return static_cast<Color>((r & 0xFF) | ((g & 0xFF) << 8) | ((b & 0xFF) << 16));
+}
+
+struct Point {
+    int x, y;
+};
+
+// Pixel rectangle, right/bottom exclusive.
+struct Rect {
+    int left, top, right, bottom;
+};
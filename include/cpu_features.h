@@ -0,0 +1,19 @@
+// include/cpu_features.h
+#pragma once
+
+// Instruction-set levels the hot loops have specialized paths for.
+enum class SimdLevel {
+    SCALAR = 0,
+    SSE2,
+    AVX2,
+    NEON
+};
+
+// Best level supported by both the CPU and the OS (queried once via
+// CPUID/XGETBV on x86; NEON is assumed on AArch64).
+SimdLevel DetectSimdLevel();
+
+// True if code for the given level can run on this machine.
+bool IsSimdLevelSupported(SimdLevel level);
+
+const char* SimdLevelName(SimdLevel level);
@@ -0,0 +1,88 @@
+// include/cursor_input.h
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Cursor moves as the input device reported them, each with the time it
+// happened, so spawning can follow the path the cursor actually took
+// instead of a straight line between two per-frame samples.
+
+#define CURSOR_QUEUE_CAPACITY 1024 // Events, power of two (~1 s of 1 kHz mouse input)
+#define CURSOR_PATH_STEP_PX    4.0f // Flattening: one polyline vertex per this much chord
+#define CURSOR_PATH_MAX_SPLIT  8    // ... but at most this many per event
+
+// Input timestamps are steady_clock seconds
+inline double InputTimestamp(std::chrono::steady_clock::time_point t)
+{
+    return std::chrono::duration<double>(t.time_since_epoch()).count();
+}
+
+inline double InputTimestampNow()
+{
+    return InputTimestamp(std::chrono::steady_clock::now());
+}
+
+struct CursorEvent {
+    double time; // InputTimestamp of the move
+    float x, y;  // Global (desktop) coordinates
+};
+
+// Lock-free single-producer/single-consumer ring of cursor events: the
+// input thread pushes, the simulation thread pops. When the ring is
+// full the new event is dropped and counted.
+struct CursorEventQueue {
+    CursorEventQueue();
+
+    bool Push(const CursorEvent& e); // Producer; false if dropped
+    // Consumer: removes the oldest event if it happened at or before "time"
+    bool PopUntil(double time, CursorEvent* e);
+    void Clear();                    // Consumer
+
+    uint64_t Dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    CursorEvent events[CURSOR_QUEUE_CAPACITY];
+    alignas(64) std::atomic<uint32_t> head; // Next to pop; written by the consumer
+    alignas(64) std::atomic<uint32_t> tail; // Next to push; written by the producer
+    std::atomic<uint64_t> dropped;
+};
+
+// A stretch of cursor path flattened to a polyline. Consecutive events
+// are joined by cubic Hermite curves in time whose tangents are the
+// cursor velocity estimated from the neighbouring events (Catmull-Rom
+// with the timestamps as knots), so a fast circle stays round however
+// few frames it spans.
+struct CursorPathVertex {
+    float x, y;
+    double time;
+    float length; // Path length from the first vertex
+};
+
+struct CursorPath {
+    std::vector<CursorPathVertex> vertices;
+
+    float Length() const { return vertices.empty() ? 0.f : vertices.back().length; }
+    // The point "t" (0..1) of the way along the path, by length
+    CursorPathVertex PointAt(float t) const;
+};
+
+// Flattens events[first, count) into "path". An event before "first"
+// (at most one is used) only shapes the starting tangent, e.g. the
+// event before the previous path's end.
+void FlattenCursorPath(const CursorEvent* events, size_t count, size_t first, CursorPath& path);
+
+// Where the previous stretch of a path ended: its last two events, so
+// the next stretch joins it with a continuous tangent.
+struct CursorPathJoin {
+    CursorEvent events[2]; // Newest last
+    int count;             // 0: nothing yet, the next event starts a path
+};
+
+// Flattens "events", which start with the join's events and go on with
+// the new ones, into "path" and makes their last two the join. False if
+// nothing follows the join or there is no segment yet (a first event).
+bool ContinueCursorPath(CursorPathJoin& join, const std::vector<CursorEvent>& events, CursorPath& path);
@@ -0,0 +1,36 @@
+// include/dirty_region.h
+#pragma once
+
+#include <cstddef>
+#include "core_types.h"
+
+// Maximum number of disjoint rectangles tracked per region.
+// Once exceeded, new rectangles are merged into the closest existing one.
+#define MAX_DIRTY_RECTS 32
+
+// A small set of non-overlapping rectangles (framebuffer coordinates)
+// describing which pixels were touched.
+struct DirtyRegion {
+    Rect rects[MAX_DIRTY_RECTS];
+    int  count;
+};
+
+// Per-frame byte counters, useful to verify that clearing and
+// presenting scale with the size of the trail, not the desktop.
+struct FrameStats {
+    size_t bytesCleared;   // Bytes zeroed by DrawParticlesToDIB
+    size_t bytesPresented; // Bytes pushed to the screen by the front end
+};
+
+extern FrameStats g_frameStats;
+
+// Region helpers
+void ClearDirtyRegion(DirtyRegion& region);
+void AddDirtyRect(DirtyRegion& region, const Rect& rc);
+void AddDirtyRegion(DirtyRegion& region, const DirtyRegion& other);
+Rect GetDirtyBounds(const DirtyRegion& region);
+size_t GetDirtyArea(const DirtyRegion& region);
+
+// Rectangle helpers
+bool IsEmptyRect(const Rect& rc);
+Rect ClipRectToSurface(const Rect& rc, int width, int height);
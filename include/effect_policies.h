@@ -0,0 +1,299 @@
+// include/effect_policies.h
+#pragma once
+
+#include <cstddef>
+#include <cmath>
+#include "particles.h"
+#include "sprite_cache.h" // SpriteShape
+#include "utils.h"        // RandomHeartColor
+
+// Every effect is one policy type: how it spawns, the colors it picks,
+// the forces that move it and how it is drawn, as constants and static
+// functions. The engine instantiates its spawn, update and draw loops
+// once per policy (particles.cpp, particle_draw.cpp), so the active
+// effect and each pool are picked once per call and no inner loop
+// branches on a particle's type.
+//
+// Adding an effect: give it a ParticleType, write its policy (usually
+// on top of EffectDefaults) and append it to Effects.
+
+enum class SpawnPattern {
+    ALONG_PATH, // Spaced SPAWN_SPACING apart along the cursor's path
+    AT_CURSOR   // One at the end of the path, at most every SPAWN_INTERVAL
+};
+
+#define MAX_SPAWN_AGE_SECONDS 0.05f // Older input spawns as if this old
+
+struct FalloffKernel;
+
+// A visible particle of one frame, ready to draw
+struct DrawItem {
+    Particle p;                  // Framebuffer coordinates
+    Rect bounds;                 // Every pixel it may write, clipped to the surface
+    const Sprite* sprite;        // Sprite effects
+    const FalloffKernel* kernel; // Smoke
+    const SparkArcs* arcs;       // Sparks, in the pool
+};
+
+//------------------------------------------------------------------
+// Policy members
+//  Spawn:  SPAWN, SYSTEM_ID (tray menu id), SPAWN_SPACING, SPEED_MIN,
+//          SPEED_RANGE, LIFE_MIN/LIFE_MAX, SCALE_MIN/SCALE_MAX,
+//          ROTATES, RISES (upward velocity), MakeColor(rng) (sampled
+//          into the pool's palette once, when the pool is built),
+//          InitShape(pool, i, rng) for draw data kept per particle
+//  Forces: VX_SCALE, VY_SCALE (per step), PRE_ACCEL (before moving),
+//          GRAVITY (after moving), DRIFT (random vx nudge, 0 = none),
+//          FORCE_RESPONSE (share of the force field, force_field.h,
+//          taken on; 0 = ignores it).
+//          Every effect fades by the update kernel's shrink curve.
+//  Draw:   Prepare(item) looks up what Draw needs from the caches and
+//          returns every pixel the particle may write; Draw(item, clip,
+//          index) writes inside "clip" only, drawing its random
+//          variation from stream "index" of the frame.
+//------------------------------------------------------------------
+struct EffectDefaults {
+    static constexpr SpawnPattern SPAWN = SpawnPattern::ALONG_PATH;
+    static constexpr float SPEED_MIN   = 25.f; // Pixels per second
+    static constexpr int   SPEED_RANGE = 30;
+    static constexpr bool  ROTATES     = true;
+    static constexpr bool  RISES       = true;
+
+    static constexpr float VX_SCALE  = 1.0f;
+    static constexpr float VY_SCALE  = 1.0f;
+    static constexpr float PRE_ACCEL = 0.0f;
+    static constexpr float GRAVITY   = 20.f;
+    static constexpr float DRIFT     = 0.0f;
+    static constexpr float FORCE_RESPONSE = 0.5f;
+
+    static void InitShape(ParticlePool&, size_t, Rng&) {}
+};
+
+// Draw routines shared by the sprite effects (hearts, stars, swords)
+template <SpriteShape SHAPE>
+struct SpriteDraw {
+    static Rect Prepare(DrawItem& item);
+    static void Draw(const DrawItem& item, const Rect& clip, size_t index);
+};
+
+//------------------------------------------------------------------
+// Effects
+//------------------------------------------------------------------
+struct HeartsEffect : EffectDefaults, SpriteDraw<SpriteShape::HEART> {
+    static constexpr ParticleType TYPE = ParticleType::HEARTS;
+    static constexpr int SYSTEM_ID = 5;
+
+    // Fast hearts flung upward in a wide fan, slightly offset so they
+    // do not overlap
+    static constexpr SpawnPattern SPAWN = SpawnPattern::AT_CURSOR;
+    static constexpr double SPAWN_INTERVAL = 1.0 / 60.0; // Input seconds
+    static constexpr float  MIN_TRAVEL     = 5.0f;       // Pixels since the last heart
+    static constexpr int    SPREAD_DEGREES = 160;
+    static constexpr float  SPEED_MIN      = 150.f;
+    static constexpr int    SPEED_RANGE    = 50;
+    static constexpr int    JITTER         = 50;         // Offset NextInt(JITTER) - JITTER_BIAS
+    static constexpr int    JITTER_BIAS    = 30;
+    static constexpr float  LIFE           = 0.9f;
+    static constexpr float  SCALE_MIN      = 1.0f;
+    static constexpr float  SCALE_MAX      = 1.5f;
+    static Color MakeColor(Rng& rng) { return RandomHeartColor(rng); }
+
+    // Float rather than fall
+    static constexpr float VX_SCALE  = 1.01f;
+    static constexpr float VY_SCALE  = 1.03f;
+    static constexpr float PRE_ACCEL = -5.0f;
+    static constexpr float GRAVITY   = 0.f;
+    static constexpr float DRIFT     = 0.1f;
+};
+
+struct StarsEffect : EffectDefaults, SpriteDraw<SpriteShape::STAR> {
+    static constexpr ParticleType TYPE = ParticleType::STARS;
+    static constexpr int SYSTEM_ID = 2;
+
+    static constexpr float SPAWN_SPACING = 10.0f;
+    static constexpr float LIFE_MIN  = 0.3f, LIFE_MAX  = 0.5f;
+    static constexpr float SCALE_MIN = 0.5f, SCALE_MAX = 1.5f;
+    // Sparkly white/yellowish
+    static Color MakeColor(Rng& rng)
+    {
+        return MakeRGB(200 + rng.NextInt(56), 200 + rng.NextInt(56), 180 + rng.NextInt(76));
+    }
+};
+
+struct FireEffect : EffectDefaults {
+    static constexpr ParticleType TYPE = ParticleType::FIRE;
+    static constexpr int SYSTEM_ID = 3;
+
+    // Dense, short flames that neither fall nor spin
+    static constexpr float SPAWN_SPACING = 4.0f;
+    static constexpr float LIFE_MIN  = 0.3f, LIFE_MAX  = 0.5f;
+    static constexpr float SCALE_MIN = 1.0f, SCALE_MAX = 1.1f;
+    static constexpr bool  ROTATES   = false;
+    static constexpr bool  RISES     = false;
+    static Color MakeColor(Rng& rng)
+    {
+        int r = 200 + rng.NextInt(56); // Red to orange
+        int g = 50 + rng.NextInt(80);
+        return MakeRGB(r, g, 0);
+    }
+
+    static constexpr float GRAVITY = 0.f;
+    static constexpr float FORCE_RESPONSE = 0.8f; // Flickers with the air
+
+    static Rect Prepare(DrawItem& item);
+    static void Draw(const DrawItem& item, const Rect& clip, size_t index);
+};
+
+struct SparksEffect : EffectDefaults {
+    static constexpr ParticleType TYPE = ParticleType::SPARKS;
+    static constexpr int SYSTEM_ID = 4;
+
+    // Electric arcs: short-lived, spinning, flung out in every direction
+    static constexpr float SPAWN_SPACING = 2.0f;
+    static constexpr float LIFE_MIN  = 0.1f, LIFE_MAX  = 0.2f;
+    static constexpr float SCALE_MIN = 1.0f, SCALE_MAX = 2.0f;
+    static constexpr bool  RISES     = false;
+    static Color MakeColor(Rng& rng)
+    {
+        int g = 100 + rng.NextInt(56); // Bluish/purple
+        int b = 200 + rng.NextInt(56);
+        return MakeRGB(0, g, b);
+    }
+    // 2-4 arms of 10-40 px, each bent at 1-4 points
+    static void InitShape(ParticlePool& pool, size_t i, Rng& rng);
+
+    static constexpr float FORCE_RESPONSE = 0.25f; // Too fast to be blown far
+
+    static Rect Prepare(DrawItem& item);
+    static void Draw(const DrawItem& item, const Rect& clip, size_t index);
+};
+
+struct SmokeEffect : EffectDefaults {
+    static constexpr ParticleType TYPE = ParticleType::SMOKE;
+    static constexpr int SYSTEM_ID = 1;
+
+    // Big gray puffs that drift up, then sink
+    static constexpr float SPAWN_SPACING = 10.0f;
+    static constexpr float LIFE_MIN  = 0.3f, LIFE_MAX  = 0.5f;
+    static constexpr float SCALE_MIN = 1.0f, SCALE_MAX = 1.5f;
+    static constexpr bool  ROTATES   = false;
+    static Color MakeColor(Rng& rng)
+    {
+        int shade = 100 + rng.NextInt(100); // 100..199
+        return MakeRGB(shade, shade, shade);
+    }
+
+    static constexpr float FORCE_RESPONSE = 1.0f; // Goes wherever the air does
+
+    static Rect Prepare(DrawItem& item);
+    static void Draw(const DrawItem& item, const Rect& clip, size_t index);
+};
+
+struct SwordEffect : EffectDefaults, SpriteDraw<SpriteShape::SWORD> {
+    static constexpr ParticleType TYPE = ParticleType::SWORD;
+    static constexpr int SYSTEM_ID = 6;
+
+    static constexpr float SPAWN_SPACING = 10.0f;
+    static constexpr float LIFE_MIN  = 0.3f, LIFE_MAX  = 0.5f;
+    static constexpr float SCALE_MIN = 0.5f, SCALE_MAX = 0.5f;
+    static Color MakeColor(Rng&) { return MakeRGB(100, 100, 100); }
+};
+
+//------------------------------------------------------------------
+// EffectList
+//  Every policy. The list order is the draw order (later effects paint
+//  over earlier ones) and the update order. ForEach calls f(Effect())
+//  for each; With only for the one of "type".
+//------------------------------------------------------------------
+template <class... List>
+struct EffectList {
+    static constexpr int COUNT = sizeof...(List);
+
+    template <class F>
+    static void ForEach(F&& f) { (f(List()), ...); }
+
+    template <class F>
+    static void With(ParticleType type, F&& f) { ((type == List::TYPE ? f(List()) : void()), ...); }
+};
+
+using Effects = EffectList<HeartsEffect, StarsEffect, FireEffect, SparksEffect, SmokeEffect, SwordEffect>;
+
+static_assert(Effects::COUNT == PARTICLE_TYPE_COUNT, "every particle type needs a policy");
+
+//------------------------------------------------------------------
+// Spawning
+//  A new particle of the effect at (x, y), drawn from "rng" the way its
+//  SPAWN pattern does, and moved on as if emitted "age" seconds ago.
+//  Shared by the cursor trail (particles.cpp) and emitters
+//  (emitters.cpp); both instantiate it per effect, so it inlines into
+//  their spawn loops.
+//------------------------------------------------------------------
+template <class Effect>
+inline Particle SpawnAlongPathParticle(float x, float y, float age, Rng& rng)
+{
+    Particle p = {};
+    p.x = x;
+    p.y = y;
+
+    // Random angle & speed
+    float angle = (rng.NextInt(360) / 180.0f) * 3.14159f;
+    float speed = Effect::SPEED_MIN + rng.NextInt(Effect::SPEED_RANGE);
+    p.vx = speed * cosf(angle) * 0.5f;
+    if (Effect::RISES) {
+        p.vy = -fabsf(speed * sinf(angle)); // Negative vy for upward bias
+    } else {
+        p.vy = speed * sinf(angle) * 0.5f;
+    }
+
+    p.paletteIndex = static_cast<uint8_t>(rng.NextInt(PARTICLE_PALETTE_SIZE));
+
+    // Life
+    float chosenLife = Effect::LIFE_MIN + rng.NextFloat() * (Effect::LIFE_MAX - Effect::LIFE_MIN);
+    p.maxLife = chosenLife;
+    p.life    = chosenLife;
+
+    // Scale
+    p.scale = Effect::SCALE_MIN + rng.NextFloat() * (Effect::SCALE_MAX - Effect::SCALE_MIN);
+
+    // Rotation
+    if (Effect::ROTATES) {
+        p.angle = static_cast<float>(rng.NextInt(360)) * 3.14159f / 180.0f;
+        // rotation speed from -3..3
+        p.rotationSpeed = (rng.NextInt(601) - 300) / 100.0f;
+    }
+
+    p.x += p.vx * age;
+    p.y += p.vy * age;
+    p.life -= age;
+    p.type = Effect::TYPE;
+    return p;
+}
+
+template <class Effect>
+inline Particle SpawnAtCursorParticle(float x, float y, float age, Rng& rng)
+{
+    Particle p = {};
+    p.x = x;
+    p.y = y;
+
+    float angle = (rng.NextInt(Effect::SPREAD_DEGREES) - Effect::SPREAD_DEGREES / 2) * (3.14159f / 180.0f);
+    float speed = Effect::SPEED_MIN + rng.NextInt(Effect::SPEED_RANGE);
+    p.vx = speed * cosf(angle);
+    p.vy = -fabsf(speed * sinf(angle)); // Move upwards
+
+    p.x += rng.NextInt(Effect::JITTER) - Effect::JITTER_BIAS;
+    p.y += rng.NextInt(Effect::JITTER) - Effect::JITTER_BIAS;
+
+    p.paletteIndex = static_cast<uint8_t>(rng.NextInt(PARTICLE_PALETTE_SIZE));
+    p.maxLife = Effect::LIFE;
+    p.life = p.maxLife;
+    p.scale = Effect::SCALE_MIN + (Effect::SCALE_MAX - Effect::SCALE_MIN) * rng.NextInt(100) / 100.0f;
+    p.angle = static_cast<float>(rng.NextInt(360)) * 3.14159f / 180.0f;
+    p.rotationSpeed = (rng.NextInt(601) - 300) / 100.0f;
+
+    p.x += p.vx * age;
+    p.y += p.vy * age;
+    p.life -= age;
+    p.type = Effect::TYPE;
+    return p;
+}
@@ -0,0 +1,52 @@
+// include/emitters.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "particles.h"
+
+// Particle sources besides the cursor: pen and touch contacts, scripted
+// attract-mode paths, anything that moves and leaves a trail. Each
+// emitter has its own path (the moves fed to it, joined across spawns
+// like the cursor's queued input), its own set of effects and its own
+// RNG stream, and spawns into the same per-effect pools as the cursor.
+//
+// SpawnEmitters handles every emitter in one batch: per effect it works
+// out how many particles each emitter spawns, reserves them in the pool
+// at once (one overflow pass) and fills them in a loop instantiated for
+// that effect's policy. Emitter spawns are not part of a session
+// recording. Like the rest of the particle API, not thread-safe: call
+// from the thread that spawns and updates.
+
+#define MAX_EMITTERS 1024 // Live at once
+
+// 0 is never an emitter. A destroyed emitter's id stays invalid; its
+// slot comes back under a new id.
+typedef uint32_t EmitterId;
+
+// Effect sets: one bit per particle type
+inline uint32_t EffectBit(ParticleType type) { return 1u << PoolIndex(type); }
+#define ALL_EFFECT_BITS ((1u << PARTICLE_TYPE_COUNT) - 1)
+
+// "seed" is the emitter's random sequence: give each emitter its own
+// (e.g. the contact id) for independent trails, and the same seeds in
+// the same order to spawn the same particles again. 0 if MAX_EMITTERS
+// are live.
+EmitterId CreateEmitter(uint32_t effects, uint64_t seed);
+void DestroyEmitter(EmitterId id);   // Moves not spawned yet are dropped
+void DestroyAllEmitters();
+size_t GetEmitterCount();
+
+// False for an unknown id
+bool SetEmitterEffects(EmitterId id, uint32_t effects);
+
+// The emitter was at (x, y), global coordinates, at "time" (an
+// InputTimestamp, not before its previous move). The first move only
+// places it; the path starts from there.
+bool MoveEmitter(EmitterId id, float x, float y, double time);
+
+// Spawns along every emitter's moves up to "time" (an InputTimestamp,
+// normally the end of the step about to run), aging particles by how
+// long ago the emitter passed their point, as SpawnParticlesUntil does
+// for the cursor. Later moves wait for a later call.
+void SpawnEmitters(double time);
@@ -0,0 +1,31 @@
+// include/falloff_kernels.h
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Precomputed radial falloff tables for soft puffs (smoke), one per
+// integer radius, plus a tileable blue-noise texture used in place of
+// per-pixel random noise.
+
+#define FALLOFF_ONE 256     // Fixed-point 1.0 for kernel alpha values
+#define BLUE_NOISE_SIZE 64  // Blue-noise texture is BLUE_NOISE_SIZE^2, power of two
+
+// Squared falloff (1 - d/r)^2 over a (2r+1)x(2r+1) square centered on
+// the puff. Row j only has pixels inside the circle in
+// [spanStart[j], spanEnd[j]); everything else is never touched.
+struct FalloffKernel {
+    int radius;
+    std::vector<uint16_t> alpha;   // 0..FALLOFF_ONE, row-major
+    std::vector<int> spanStart;
+    std::vector<int> spanEnd;
+};
+
+// Built on first use; references stay valid for the life of the
+// program. Not thread-safe while a new radius is being built.
+const FalloffKernel& GetFalloffKernel(int radius);
+
+// Tileable void-and-cluster blue noise, BLUE_NOISE_SIZE^2 thresholds in
+// 0..255 (each value used equally often). Generated on first use;
+// safe to call from any thread.
+const uint8_t* GetBlueNoise();
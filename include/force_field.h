@@ -0,0 +1,68 @@
+// include/force_field.h
+#pragma once
+
+#include <cstddef>
+#include "core_types.h"
+#include "cpu_features.h"
+
+// Forces beyond each effect's own gravity and drag: wind, point
+// attractors and repulsors, and animated curl-noise turbulence. Once per
+// frame BuildForceField composites every source into one coarse grid of
+// accelerations over the desktop; the update then samples that grid at
+// each particle (bilinear, vectorized). Updating costs the same per
+// particle however many sources there are, and building costs one pass
+// over the grid plus each point's footprint. How strongly an effect
+// follows the field is its FORCE_RESPONSE (effect_policies.h).
+//
+// Sources stay set until changed. Not thread-safe: build and update
+// from the simulation thread. Force fields are not part of a session
+// recording.
+
+#define FORCE_CELL_PX    32 // Grid spacing in pixels
+#define FORCE_MAX_POINTS 32
+
+// Pulls particles within "radius" pixels of (x, y), global coordinates,
+// toward it; "strength" is the pull in pixels/s^2 at the center, fading
+// to 0 at the radius. Negative strengths push away.
+struct ForcePoint {
+    float x, y;
+    float strength;
+    float radius;
+};
+
+// The area the grid covers (global coordinates, e.g. the virtual
+// screen). Particles outside it feel the force at its edge.
+void SetForceFieldBounds(const Rect& area);
+
+// Constant acceleration everywhere, pixels/s^2
+void SetWind(float ax, float ay);
+
+// Swirls of about "featurePx" pixels with accelerations of about
+// "strength" pixels/s^2, changing "changePerSecond" times a second.
+// The acceleration is the curl of a noise field, so it stirs particles
+// without gathering them anywhere. 0 strength turns it off.
+void SetTurbulence(float strength, float featurePx, float changePerSecond);
+
+bool AddForcePoint(const ForcePoint& point); // False if FORCE_MAX_POINTS are set
+void ClearForcePoints();
+void ClearForceField(); // Wind, turbulence and points off
+
+// Composites the sources into the grid; "time" (seconds) animates the
+// turbulence. The update uses the grid last built.
+void BuildForceField(double time);
+bool IsForceFieldActive(); // The last build had a source
+
+// The field's acceleration at (x, y), e.g. for visualizing it
+void SampleForceField(float x, float y, float* ax, float* ay);
+
+// Adds the field's acceleration at each (x[i], y[i]) times "scale"
+// (typically response * dt) to (vx[i], vy[i]).
+void ApplyForceField(const float* x, const float* y, float* vx, float* vy, size_t count, float scale);
+
+// Reference implementation; the SIMD kernels give the same results.
+void ApplyForceFieldScalar(const float* x, const float* y, float* vx, float* vy, size_t count, float scale);
+
+// Forces a specific kernel (e.g. for benchmarking). Returns false and
+// keeps the current kernel if the level is not supported here.
+bool SetForceKernelLevel(SimdLevel level);
+SimdLevel GetForceKernelLevel();
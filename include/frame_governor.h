@@ -0,0 +1,49 @@
+// include/frame_governor.h
+#pragma once
+
+#include <cstdint>
+
+// Keeps the overlay's own work per frame within a budget so it does not
+// starve whatever else the machine is doing. The front end reports how
+// long each frame took (spawn, update, draw; not the wait for the next
+// one) and applies the returned level of detail with SetDetailLevel:
+// 1 is full detail, lower levels spawn sparser trails, draw simpler
+// particles and cap the pools lower. Detail drops as soon as frames run
+// over budget and comes back gradually once there is headroom.
+
+#define GOVERNOR_DEFAULT_BUDGET_SECONDS 0.004 // Of a 16.7 ms frame
+#define GOVERNOR_MIN_DETAIL        0.25f // Lowest level of detail
+#define GOVERNOR_SMOOTHING         0.25  // Weight of the newest frame in the average
+#define GOVERNOR_MAX_CUT           0.7f  // Detail kept at least, per cut
+#define GOVERNOR_CUT_INTERVAL      6     // Frames between cuts, for the average to catch up
+#define GOVERNOR_HEADROOM          0.7   // Restore while the average is below this share of the budget
+#define GOVERNOR_RESTORE_STEP      0.01f // Detail regained per frame (~1.3 s from min to full at 60 fps)
+
+struct GovernorStats {
+    uint64_t frames;         // Frames measured
+    uint64_t budgetMisses;   // Frames that took longer than the budget
+    uint64_t cuts;           // Times detail was lowered
+    float    detail;         // Current level of detail
+    float    minDetail;      // Lowest level reached
+    double   averageSeconds; // Smoothed frame time
+};
+
+struct FrameGovernor {
+    explicit FrameGovernor(double budgetSeconds = GOVERNOR_DEFAULT_BUDGET_SECONDS);
+
+    void SetBudget(double seconds);
+    double Budget() const { return budget; }
+
+    // Reports one frame's work and returns the level of detail for the
+    // next frame.
+    float FrameMeasured(double seconds);
+    float Detail() const { return stats.detail; }
+
+    void Reset(); // Full detail, stats cleared
+
+    GovernorStats stats;
+
+private:
+    double budget;
+    int    sinceCut; // Frames since detail was last lowered
+};
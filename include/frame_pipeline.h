@@ -0,0 +1,59 @@
+// include/frame_pipeline.h
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "particles.h"
+
+// Hand-off of finished frames from a simulation/raster thread to a
+// present thread, and the fixed timestep the simulation runs at.
+
+#define FRAME_SLOT_COUNT 3
+
+#define SIM_STEP_SECONDS   (1.0f / 120.0f)
+#define SIM_MAX_STEPS      8    // Per frame; a longer stall drops the excess time
+
+// One of the triple buffer's surfaces
+struct FrameSlot {
+    FrameTarget target; // Surface plus what its current frame drew
+    uint64_t sequence;  // Number of the frame it holds (0 = none yet)
+};
+
+// Lock-free single-producer/single-consumer triple buffer of slot
+// indices. The producer always owns one slot (back) and the consumer
+// one (front); the third holds the newest published frame. Neither side
+// ever waits for the other, and a slot is never written while the
+// consumer holds it, so presented frames cannot tear. Frames the
+// consumer does not pick up in time are overwritten (skipped).
+struct FrameTripleBuffer {
+    FrameTripleBuffer();
+    void Reset();
+
+    // Producer: the slot to draw the next frame into, and its hand-off
+    int  BackSlot() const { return back; }
+    void Publish();
+
+    // Consumer: takes the newest published frame if there is one it has
+    // not seen; FrontSlot() stays valid until the next AcquireLatest
+    bool AcquireLatest();
+    int  FrontSlot() const { return front; }
+
+private:
+    std::atomic<uint32_t> middle; // Slot index | FRESH_FRAME_BIT
+    int back;
+    int front;
+};
+
+// Fixed-step accumulator: real time in, whole simulation steps out.
+// Drawing at Alpha() between the last two steps keeps motion smooth at
+// any present rate while the simulation itself always advances by
+// exactly "step".
+struct FixedTimestep {
+    float step;
+    float accumulator;
+    int   maxSteps;
+
+    FixedTimestep(float step = SIM_STEP_SECONDS, int maxSteps = SIM_MAX_STEPS);
+    int   Advance(float dt);   // Steps to run now
+    float Alpha() const { return accumulator / step; }
+};
@@ -0,0 +1,112 @@
+// include/frame_profiler.h
+#pragma once
+
+#include <cstdint>
+
+// Per-stage frame instrumentation. Scoped timers and per-frame counters
+// go into a lock-free ring buffer from any thread; CollectProfile drains
+// it into HDR-style histograms (and, optionally, a trace capture) that
+// can be written out as CSV or Chrome trace-event JSON.
+//
+// Everything is compiled out unless MT_ENABLE_PROFILING is 1 (CMake:
+// -DMOUSETRAIL_PROFILING=ON): the MT_PROFILE_* macros expand to nothing
+// and the ring stays empty. The collection and export functions exist
+// either way.
+
+#ifndef MT_ENABLE_PROFILING
+  #define MT_ENABLE_PROFILING 0
+#endif
+
+#define PROFILE_RING_CAPACITY      16384   // Events, power of two
+#define PROFILE_TRACE_MAX_EVENTS   1000000 // Kept for the trace export
+#define PROFILE_HISTOGRAM_SUB_BITS 4       // 16 buckets per power of two (~6% resolution)
+#define PROFILE_HISTOGRAM_BUCKETS  (64 << PROFILE_HISTOGRAM_SUB_BITS)
+
+enum class ProfileStage : uint8_t {
+    FRAME = 0,   // One front-end frame
+    SPAWN,
+    UPDATE,
+    DRAW,        // Whole frame: collect, clear, rasterize
+    DRAW_HEARTS, // Per type, in ParticleType order; CPU time summed over
+    DRAW_STARS,  // draw threads when the frame is drawn in tiles
+    DRAW_FIRE,
+    DRAW_SPARKS,
+    DRAW_SMOKE,
+    DRAW_SWORD,
+    PRESENT,
+    COUNT
+};
+
+// Recorded once per drawn frame (DETAIL_PERCENT by governed front ends)
+enum class ProfileCounter : uint8_t {
+    LIVE_PARTICLES = 0,
+    PIXELS_WRITTEN, // Cleared pixels plus the region drawn into
+    SPAWNED,        // Since the previous frame
+    EXPIRED,
+    DETAIL_PERCENT, // Level of detail the governor picked (frame_governor.h)
+    COUNT
+};
+
+inline ProfileStage DrawStageForPool(int poolIndex)
+{
+    return static_cast<ProfileStage>(static_cast<int>(ProfileStage::DRAW_HEARTS) + poolIndex);
+}
+
+const char* ProfileStageName(ProfileStage stage);
+const char* ProfileCounterName(ProfileCounter counter);
+
+// Nanoseconds on a steady clock
+uint64_t ProfileNowNs();
+
+// Producers (any thread)
+void RecordProfileSpan(ProfileStage stage, uint64_t startNs, uint64_t endNs);
+void RecordProfileCounter(ProfileCounter counter, uint64_t value);
+
+struct ProfileScope {
+    explicit ProfileScope(ProfileStage stage) : stage(stage), start(ProfileNowNs()) {}
+    ~ProfileScope() { RecordProfileSpan(stage, start, ProfileNowNs()); }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    ProfileStage stage;
+    uint64_t start;
+};
+
+#if MT_ENABLE_PROFILING
+  #define MT_PROFILE_JOIN2(a, b) a##b
+  #define MT_PROFILE_JOIN(a, b)  MT_PROFILE_JOIN2(a, b)
+  #define MT_PROFILE_SCOPE(stage)            ProfileScope MT_PROFILE_JOIN(profileScope_, __LINE__)(stage)
+  #define MT_PROFILE_COUNTER(counter, value) RecordProfileCounter(counter, value)
+  #define MT_PROFILE_COLLECT()               CollectProfile()
+#else
+  #define MT_PROFILE_SCOPE(stage)            ((void)0)
+  #define MT_PROFILE_COUNTER(counter, value) ((void)0)
+  #define MT_PROFILE_COLLECT()               ((void)0)
+#endif
+
+// Log-linear histogram of non-negative integers (durations in ns,
+// counter values): exact below 16, then 16 buckets per power of two.
+struct ProfileHistogram {
+    uint64_t counts[PROFILE_HISTOGRAM_BUCKETS];
+    uint64_t total;
+    uint64_t min, max;
+    double   sum;
+
+    void Reset();
+    void Record(uint64_t value);
+    uint64_t Percentile(double pct) const; // Lowest value of the bucket holding it
+    double Mean() const { return total ? sum / total : 0.0; }
+};
+
+// Consumer (one thread at a time). Events that were overwritten before
+// being collected are counted as lost.
+void CollectProfile();
+void SetProfileTraceCapture(bool capture); // Off by default
+void ResetProfile();                       // Histograms, capture and lost count
+const ProfileHistogram& GetStageHistogram(ProfileStage stage);
+const ProfileHistogram& GetCounterHistogram(ProfileCounter counter);
+uint64_t GetProfileEventsLost();
+
+// Exports of what has been collected; false if the file cannot be written
+bool WriteProfileCsv(const char* path);   // One row per stage and counter
+bool WriteChromeTrace(const char* path);  // chrome://tracing, Perfetto
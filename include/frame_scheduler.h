@@ -0,0 +1,59 @@
+// include/frame_scheduler.h
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Decides when the simulation thread produces the next frame: once per
+// frame interval while anything is on screen, and not at all after the
+// last particle has expired and an empty frame has been presented.
+// Cursor input (or shutdown) wakes it up again.
+
+// Time source and blocking primitives the scheduler runs on. Front ends
+// use GetSteadySchedulerClock; tests can drive a fake clock instead.
+struct SchedulerClock {
+    double (*now)(void* context);                     // Seconds, monotonic
+    void   (*sleepUntil)(void* context, double time); // Frame pacing
+    void   (*waitForWake)(void* context);             // Blocks until wake (latched: returns at once if one is pending)
+    void   (*wake)(void* context);                    // Any thread
+    void* context;
+};
+
+// std::chrono::steady_clock plus a condition variable
+SchedulerClock GetSteadySchedulerClock();
+
+struct SchedulerStats {
+    uint64_t idleEntries; // Times rendering was suspended
+    uint64_t wakeUps;     // Times it resumed
+    double   idleSince;   // Clock time of the last idle entry
+    double   wokeAt;      // Clock time of the last resume
+};
+
+struct FrameScheduler {
+    FrameScheduler(const SchedulerClock& clock, double frameInterval);
+
+    // Simulation thread. WaitForNextFrame blocks until the next frame is
+    // due and returns true if rendering was suspended in between (frame
+    // timing should restart). FrameProduced reports each frame; "empty"
+    // means no particle is alive and the frame drew nothing.
+    bool WaitForNextFrame();
+    void FrameProduced(uint64_t sequence, bool empty);
+
+    // Any thread
+    void FramePresented(uint64_t sequence);
+    void Wake();                 // Cursor moved, or shutting down
+    bool IsIdle() const { return idle.load(); }
+    SchedulerStats GetStats() const { return stats; } // Simulation thread
+
+    SchedulerClock clock;
+    double frameInterval;
+
+private:
+    double nextFrame;
+    uint64_t emptySince;               // First frame of the current run of empty frames (0 = none)
+    uint64_t inputAtFrame;             // inputCount when the current frame started
+    std::atomic<uint64_t> presented;   // Highest presented sequence
+    std::atomic<uint64_t> inputCount;  // Wake() calls so far
+    std::atomic<bool> idle;
+    SchedulerStats stats;
+};
@@ -0,0 +1,45 @@
+// include/overlay_surface.h
+#pragma once
+
+#include <cstdint>
+#include "core_types.h"
+
+// Decides where the overlay's surface goes each frame. Covering the
+// whole desktop makes memory and present cost grow with the desktop;
+// fitted to the trail, both grow with the effect instead. The surface
+// follows the trail by moving (cheap: a new window position) and is
+// resized, which means new DIBs, only when the trail outgrows it or has
+// needed far less of it for a while.
+
+#define SURFACE_PARTICLE_REACH 64   // Pixels a particle may draw away from its position
+#define SURFACE_GROWTH         1.5f // Size allocated relative to what is needed
+#define SURFACE_ALIGN          64   // Sizes are multiples of this
+#define SURFACE_SHRINK_RATIO   4    // Shrink once less than 1/4 of the area is needed...
+#define SURFACE_SHRINK_FRAMES  120  // ...for this many frames in a row
+
+struct SurfaceStats {
+    uint64_t resizes; // Size changes (surfaces reallocated)
+    uint64_t moves;   // Position changes at the same size
+};
+
+struct OverlaySurface {
+    explicit OverlaySurface(bool fitToTrail = true);
+
+    // "desktop" is the virtual screen in global coordinates
+    void Reset(const Rect& desktop);
+    void SetFitToTrail(bool fit); // False: always the whole desktop
+
+    // The surface for a frame whose particles lie within "bounds"
+    // (global positions, see GetParticleBounds; empty = none), as a
+    // desktop rectangle. Without particles the surface stays put.
+    Rect Place(const Rect& bounds);
+    Rect Current() const { return current; }
+
+    SurfaceStats stats;
+
+private:
+    Rect desktop;
+    Rect current;
+    bool fitToTrail;
+    int  smallFrames; // Consecutive frames below the shrink ratio
+};
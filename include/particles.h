@@ -2,10 +2,14 @@
 #pragma once
 
 #include <vector>
-#include <windows.h>
+#include <utility>
 #include <chrono>
+#include <cstdint>
+#include "core_types.h"
+#include "dirty_region.h"
+#include "cursor_input.h"
 
-#define MAX_PARTICLES 5000 
+#define MAX_PARTICLES 5000 // Default per-effect budget (pool capacity)
 
 enum class ParticleType {
     HEARTS = 1,
@@ -16,36 +20,231 @@ enum class ParticleType {
 	SWORD
 };
 
-// Particle struct
+#define PARTICLE_TYPE_COUNT 6
+
+// Index of a type's pool in g_pools (ParticleType values start at 1)
+inline int PoolIndex(ParticleType type) { return static_cast<int>(type) - 1; }
+
+// Particle struct (one-record view of a pool entry)
 struct Particle {
     float x, y;          // Position
     float vx, vy;        // Velocity
     float life;          // Remaining life (seconds)
     float maxLife;       // Maximum life (seconds)
-    COLORREF color;      // Color
+    Color color;         // Color (Get fills it in from the palette)
+    uint8_t paletteIndex; // The color's entry in the pool's palette (what Push stores)
     float angle;         // Rotation angle (radians)
     float rotationSpeed; // Rotation speed
     float scale;         // Scale
     ParticleType type;   // Which system does this particle belong to?
 };
 
+// Quantization of the pool streams (see ParticlePool)
+#define PARTICLE_LIFE_UNIT   (1.0f / 32768) // Seconds per life step: lives up to 2 s
+#define PARTICLE_SCALE_UNIT  (1.0f / 16384) // Scales up to 4
+#define PARTICLE_ANGLE_STEPS 256            // Spawn angles per turn
+#define PARTICLE_SPIN_UNIT   (1.0f / 40)    // Radians per second: up to +-3.2
+#define PARTICLE_PALETTE_SIZE 256           // Colors per effect
+
+// What a full pool does with a newly spawned particle
+enum class OverflowPolicy {
+    DROP_NEW,        // Discard the new particle
+    EVICT_OLDEST,    // Replace the particle that has lived longest
+    EVICT_LEAST_LIFE // Replace the particle closest to expiring
+};
+
+// Occupancy and overflow counters for one pool
+struct PoolStats {
+    size_t live;      // Particles currently alive
+    size_t capacity;  // Budget (preallocated slots)
+    size_t peak;      // Highest live count seen
+    size_t spawned;   // Particles accepted
+    size_t dropped;   // Spawns discarded (DROP_NEW)
+    size_t evicted;   // Live particles replaced to make room
+    size_t expired;   // Particles that reached the end of their life
+};
+
+#define SPARK_MAX_ARMS   4
+#define SPARK_MAX_POINTS 6 // Control points per arm, the start included
+
+// Spark arcs, laid out once at spawn (SparksEffect::InitShape) and only
+// jittered when drawn. Arm a runs from the particle through
+// pointCount[a] - 1 more control points, stored as pixel offsets from
+// the particle. reach bounds every offset plus the jitter.
+struct SparkArcs {
+    uint8_t armCount;
+    uint8_t reach;
+    uint8_t pointCount[SPARK_MAX_ARMS];
+    int8_t  offset[SPARK_MAX_ARMS][SPARK_MAX_POINTS - 1][2]; // x, y
+};
+
+// Fixed-capacity structure-of-arrays storage for the particles of one
+// type. Every array is allocated to the budget up front; entries
+// [0, Size()) are alive and entry i across the arrays is one particle.
+// Push and Remove are O(1) (append / swap with the last entry), so the
+// order of live entries is not preserved. Get/Push convert to and from
+// the Particle record for one-at-a-time code. Draw data that is not
+// part of the Particle record, such as sparks' arcs, lives in arrays
+// that are empty for the other types and is filled by the effect's
+// InitShape after Push.
+//
+// An entry is ENTRY_BYTES (24) over the streams, so the live set of a
+// large trail stays in L2 for update and draw. Position and velocity
+// stay float: they integrate forces every step. Everything else is
+// quantized where it is packed (Push):
+//  life      PARTICLE_LIFE_UNITs left; the update subtracts whole units
+//  lifeSpan  maxLife within the effect's [lifeMin, lifeMax] in 255 steps
+//  scale     PARTICLE_SCALE_UNITs, shrunk in place by the update
+//  spawnAngle, spin  The angle is spawnAngle + spin * age, so the
+//            update leaves it alone
+//  paletteIndex  An entry of the pool's palette, which is 256 samples
+//            of the effect's MakeColor
+// The type is the pool's. The position before the last update, for
+// drawing between two steps, is worked back from the velocity and that
+// step (PrevX/PrevY); particles pushed since then count as having
+// moved with it.
+struct ParticlePool {
+    static constexpr size_t ENTRY_BYTES = 4 * sizeof(float) + 2 * sizeof(uint16_t) + 4 * sizeof(uint8_t);
+
+    ParticleType type;
+    OverflowPolicy policy;
+    std::vector<float> x, y;
+    std::vector<float> vx, vy;
+    std::vector<uint16_t> life;
+    std::vector<uint8_t> lifeSpan;
+    std::vector<uint16_t> scale;
+    std::vector<uint8_t> spawnAngle;
+    std::vector<int8_t> spin;
+    std::vector<uint8_t> paletteIndex;
+    std::vector<SparkArcs> arcs; // SPARKS only
+    Color palette[PARTICLE_PALETTE_SIZE];
+    float lifeMin, lifeStep;     // lifeSpan decoding
+    float stepDt, stepGravityDv; // The last update (0 before any)
+    size_t count;
+    size_t limit;
+    PoolStats stats;
+
+    ParticlePool(ParticleType type, size_t capacity);
+
+    size_t Size() const { return count; }
+    size_t Capacity() const { return x.size(); }
+    size_t Limit() const { return limit; } // Live entries allowed, at most Capacity()
+    bool Push(const Particle& p);   // Packs; false if dropped by the overflow policy
+    Particle Get(size_t i) const;   // Unpacks
+
+    // Batch spawning: makes room for up to n entries under the overflow
+    // policy (one eviction pass for all of them) and appends them,
+    // returning how many from *first on; the caller Stores every one.
+    size_t Reserve(size_t n, size_t* first);
+    void Store(size_t i, const Particle& p); // Packs into entry i
+    void Remove(size_t i);
+    void RemoveExpired();
+    void Clear();
+    void SetCapacity(size_t capacity); // Reallocates; drops everything
+    void SetLimit(size_t limit);       // Overflow handling starts here; no reallocation
+
+    float Life(size_t i) const { return life[i] * PARTICLE_LIFE_UNIT; }
+    float MaxLife(size_t i) const { return lifeMin + lifeSpan[i] * lifeStep; }
+    float PrevX(size_t i) const { return x[i] - vx[i] * stepDt; }
+    float PrevY(size_t i) const { return y[i] - (vy[i] - stepGravityDv) * stepDt; }
+
+private:
+    void MoveEntry(size_t from, size_t to);
+    void EvictBatch(size_t incoming);
+    std::vector<std::pair<float, uint32_t>> evictScratch;
+};
+
+// Caller-owned 32-bit premultiplied ARGB surface the particles are drawn into.
+// Particle positions are global (desktop) coordinates; originX/Y is the
+// global coordinate of pixel (0,0), e.g. the virtual-screen offset.
+struct Framebuffer {
+    uint32_t* pixels;
+    int width;
+    int height;
+    int originX;
+    int originY;
+};
+
+// A surface frames rotate through (see frame_pipeline.h), with the
+// pixels written by the frame it currently holds so the next frame
+// drawn into it only has to clear those.
+struct FrameTarget {
+    Framebuffer fb;
+    DirtyRegion drawn; // Empty for a zero-filled surface
+};
+
+// Supplies the current cursor position in global coordinates.
+// Returns false if no position is available this frame.
+typedef bool (*CursorSourceFn)(Point* pt);
+
 // Globals
-extern std::vector<Particle> g_particles;
+extern ParticlePool g_pools[PARTICLE_TYPE_COUNT];
 extern ParticleType g_activeParticleSystem;
-extern POINT g_lastMousePos;
+extern Point g_lastMousePos;
 extern std::chrono::steady_clock::time_point g_lastFrameTime;
+extern Framebuffer g_framebuffer;
+
+// Front-end hooks
+//  SetFramebuffer expects a cleared (all-zero) surface, e.g. a fresh DIB.
+void SetFramebuffer(const Framebuffer& fb);
+void SetCursorSource(CursorSourceFn source);
 
-// Particle system functions
-void SpawnParticlesOnMouseMove();  // decides which spawn function to call
-void SpawnHeartsOnMouseMove();
-void SpawnStarsOnMouseMove();
-void SpawnFireOnMouseMove();
-void SpawnSparksOnMouseMove();
-void SpawnSmokeOnMouseMove();
-void SpawnSwordOnMouseMove();
+// Timestamped input (cursor_input.h). With a queue set, spawning walks
+// every queued cursor event instead of sampling the cursor source, and
+// particles emitted along the way are aged by how long ago the cursor
+// passed their point. SpawnParticlesUntil consumes the events up to
+// "time" (an InputTimestamp), normally the end of the step about to run.
+void SetCursorEventQueue(CursorEventQueue* queue); // nullptr: sample the source
+CursorEventQueue* GetCursorEventQueue();
+void SpawnParticlesUntil(double time);
+
+// Particle system functions (each effect's behavior is its policy in
+// effect_policies.h)
+void SpawnParticlesOnMouseMove();  // Spawns for the active effect
 
 void UpdateParticles(float dt);
 void DrawParticlesToDIB();
 
+// Draws into "target" instead of g_framebuffer (which it replaces) and
+// updates target.drawn. Positions are interpolated between the previous
+// and the current update: alpha 0 draws PrevX/PrevY, 1 draws x/y.
+// g_dirtyRegion is left alone; what changes on screen depends on which
+// frame the front end presented last.
+void DrawParticlesToTarget(FrameTarget& target, float alpha);
+
+// Threads used by DrawParticlesToDIB (1 = calling thread only, 0 = one
+// per hardware thread). Frames are pixel-identical for any count.
+void SetDrawThreadCount(int count);
+int GetDrawThreadCount();
+
+inline ParticlePool& GetPool(ParticleType type) { return g_pools[PoolIndex(type)]; }
+
+// Budgets and overflow handling (not to be called mid-frame)
+void SetParticleBudget(ParticleType type, size_t budget);
+void SetOverflowPolicy(ParticleType type, OverflowPolicy policy);
+void SetOverflowPolicy(OverflowPolicy policy);  // All types
+PoolStats GetPoolStats(ParticleType type);
+void ResetPoolStats();
+
+// Level of detail (frame_governor.h), in (0, 1]: below 1, trails spawn
+// sparser, fire draws fewer flames, sparks fewer arms, smoke smaller
+// puffs, and each pool holds that share of its budget.
+void SetDetailLevel(float detail);
+float GetDetailLevel();
+
+size_t GetLiveParticleCount();
+// Bounding box of every live particle's position before and after the
+// last update (global coordinates, right/bottom exclusive), i.e. of
+// where the next frame can draw them at any alpha. Empty if none.
+Rect GetParticleBounds();
+void ClearParticles();             // Drops all particles and forgets the last cursor position
+
+// Dirty-region tracking
+//  g_dirtyRegion holds the pixels changed by the last DrawParticlesToDIB
+//  (this frame's bounds unioned with last frame's), for front ends that
+//  present a single framebuffer.
+extern DirtyRegion g_dirtyRegion;
+void ResetDirtyTracking(); // Called by SetFramebuffer
+
 // Let external code select the particle system
 void SetActiveParticleSystem(int systemId);
@@ -0,0 +1,47 @@
+// include/raster.h
+#pragma once
+
+#include <cstdint>
+#include "core_types.h"
+
+// Fixed-point scan conversion into horizontal spans. Vertices are in
+// 1/16 pixel with the center of pixel (x, y) at (16x, 16y), so integer
+// pixel positions convert exactly and primitives can be placed between
+// pixels. A pixel belongs to a triangle if its center lies inside, or
+// on a top or left edge (the top-left rule used by Direct3D and
+// OpenGL): triangles sharing an edge cover every pixel along it exactly
+// once. All edge math is exact integer arithmetic, so coverage does not
+// depend on float rounding.
+
+#define RASTER_SUBPIXEL_BITS 4
+#define RASTER_ONE           (1 << RASTER_SUBPIXEL_BITS)
+
+struct RasterVertex {
+    int32_t x, y; // 1/16 pixel
+};
+
+inline RasterVertex RasterPixel(int x, int y)
+{
+    return RasterVertex{ x * RASTER_ONE, y * RASTER_ONE };
+}
+
+// Receives pixels [x0, x1) of row y, x0 < x1, already clipped
+typedef void (*RasterSpanFn)(int y, int x0, int x1, void* context);
+
+// Emits the triangle's spans top to bottom, clipped to "clip" (rows
+// and columns outside it are skipped, not walked). Either winding
+// works; zero-area triangles (collinear or coincident vertices) cover
+// nothing. Coordinates must stay within +-2^26 / 16 pixels.
+void RasterizeTriangle(RasterVertex a, RasterVertex b, RasterVertex c,
+                       const Rect& clip, RasterSpanFn emit, void* context);
+
+// Sets the pixels of the segment between the centers of pixels
+// (x0, y0) and (x1, y1), both included, to "color": one pixel per
+// column if it is at least as wide as tall, else one per row, each the
+// nearest to the exact line (halfway cases round toward the end with
+// the larger major coordinate, so the segment looks the same drawn in
+// either direction). The visible part is found before stepping, so
+// segments far outside "clip" cost nothing; pixels outside it are not
+// touched.
+void FillLine(uint32_t* pixels, int stride, int x0, int y0, int x1, int y1,
+              const Rect& clip, uint32_t color);
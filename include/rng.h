@@ -0,0 +1,105 @@
+// include/rng.h
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+//------------------------------------------------------------------
+// Rng
+//  xoshiro128** generator: 16 bytes of state, a handful of ALU ops per
+//  draw, and independent streams from the same seed. Replaces rand(),
+//  which is slow, global and not reproducible across platforms.
+//------------------------------------------------------------------
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 0, uint64_t stream = 0) { Seed(seed, stream); }
+
+    // Expands (seed, stream) into the state with splitmix64, so nearby
+    // seeds and stream ids still give uncorrelated sequences.
+    void Seed(uint64_t seed, uint64_t stream = 0)
+    {
+        uint64_t z = seed ^ (stream * 0xD1B54A32D192ED03ull);
+        for (int i = 0; i < 4; i += 2) {
+            uint64_t v = SplitMix64(z);
+            s[i]     = static_cast<uint32_t>(v);
+            s[i + 1] = static_cast<uint32_t>(v >> 32);
+        }
+        if ((s[0] | s[1] | s[2] | s[3]) == 0) s[0] = 1; // All-zero state is a fixed point
+    }
+
+    uint32_t NextU32()
+    {
+        const uint32_t result = Rotl(s[1] * 5, 7) * 9;
+        const uint32_t t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = Rotl(s[3], 11);
+        return result;
+    }
+
+    // Uniform integer in [0, n) (multiply-shift, no modulo)
+    int NextInt(int n)
+    {
+        return static_cast<int>((static_cast<uint64_t>(NextU32()) * static_cast<uint32_t>(n)) >> 32);
+    }
+
+    // Uniform float in [0, 1) from the top 24 bits
+    float NextFloat()
+    {
+        return (NextU32() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Uniform float in [lo, hi)
+    float Range(float lo, float hi)
+    {
+        return lo + NextFloat() * (hi - lo);
+    }
+
+    // Batch fill: uniform floats in [lo, hi)
+    void FillFloats(float* out, size_t count, float lo, float hi)
+    {
+        const float span = (hi - lo) * (1.0f / 16777216.0f);
+        for (size_t i = 0; i < count; i++) {
+            out[i] = lo + (NextU32() >> 8) * span;
+        }
+    }
+
+    // Batch fill: uniform integers in [lo, hi)
+    void FillInts(int* out, size_t count, int lo, int hi)
+    {
+        const uint32_t span = static_cast<uint32_t>(hi - lo);
+        for (size_t i = 0; i < count; i++) {
+            out[i] = lo + static_cast<int>((static_cast<uint64_t>(NextU32()) * span) >> 32);
+        }
+    }
+
+private:
+    static uint32_t Rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+    static uint64_t SplitMix64(uint64_t& state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    uint32_t s[4];
+};
+
+// Seeds every per-thread stream. Each thread's stream is derived from
+// the seed and the order in which threads first drew a number, so a
+// run with a fixed seed is bit-reproducible.
+void SeedParticleRng(uint64_t seed);
+
+// The calling thread's stream (reseeded lazily after SeedParticleRng).
+Rng& ThreadRng();
+
+// Which stream of the seed the calling thread draws from. A replay
+// (session_record.h) pins its thread to the recording thread's stream,
+// whatever order its threads started in.
+uint32_t GetThreadRngStream();
+void SetThreadRngStream(uint32_t stream);
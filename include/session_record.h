@@ -0,0 +1,115 @@
+// include/session_record.h
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "core_types.h"
+#include "particles.h"
+
+// Cursor sessions: everything the particle engine was fed, call by call,
+// so a replay reproduces every frame bit for bit. While recording, the
+// engine reports each input as it consumes it: the cursor events (or
+// per-spawn cursor samples) each spawn walked, spawn and update steps,
+// effect switches, budgets, overflow policies, the level of detail and
+// every frame drawn. Recorded sessions serve as benchmark workloads and
+// golden-image tests (tools/replay.cpp).
+//
+// File: the header, then records of one type byte and a payload.
+// Integers are LEB128 varints, signed ones zigzag-encoded. Times and
+// cursor positions are stored as the change since the previous record
+// that had one: positions in whole pixels, times in nanoseconds, which
+// is what steady_clock timestamps are made of, so a 1 kHz mouse costs
+// about seven bytes per report. The engine compares and subtracts
+// times, so they must come back exactly: one that is not a whole
+// number of nanoseconds (a step boundary, say) also stores how many
+// units in the last place it lies from that. Floats (step lengths,
+// alphas, detail levels) are stored bit for bit.
+
+#define SESSION_MAGIC   0x4E53544Du // "MTSN"
+#define SESSION_VERSION 1
+#define SESSION_WRITE_BUFFER (64 * 1024) // Bytes buffered before writing
+#define SESSION_MAX_DESKTOP  16384     // Pixels per side a session may cover
+#define SESSION_MAX_BUDGET   (1 << 24) // Largest BUDGET amount read back
+
+enum class SessionRecordType : uint8_t {
+    CURSOR_EVENT = 1, // time, x, y: a queued event a spawn walked
+    CURSOR_SAMPLE,    // x, y: the cursor source's answer to a spawn
+    NO_CURSOR,        // The cursor source had no position
+    SPAWN,            // time: SpawnParticlesUntil(time)
+    UPDATE,           // value: UpdateParticles(dt)
+    DRAW,             // value: a frame drawn at this alpha
+    EFFECT,           // id: SetActiveParticleSystem
+    DETAIL,           // value: SetDetailLevel
+    BUDGET,           // id (ParticleType), amount: SetParticleBudget
+    POLICY,           // id (ParticleType), amount (OverflowPolicy): SetOverflowPolicy
+    CLEAR             // ClearParticles
+};
+
+struct SessionHeader {
+    uint64_t seed;        // SeedParticleRng at the start
+    uint32_t rngStream;   // Recording thread's stream (GetThreadRngStream)
+    bool     queuedInput; // Cursor events, or samples from a cursor source
+    Rect     desktop;     // Global coordinates the frames cover
+    double   timeBase;    // InputTimestamp when recording started
+};
+
+struct SessionRecord {
+    SessionRecordType type;
+    double   time;   // CURSOR_EVENT, SPAWN (InputTimestamp)
+    int      x, y;   // CURSOR_EVENT, CURSOR_SAMPLE
+    float    value;  // UPDATE, DRAW, DETAIL
+    int      id;     // EFFECT, BUDGET, POLICY
+    uint64_t amount; // BUDGET, POLICY
+};
+
+// Starts recording to "path": writes the header and the engine's
+// current effect, detail level, budgets and policies, then clears the
+// particles and reseeds the RNG with "seed", which is where a replay
+// starts too. Call on the thread that runs the engine; it is the only
+// one that may call into it until StopSessionRecording. Positions are
+// recorded in whole pixels, so sessions are exact for pixel cursors
+// (anything a mouse reports).
+bool StartSessionRecording(const char* path, const Rect& desktop, uint64_t seed);
+// Flushes and closes the file; false if anything failed to write
+bool StopSessionRecording();
+bool IsRecordingSession();
+
+// Engine hooks (particles.cpp, particle_draw.cpp); no-ops unless recording
+void RecordSession(const SessionRecord& record);
+void RecordSession(SessionRecordType type);
+void RecordSession(SessionRecordType type, float value);
+void RecordSession(SessionRecordType type, int id, uint64_t amount = 0);
+
+struct SessionReader {
+    // Reads the whole file; false if it cannot be read, is not a
+    // session of this version or covers an empty, inverted or oversized
+    // desktop (see Error)
+    bool Open(const char* path);
+    const SessionHeader& Header() const { return header; }
+    // The next record; false at the end or at a malformed record,
+    // including BUDGET/POLICY ids, budgets and policies out of range
+    bool Next(SessionRecord* record);
+    const char* Error() const { return error; }
+    size_t Size() const { return data.size(); }
+
+private:
+    bool ReadVarint(uint64_t* value);
+    bool ReadSigned(int64_t* value);
+    bool ReadFloat(float* value);
+    bool ReadDouble(double* value);
+
+    std::vector<uint8_t> data;
+    size_t pos = 0;
+    SessionHeader header = {};
+    int64_t lastTime = 0; // Nanoseconds
+    int lastX = 0, lastY = 0;
+    const char* error = nullptr;
+};
+
+// Order-independent hash of a drawn frame: every non-zero pixel with
+// its global position, found within target.drawn (everything else is
+// cleared). The same pixels give the same hash however the frame was
+// split into rectangles, tiles or threads, so a rasterizer change can
+// be checked against recorded frames.
+uint64_t FrameChecksum(const FrameTarget& target);
@@ -0,0 +1,61 @@
+// include/sprite_cache.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "core_types.h"
+
+// Pre-rasterized particle shapes. Hearts, stars and swords only differ
+// by scale and rotation, so each (shape, scale, angle) is rasterized
+// once at a quantized scale/angle and then blitted.
+
+enum class SpriteShape {
+    HEART,
+    STAR,
+    SWORD
+};
+
+#define SPRITE_SCALE_STEPS 16                 // Quantization steps per 1.0 of scale
+#define SPRITE_ANGLE_STEPS 64                 // Quantization steps per full turn
+#define SPRITE_CACHE_DEFAULT_BYTES (4 << 20)  // Default memory budget
+
+// One rasterized shape. Pixels are palette indices (0 = transparent);
+// every opaque pixel of a tinted sprite takes the particle's color.
+// (offsetX, offsetY) is the position of pixel (0,0) relative to the
+// particle's position.
+struct Sprite {
+    int width;
+    int height;
+    int offsetX;
+    int offsetY;
+    bool tinted;
+    const uint32_t* palette; // ARGB, as written to the framebuffer
+    std::vector<uint8_t> pixels;
+};
+
+struct SpriteCacheStats {
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t entries;     // Sprites currently cached
+    size_t bytes;       // Memory held by cached sprites
+    size_t budgetBytes;
+};
+
+// Returns the sprite for the shape at the nearest quantized scale and
+// angle, rasterizing it on a miss. The reference stays valid until the
+// next BeginSpriteFrame/ClearSpriteCache call. Not thread-safe; the
+// returned sprites may be read from any thread.
+const Sprite& GetSprite(SpriteShape shape, float scale, float angle);
+
+// Starts a new frame: sprites used only by earlier frames become
+// eligible for eviction again.
+void BeginSpriteFrame();
+
+// Least recently used sprites are evicted once the budget is exceeded.
+void SetSpriteCacheBudget(size_t bytes);
+void ClearSpriteCache();
+
+SpriteCacheStats GetSpriteCacheStats();
+void ResetSpriteCacheStats(); // Clears hits/misses/evictions only
@@ -0,0 +1,23 @@
+// include/thread_pool.h
+#pragma once
+
+#include <cstddef>
+
+// Small work-stealing thread pool for data-parallel loops. Every
+// participating thread starts with a contiguous slice of the index
+// range and, once it runs dry, steals half of another thread's
+// remaining slice. The calling thread takes part as worker 0.
+
+#define MAX_WORKER_THREADS 64
+
+// Loop body: called once for every index
+typedef void (*ParallelTaskFn)(size_t index, void* context);
+
+// Total threads taking part in ParallelFor, including the caller.
+// 1 runs everything inline; 0 picks one per hardware thread.
+void SetWorkerThreadCount(int count);
+int  GetWorkerThreadCount();
+
+// Runs task(i, context) for every i in [0, count) and returns once all
+// calls have finished. Not reentrant.
+void ParallelFor(size_t count, ParallelTaskFn task, void* context);
@@ -0,0 +1,46 @@
+// include/update_kernels.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "cpu_features.h"
+
+// Pointers into one pool's arrays; all have "count" entries. Life and
+// scale are fixed point (ParticlePool in particles.h): life counts down
+// in whole PARTICLE_LIFE_UNITs, stopping at 0, and the scale is rounded
+// to the nearest unit after shrinking.
+struct UpdateStreams {
+    float* x;
+    float* y;
+    float* vx;
+    float* vy;
+    uint16_t* life;
+    uint16_t* scale;
+    const uint8_t* lifeSpan; // maxLife = lifeMin + lifeSpan * lifeStep
+    const float* driftX;     // Optional per-particle vx nudge (nullptr for none)
+    size_t count;
+};
+
+// Per-pool forces and life decoding. Every lane runs the same
+// instruction sequence.
+struct UpdateParams {
+    float dt;
+    float vxScale;     // vx *= vxScale before moving
+    float vyScale;     // vy *= vyScale before moving
+    float preAccel;    // vy += preAccel * dt before moving
+    float gravity;     // vy += gravity * dt after moving
+    float lifeMin;     // The pool's lifeSpan decoding
+    float lifeStep;
+};
+
+// Integrates one pool with the kernel selected at startup.
+void RunUpdateKernel(const UpdateStreams& s, const UpdateParams& params);
+
+// Reference implementation; the SIMD kernels match it within float
+// rounding (a scale may round to the neighbouring unit).
+void UpdateKernelScalar(const UpdateStreams& s, const UpdateParams& params);
+
+// Forces a specific kernel (e.g. for benchmarking). Returns false and
+// keeps the current kernel if the level is not supported here.
+bool SetUpdateKernelLevel(SimdLevel level);
+SimdLevel GetUpdateKernelLevel();
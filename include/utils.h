@@ -1,6 +1,7 @@
 // include/utils.h
 #pragma once
-#include <windows.h>
+#include "core_types.h"
+#include "rng.h"
 
 // A simple random color generator for hearts
-COLORREF RandomHeartColor();
+Color RandomHeartColor(Rng& rng);
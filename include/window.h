@@ -2,23 +2,51 @@
 #pragma once
 
 #include <windows.h>
+#include <atomic>
+#include "frame_pipeline.h"
 
 // Global variables (defined in window.cpp)
 extern HWND g_hWnd;
 extern HINSTANCE g_hInstance;
 extern int g_ScreenWidth;
 extern int g_ScreenHeight;
-extern void* g_pPixels;
 extern int g_VirtualOffsetX;
 extern int g_VirtualOffsetY;
 
+// Particle system picked from the tray menu (1-6, 0 = no change yet);
+// the simulation thread applies it between steps.
+extern std::atomic<int> g_requestedParticleSystem;
+
+// Overlay fitted to the trail instead of covering the desktop (tray
+// menu); read by the simulation thread each frame.
+extern std::atomic<bool> g_fitOverlayToTrail;
+
+// Wind, turbulence and a repulsor at the cursor (force_field.h) on
+// (tray menu); read by the simulation thread each frame.
+extern std::atomic<bool> g_forceField;
+
+// Called on the UI thread for raw mouse input (moves and buttons), also
+// while another window has focus.
+extern void (*g_onMouseInput)();
+
 // Functions
 bool CreateOverlayWindow(int nCmdShow);
 bool SetupWindow(int nCmdShow);
 LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
-void CreateDIB(int width, int height);
-void UpdateOverlay(HWND hWnd);
+// One zero-filled DIB section per frame slot covering "area" (global
+// coordinates); the slots' framebuffers point at their bits.
+bool CreateFrameDIBs(const Rect& area, FrameSlot slots[FRAME_SLOT_COUNT]);
+// Replaces the DIB of one slot, which the caller must own (e.g. the
+// producer's back slot), with a zero-filled one covering "area".
+bool CreateFrameDIB(int index, const Rect& area, FrameSlot& slot);
+// Presents the DIB of "slot" at the position and size of "fb"; only
+// "dirty" is copied to the window (pass the whole surface after a
+// resize; a move keeps the window's contents).
+void UpdateOverlay(HWND hWnd, int slot, const Framebuffer& fb, const DirtyRegion& dirty);
+
+// Routes raw mouse input to the window (WM_INPUT) for g_onMouseInput
+bool RegisterMouseInput(HWND hWnd);
 
 // System Tray Functions
 void AddTrayIcon(HWND hWnd);
@@ -34,3 +62,5 @@ void ShowContextMenu(HWND hWnd, POINT pt);
 #define ID_TRAY_PARTICLE_4  1005  // Sparks
 #define ID_TRAY_PARTICLE_5  1006  // Hearts
 #define ID_TRAY_PARTICLE_6  1007  // Sword
+#define ID_TRAY_FIT_OVERLAY 1008  // Toggles g_fitOverlayToTrail
+#define ID_TRAY_FORCE_FIELD 1009  // Toggles g_forceField
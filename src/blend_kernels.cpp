@@ -0,0 +1,247 @@
+// src/blend_kernels.cpp
+//
+// Premultiplied source-over span kernels. Pixels are widened to 16-bit
+// channels, so x * y / 255 can use the exact (t + (t >> 8)) >> 8
+// rounding in every lane; the remainder of a span goes through the
+// scalar kernel.
+
+#include "blend_kernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define MT_HAVE_X86_KERNELS 1
+  #include <immintrin.h>
+  #if defined(__GNUC__) || defined(__clang__)
+    #define MT_TARGET_AVX2 __attribute__((target("avx2")))
+  #else
+    #define MT_TARGET_AVX2
+  #endif
+#endif
+
+//------------------------------------------------------------------
+// Scalar kernels (reference and tail handling)
+//------------------------------------------------------------------
+static inline uint32_t ScaleARGB(uint32_t c, uint32_t s)
+{
+    return (MulDiv255(c >> 24, s) << 24) |
+           (MulDiv255((c >> 16) & 0xFF, s) << 16) |
+           (MulDiv255((c >> 8) & 0xFF, s) << 8) |
+           MulDiv255(c & 0xFF, s);
+}
+
+// Channels cannot carry: src <= src.alpha per channel, so the sum stays <= 255
+static inline uint32_t Over(uint32_t src, uint32_t dst)
+{
+    return src + ScaleARGB(dst, 255 - (src >> 24));
+}
+
+static void BlendSolidScalar(uint32_t* dst, int count, uint32_t src)
+{
+    if ((src >> 24) == 0xFF) {
+        for (int i = 0; i < count; i++) dst[i] = src;
+        return;
+    }
+    for (int i = 0; i < count; i++) dst[i] = Over(src, dst[i]);
+}
+
+static void BlendCoverageScalar(uint32_t* dst, const uint8_t* coverage, int count, uint32_t src)
+{
+    for (int i = 0; i < count; i++) {
+        if (coverage[i] == 0) continue;
+        dst[i] = Over(ScaleARGB(src, coverage[i]), dst[i]);
+    }
+}
+
+#if defined(MT_HAVE_X86_KERNELS)
+//------------------------------------------------------------------
+// SSE2 kernels (4 pixels)
+//------------------------------------------------------------------
+static inline __m128i MulDiv255SSE2(__m128i x, __m128i y)
+{
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, y), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// 255 - alpha, broadcast over the four channels of each pixel
+static inline __m128i InvAlphaSSE2(__m128i px16)
+{
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px16, 0xFF), 0xFF);
+    return _mm_sub_epi16(_mm_set1_epi16(255), a);
+}
+
+// src16 over dst16 (two pixels, 16-bit channels)
+static inline __m128i OverSSE2(__m128i src16, __m128i dst16)
+{
+    return _mm_add_epi16(src16, MulDiv255SSE2(dst16, InvAlphaSSE2(src16)));
+}
+
+static void BlendSolidSSE2(uint32_t* dst, int count, uint32_t src)
+{
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i src16 = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(src)), zero);
+    const __m128i inv   = InvAlphaSSE2(src16);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i d  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i lo = _mm_add_epi16(src16, MulDiv255SSE2(_mm_unpacklo_epi8(d, zero), inv));
+        __m128i hi = _mm_add_epi16(src16, MulDiv255SSE2(_mm_unpackhi_epi8(d, zero), inv));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    BlendSolidScalar(dst + i, count - i, src);
+}
+
+static void BlendCoverageSSE2(uint32_t* dst, const uint8_t* coverage, int count, uint32_t src)
+{
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i src16 = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(src)), zero);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // Coverage byte of each pixel repeated in all four channels
+        int packed = coverage[i] | (coverage[i + 1] << 8) | (coverage[i + 2] << 16) | (coverage[i + 3] << 24);
+        if (packed == 0) continue;
+        __m128i c = _mm_cvtsi32_si128(packed);
+        c = _mm_unpacklo_epi8(c, c);
+        c = _mm_unpacklo_epi16(c, c);
+
+        __m128i d  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i lo = OverSSE2(MulDiv255SSE2(src16, _mm_unpacklo_epi8(c, zero)), _mm_unpacklo_epi8(d, zero));
+        __m128i hi = OverSSE2(MulDiv255SSE2(src16, _mm_unpackhi_epi8(c, zero)), _mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    BlendCoverageScalar(dst + i, coverage + i, count - i, src);
+}
+
+//------------------------------------------------------------------
+// AVX2 kernels (8 pixels)
+//------------------------------------------------------------------
+MT_TARGET_AVX2
+static inline __m256i MulDiv255AVX2(__m256i x, __m256i y)
+{
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(x, y), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+MT_TARGET_AVX2
+static inline __m256i InvAlphaAVX2(__m256i px16)
+{
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(px16, 0xFF), 0xFF);
+    return _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+}
+
+MT_TARGET_AVX2
+static inline __m256i OverAVX2(__m256i src16, __m256i dst16)
+{
+    return _mm256_add_epi16(src16, MulDiv255AVX2(dst16, InvAlphaAVX2(src16)));
+}
+
+MT_TARGET_AVX2
+static void BlendSolidAVX2(uint32_t* dst, int count, uint32_t src)
+{
+    const __m256i zero  = _mm256_setzero_si256();
+    const __m256i src16 = _mm256_unpacklo_epi8(_mm256_set1_epi32(static_cast<int>(src)), zero);
+    const __m256i inv   = InvAlphaAVX2(src16);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i d  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i lo = _mm256_add_epi16(src16, MulDiv255AVX2(_mm256_unpacklo_epi8(d, zero), inv));
+        __m256i hi = _mm256_add_epi16(src16, MulDiv255AVX2(_mm256_unpackhi_epi8(d, zero), inv));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    // The tail is a tail call that skips the compiler's vzeroupper;
+    // dirty upper halves would stall the caller's SSE code.
+    _mm256_zeroupper();
+    BlendSolidScalar(dst + i, count - i, src);
+}
+
+MT_TARGET_AVX2
+static void BlendCoverageAVX2(uint32_t* dst, const uint8_t* coverage, int count, uint32_t src)
+{
+    const __m256i zero  = _mm256_setzero_si256();
+    const __m256i src16 = _mm256_unpacklo_epi8(_mm256_set1_epi32(static_cast<int>(src)), zero);
+    // Repeats byte 0 of every 32-bit lane into the whole lane
+    const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12,
+                                            0, 0, 0, 0, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i c8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(coverage + i));
+        if (_mm_testz_si128(c8, c8)) continue;
+        __m256i c = _mm256_shuffle_epi8(_mm256_cvtepu8_epi32(c8), spread);
+
+        __m256i d  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i lo = OverAVX2(MulDiv255AVX2(src16, _mm256_unpacklo_epi8(c, zero)), _mm256_unpacklo_epi8(d, zero));
+        __m256i hi = OverAVX2(MulDiv255AVX2(src16, _mm256_unpackhi_epi8(c, zero)), _mm256_unpackhi_epi8(d, zero));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    _mm256_zeroupper();
+    BlendCoverageScalar(dst + i, coverage + i, count - i, src);
+}
+#endif // MT_HAVE_X86_KERNELS
+
+//------------------------------------------------------------------
+// Dispatch
+//------------------------------------------------------------------
+typedef void (*BlendSolidFn)(uint32_t* dst, int count, uint32_t src);
+typedef void (*BlendCoverageFn)(uint32_t* dst, const uint8_t* coverage, int count, uint32_t src);
+
+struct BlendKernels {
+    BlendSolidFn solid;
+    BlendCoverageFn coverage;
+};
+
+static BlendKernels KernelsForLevel(SimdLevel level)
+{
+    switch (level) {
+#if defined(MT_HAVE_X86_KERNELS)
+        case SimdLevel::AVX2: return { BlendSolidAVX2, BlendCoverageAVX2 };
+        case SimdLevel::SSE2: return { BlendSolidSSE2, BlendCoverageSSE2 };
+#endif
+        default:              return { BlendSolidScalar, BlendCoverageScalar };
+    }
+}
+
+// Kernels missing from this build (e.g. NEON) fall back to scalar.
+static SimdLevel EffectiveLevel(SimdLevel level)
+{
+    return KernelsForLevel(level).solid == BlendSolidScalar ? SimdLevel::SCALAR : level;
+}
+
+// AVX2 is not picked by default. Spans are short (fire rows are mostly
+// under 8 px, smoke rows a few dozen), so the wider lanes rarely fill,
+// and whole frames drew slower with them: on 1920x1080, about 800
+// particles, SSE2 / AVX2 took 1250 / 1320 us for smoke and 780 / 1040 us
+// for fire (medians of 7 runs). headless --blend times both per pixel.
+// SetBlendKernelLevel can still select AVX2.
+static SimdLevel DefaultLevel()
+{
+    const SimdLevel level = EffectiveLevel(DetectSimdLevel());
+    return level == SimdLevel::AVX2 ? SimdLevel::SSE2 : level;
+}
+
+static SimdLevel    s_kernelLevel = DefaultLevel();
+static BlendKernels s_kernels     = KernelsForLevel(s_kernelLevel);
+
+void BlendSpanSolid(uint32_t* dst, int count, uint32_t src)
+{
+    s_kernels.solid(dst, count, src);
+}
+
+void BlendSpanCoverage(uint32_t* dst, const uint8_t* coverage, int count, uint32_t src)
+{
+    s_kernels.coverage(dst, coverage, count, src);
+}
+
+bool SetBlendKernelLevel(SimdLevel level)
+{
+    if (!IsSimdLevelSupported(level)) return false;
+    s_kernelLevel = EffectiveLevel(level);
+    s_kernels     = KernelsForLevel(s_kernelLevel);
+    return s_kernelLevel == level;
+}
+
+SimdLevel GetBlendKernelLevel()
+{
+    return s_kernelLevel;
+}
@@ -0,0 +1,80 @@
+// src/cpu_features.cpp
+#include "cpu_features.h"
+
+#if defined(_M_X64) || defined(_M_IX86)
+  #include <intrin.h>      // __cpuid, __cpuidex, _xgetbv
+  #define MT_X86_MSVC 1
+#elif defined(__x86_64__) || defined(__i386__)
+  #define MT_X86_GNU 1
+#endif
+
+//------------------------------------------------------------------
+// QuerySimdLevel
+//------------------------------------------------------------------
+static SimdLevel QuerySimdLevel()
+{
+#if defined(MT_X86_MSVC)
+    int info[4] = {};
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool sse2    = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx     = (info[2] & (1 << 28)) != 0;
+
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && avx) {
+        // The OS must save YMM state across context switches.
+        bool ymmEnabled = (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        avx2 = ymmEnabled && (info[1] & (1 << 5)) != 0;
+    }
+
+    if (avx2) return SimdLevel::AVX2;
+    if (sse2) return SimdLevel::SSE2;
+    return SimdLevel::SCALAR;
+#elif defined(MT_X86_GNU)
+    // libgcc's model also checks XCR0, so this covers OS support too.
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+    return SimdLevel::SCALAR;
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    return SimdLevel::NEON;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+//------------------------------------------------------------------
+// DetectSimdLevel
+//------------------------------------------------------------------
+SimdLevel DetectSimdLevel()
+{
+    static const SimdLevel s_level = QuerySimdLevel();
+    return s_level;
+}
+
+bool IsSimdLevelSupported(SimdLevel level)
+{
+    SimdLevel best = DetectSimdLevel();
+    switch (level) {
+        case SimdLevel::SCALAR: return true;
+        case SimdLevel::SSE2:   return best == SimdLevel::SSE2 || best == SimdLevel::AVX2;
+        case SimdLevel::AVX2:   return best == SimdLevel::AVX2;
+        case SimdLevel::NEON:   return best == SimdLevel::NEON;
+    }
+    return false;
+}
+
+const char* SimdLevelName(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::SCALAR: return "scalar";
+        case SimdLevel::SSE2:   return "sse2";
+        case SimdLevel::AVX2:   return "avx2";
+        case SimdLevel::NEON:   return "neon";
+    }
+    return "unknown";
+}
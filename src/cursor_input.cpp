@@ -0,0 +1,172 @@
+// src/cursor_input.cpp
+#include "cursor_input.h"
+#include <algorithm>
+#include <cmath>
+
+//------------------------------------------------------------------
+// CursorEventQueue
+//  head and tail count events ever popped/pushed and wrap naturally;
+//  the release store of one side publishes its slot to the other.
+//------------------------------------------------------------------
+#define CURSOR_QUEUE_MASK (CURSOR_QUEUE_CAPACITY - 1)
+
+CursorEventQueue::CursorEventQueue()
+    : head(0), tail(0), dropped(0)
+{
+}
+
+bool CursorEventQueue::Push(const CursorEvent& e)
+{
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) >= CURSOR_QUEUE_CAPACITY) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    events[t & CURSOR_QUEUE_MASK] = e;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+bool CursorEventQueue::PopUntil(double time, CursorEvent* e)
+{
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) return false;
+    const CursorEvent& oldest = events[h & CURSOR_QUEUE_MASK];
+    if (oldest.time > time) return false;
+    *e = oldest;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+void CursorEventQueue::Clear()
+{
+    head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+//------------------------------------------------------------------
+// FlattenCursorPath
+//------------------------------------------------------------------
+
+// Cursor velocity at event k from its neighbours (one-sided at the ends)
+static void EventVelocity(const CursorEvent* events, size_t lo, size_t count, size_t k,
+                          float* vx, float* vy)
+{
+    size_t a = (k > lo) ? k - 1 : k;
+    size_t b = (k + 1 < count) ? k + 1 : k;
+    double dt = events[b].time - events[a].time;
+    if (a == b || dt <= 0.0) {
+        *vx = *vy = 0.f;
+        return;
+    }
+    *vx = static_cast<float>((events[b].x - events[a].x) / dt);
+    *vy = static_cast<float>((events[b].y - events[a].y) / dt);
+}
+
+static void AddPathVertex(CursorPath& path, float x, float y, double time)
+{
+    CursorPathVertex v;
+    v.x = x;
+    v.y = y;
+    v.time = time;
+    v.length = 0.f;
+    if (!path.vertices.empty()) {
+        const CursorPathVertex& prev = path.vertices.back();
+        float dx = x - prev.x;
+        float dy = y - prev.y;
+        v.length = prev.length + std::sqrt(dx * dx + dy * dy);
+    }
+    path.vertices.push_back(v);
+}
+
+void FlattenCursorPath(const CursorEvent* events, size_t count, size_t first, CursorPath& path)
+{
+    path.vertices.clear();
+    if (first >= count) return;
+
+    const size_t lo = (first > 0) ? first - 1 : 0;
+    AddPathVertex(path, events[first].x, events[first].y, events[first].time);
+
+    for (size_t k = first; k + 1 < count; k++) {
+        const CursorEvent& p0 = events[k];
+        const CursorEvent& p1 = events[k + 1];
+        const double h = p1.time - p0.time;
+
+        // Without timing there is no velocity to follow: straight line
+        float dx = p1.x - p0.x;
+        float dy = p1.y - p0.y;
+        int splits = 1;
+        if (h > 0.0) {
+            splits = static_cast<int>(std::sqrt(dx * dx + dy * dy) / CURSOR_PATH_STEP_PX);
+            splits = std::min(std::max(splits, 1), CURSOR_PATH_MAX_SPLIT);
+        }
+        if (splits == 1) {
+            AddPathVertex(path, p1.x, p1.y, p1.time);
+            continue;
+        }
+
+        float v0x, v0y, v1x, v1y;
+        EventVelocity(events, lo, count, k, &v0x, &v0y);
+        EventVelocity(events, lo, count, k + 1, &v1x, &v1y);
+        const float hf = static_cast<float>(h);
+        for (int j = 1; j <= splits; j++) {
+            float u  = j / static_cast<float>(splits);
+            float u2 = u * u;
+            float u3 = u2 * u;
+            float h00 = 2.f * u3 - 3.f * u2 + 1.f;
+            float h10 = u3 - 2.f * u2 + u;
+            float h01 = -2.f * u3 + 3.f * u2;
+            float h11 = u3 - u2;
+            float x = h00 * p0.x + h10 * hf * v0x + h01 * p1.x + h11 * hf * v1x;
+            float y = h00 * p0.y + h10 * hf * v0y + h01 * p1.y + h11 * hf * v1y;
+            AddPathVertex(path, x, y, p0.time + u * h);
+        }
+    }
+}
+
+//------------------------------------------------------------------
+// ContinueCursorPath
+//------------------------------------------------------------------
+bool ContinueCursorPath(CursorPathJoin& join, const std::vector<CursorEvent>& events, CursorPath& path)
+{
+    const size_t count = events.size();
+    if (count <= static_cast<size_t>(join.count)) return false;
+
+    FlattenCursorPath(events.data(), count, (join.count == 2) ? 1 : 0, path);
+    join.count = static_cast<int>(std::min<size_t>(2, count));
+    for (int i = 0; i < join.count; i++) {
+        join.events[i] = events[count - join.count + i];
+    }
+    return path.vertices.size() >= 2;
+}
+
+//------------------------------------------------------------------
+// CursorPath::PointAt
+//------------------------------------------------------------------
+CursorPathVertex CursorPath::PointAt(float t) const
+{
+    if (vertices.size() < 2) {
+        return vertices.empty() ? CursorPathVertex() : vertices[0];
+    }
+
+    // A single segment is interpolated by "t" itself, which is exactly
+    // what the per-frame straight-line spawning did.
+    const CursorPathVertex* a = &vertices[0];
+    const CursorPathVertex* b = &vertices[1];
+    float u = t;
+    if (vertices.size() > 2) {
+        float s = t * Length();
+        auto it = std::upper_bound(vertices.begin() + 1, vertices.end() - 1, s,
+                                   [](float len, const CursorPathVertex& v) { return len < v.length; });
+        b = &*it;
+        a = b - 1;
+        float span = b->length - a->length;
+        u = (span > 0.f) ? (s - a->length) / span : 0.f;
+    }
+
+    CursorPathVertex p;
+    p.x = a->x + u * (b->x - a->x);
+    p.y = a->y + u * (b->y - a->y);
+    p.time = a->time + u * (b->time - a->time);
+    p.length = a->length + u * (b->length - a->length);
+    return p;
+}
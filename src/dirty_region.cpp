@@ -0,0 +1,141 @@
+// src/dirty_region.cpp
+#include "dirty_region.h"
+#include <algorithm>   // For std::min, std::max
+
+FrameStats g_frameStats = {};
+
+//------------------------------------------------------------------
+// Rectangle helpers
+//------------------------------------------------------------------
+bool IsEmptyRect(const Rect& rc)
+{
+    return rc.right <= rc.left || rc.bottom <= rc.top;
+}
+
+Rect ClipRectToSurface(const Rect& rc, int width, int height)
+{
+    Rect clipped;
+    clipped.left   = std::max(rc.left, 0);
+    clipped.top    = std::max(rc.top, 0);
+    clipped.right  = std::min(rc.right, width);
+    clipped.bottom = std::min(rc.bottom, height);
+    if (IsEmptyRect(clipped)) {
+        clipped.left = clipped.top = clipped.right = clipped.bottom = 0;
+    }
+    return clipped;
+}
+
+static Rect UnionRects(const Rect& a, const Rect& b)
+{
+    Rect u;
+    u.left   = std::min(a.left, b.left);
+    u.top    = std::min(a.top, b.top);
+    u.right  = std::max(a.right, b.right);
+    u.bottom = std::max(a.bottom, b.bottom);
+    return u;
+}
+
+static long long RectArea(const Rect& rc)
+{
+    return static_cast<long long>(rc.right - rc.left) * (rc.bottom - rc.top);
+}
+
+// Overlapping or edge-adjacent rectangles are merged; keeping the set
+// disjoint guarantees every pixel is cleared and presented only once.
+static bool RectsTouch(const Rect& a, const Rect& b)
+{
+    return a.left <= b.right && b.left <= a.right &&
+           a.top <= b.bottom && b.top <= a.bottom;
+}
+
+//------------------------------------------------------------------
+// ClearDirtyRegion
+//------------------------------------------------------------------
+void ClearDirtyRegion(DirtyRegion& region)
+{
+    region.count = 0;
+}
+
+//------------------------------------------------------------------
+// AddDirtyRect
+//  Unions the rectangle into the set, merging with any rectangle it
+//  touches. When the set is full, the rectangle whose area grows the
+//  least absorbs the new one.
+//------------------------------------------------------------------
+void AddDirtyRect(DirtyRegion& region, const Rect& rc)
+{
+    if (IsEmptyRect(rc)) return;
+
+    Rect pending = rc;
+    for (;;) {
+        bool merged = false;
+        for (int i = 0; i < region.count; i++) {
+            if (RectsTouch(region.rects[i], pending)) {
+                pending = UnionRects(region.rects[i], pending);
+                region.rects[i] = region.rects[--region.count];
+                merged = true;
+                break;
+            }
+        }
+        if (merged) continue;
+
+        if (region.count < MAX_DIRTY_RECTS) {
+            region.rects[region.count++] = pending;
+            return;
+        }
+
+        // Full: fold into the rectangle that grows the least, then
+        // re-run the merge pass since the union may now touch others.
+        int best = 0;
+        long long bestGrowth = -1;
+        for (int i = 0; i < region.count; i++) {
+            Rect u = UnionRects(region.rects[i], pending);
+            long long growth = RectArea(u) - RectArea(region.rects[i]);
+            if (bestGrowth < 0 || growth < bestGrowth) {
+                bestGrowth = growth;
+                best = i;
+            }
+        }
+        pending = UnionRects(region.rects[best], pending);
+        region.rects[best] = region.rects[--region.count];
+    }
+}
+
+//------------------------------------------------------------------
+// AddDirtyRegion
+//------------------------------------------------------------------
+void AddDirtyRegion(DirtyRegion& region, const DirtyRegion& other)
+{
+    for (int i = 0; i < other.count; i++) {
+        AddDirtyRect(region, other.rects[i]);
+    }
+}
+
+//------------------------------------------------------------------
+// GetDirtyBounds
+//  Bounding box of the whole set (empty rect if nothing is dirty)
+//------------------------------------------------------------------
+Rect GetDirtyBounds(const DirtyRegion& region)
+{
+    Rect bounds = { 0, 0, 0, 0 };
+    if (region.count == 0) return bounds;
+
+    bounds = region.rects[0];
+    for (int i = 1; i < region.count; i++) {
+        bounds = UnionRects(bounds, region.rects[i]);
+    }
+    return bounds;
+}
+
+//------------------------------------------------------------------
+// GetDirtyArea
+//  Total pixel count (rectangles are kept disjoint)
+//------------------------------------------------------------------
+size_t GetDirtyArea(const DirtyRegion& region)
+{
+    size_t area = 0;
+    for (int i = 0; i < region.count; i++) {
+        area += static_cast<size_t>(RectArea(region.rects[i]));
+    }
+    return area;
+}
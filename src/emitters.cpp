@@ -0,0 +1,238 @@
+// src/emitters.cpp
+#include "emitters.h"
+#include "effect_policies.h"
+#include "cursor_input.h"
+#include "frame_profiler.h"
+#include "rng.h"
+#include <algorithm>
+#include <vector>
+
+// An id is the emitter's slot plus how many emitters the slot has held
+#define EMITTER_SLOT_BITS 10
+#define EMITTER_SLOT_MASK ((1u << EMITTER_SLOT_BITS) - 1)
+static_assert(MAX_EMITTERS <= (1 << EMITTER_SLOT_BITS), "emitter slots must fit the id");
+
+#define EMITTER_RNG_STREAM 0x454D4954u // Apart from the threads' streams (rng.h)
+
+struct Emitter {
+    EmitterId id = 0;
+    uint32_t effects = 0;
+    Rng rng;
+    std::vector<CursorEvent> moves; // Not spawned yet, oldest first
+    CursorPathJoin join = {};       // Where the last spawn's path ended
+    CursorPath path;                // This spawn's stretch
+    bool hasPath = false;
+    // AT_CURSOR effects: travel since their last particle, per pool
+    float spawnTravel[PARTICLE_TYPE_COUNT] = {};
+    double lastSpawnTime[PARTICLE_TYPE_COUNT] = {};
+};
+
+// Live emitters, packed (swap-remove) so a batch walks them in order
+static std::vector<Emitter> s_emitters;
+static uint32_t s_emitterIndex[MAX_EMITTERS];      // Slot -> index in s_emitters
+static uint32_t s_slotGeneration[MAX_EMITTERS];   // Bumped when the slot is freed
+static std::vector<uint32_t> s_freeSlots;
+static bool s_slotsInitialized = false;
+
+static std::vector<CursorEvent> s_pathEvents; // Scratch: join + moves of one emitter
+static std::vector<uint32_t> s_spawnCounts;   // Scratch: per emitter, for one effect
+
+static Emitter* FindEmitter(EmitterId id)
+{
+    const uint32_t slot = id & EMITTER_SLOT_MASK;
+    if (slot >= MAX_EMITTERS || (id >> EMITTER_SLOT_BITS) != s_slotGeneration[slot]) return nullptr;
+    const uint32_t index = s_emitterIndex[slot];
+    return (index < s_emitters.size() && s_emitters[index].id == id) ? &s_emitters[index] : nullptr;
+}
+
+//---------------------------------------------------
+// CreateEmitter / DestroyEmitter
+//---------------------------------------------------
+EmitterId CreateEmitter(uint32_t effects, uint64_t seed)
+{
+    if (!s_slotsInitialized) {
+        // Lowest slots first; generation 0 would make slot 0's first id 0
+        for (uint32_t slot = MAX_EMITTERS; slot-- > 0;) {
+            s_freeSlots.push_back(slot);
+            s_slotGeneration[slot] = 1;
+        }
+        s_emitters.reserve(MAX_EMITTERS);
+        s_slotsInitialized = true;
+    }
+    if (s_freeSlots.empty()) return 0;
+
+    const uint32_t slot = s_freeSlots.back();
+    s_freeSlots.pop_back();
+
+    Emitter e;
+    e.id = (s_slotGeneration[slot] << EMITTER_SLOT_BITS) | slot;
+    e.effects = effects & ALL_EFFECT_BITS;
+    e.rng.Seed(seed, EMITTER_RNG_STREAM);
+    s_emitterIndex[slot] = static_cast<uint32_t>(s_emitters.size());
+    s_emitters.push_back(std::move(e));
+    return s_emitters.back().id;
+}
+
+void DestroyEmitter(EmitterId id)
+{
+    Emitter* e = FindEmitter(id);
+    if (!e) return;
+
+    const uint32_t slot = id & EMITTER_SLOT_MASK;
+    const uint32_t index = s_emitterIndex[slot];
+    if (index + 1 != s_emitters.size()) {
+        s_emitters[index] = std::move(s_emitters.back());
+        s_emitterIndex[s_emitters[index].id & EMITTER_SLOT_MASK] = index;
+    }
+    s_emitters.pop_back();
+
+    // Stale ids miss from now on
+    uint32_t generation = (s_slotGeneration[slot] + 1) & (~0u >> EMITTER_SLOT_BITS);
+    s_slotGeneration[slot] = (generation == 0) ? 1 : generation;
+    s_freeSlots.push_back(slot);
+}
+
+void DestroyAllEmitters()
+{
+    while (!s_emitters.empty()) {
+        DestroyEmitter(s_emitters.back().id);
+    }
+}
+
+size_t GetEmitterCount()
+{
+    return s_emitters.size();
+}
+
+bool SetEmitterEffects(EmitterId id, uint32_t effects)
+{
+    Emitter* e = FindEmitter(id);
+    if (!e) return false;
+    e->effects = effects & ALL_EFFECT_BITS;
+    return true;
+}
+
+bool MoveEmitter(EmitterId id, float x, float y, double time)
+{
+    Emitter* e = FindEmitter(id);
+    if (!e) return false;
+    CursorEvent move;
+    move.time = time;
+    move.x = x;
+    move.y = y;
+    e->moves.push_back(move);
+    return true;
+}
+
+//---------------------------------------------------
+// GatherEmitterPath
+//  Flattens the emitter's moves up to "time" into its path, joined to
+//  where the previous spawn left off (see GatherCursorPath).
+//---------------------------------------------------
+static bool GatherEmitterPath(Emitter& e, double time)
+{
+    size_t used = 0;
+    while (used < e.moves.size() && e.moves[used].time <= time) used++;
+    if (used == 0) return false;
+
+    s_pathEvents.assign(e.join.events, e.join.events + e.join.count);
+    s_pathEvents.insert(s_pathEvents.end(), e.moves.begin(), e.moves.begin() + used);
+    e.moves.erase(e.moves.begin(), e.moves.begin() + used);
+    return ContinueCursorPath(e.join, s_pathEvents, e.path);
+}
+
+// Seconds since the emitter passed "point", as far as this spawn is concerned
+static float EmitterSpawnAge(const CursorPathVertex& point, double time)
+{
+    float age = static_cast<float>(time - point.time);
+    return std::min(std::max(age, 0.f), MAX_SPAWN_AGE_SECONDS);
+}
+
+//---------------------------------------------------
+// Per-effect batch
+//  CountSpawns decides how many particles one emitter spawns (and
+//  advances its AT_CURSOR state); FillSpawns writes the first "n" of
+//  them into pool entries [first, first + n), as the cursor trail's
+//  SpawnAlongPath / SpawnAtCursor would spawn them.
+//---------------------------------------------------
+template <class Effect>
+static uint32_t CountSpawns(Emitter& e, float detail)
+{
+    const float dist = e.path.Length();
+    if constexpr (Effect::SPAWN == SpawnPattern::AT_CURSOR) {
+        // Added up over spawns, as for queued cursor input
+        const int pool = PoolIndex(Effect::TYPE);
+        e.spawnTravel[pool] += dist;
+        const double endTime = e.path.vertices.back().time;
+        if (endTime - e.lastSpawnTime[pool] < Effect::SPAWN_INTERVAL) return 0;
+        const float travel = e.spawnTravel[pool];
+        e.spawnTravel[pool] = 0.f;
+        e.lastSpawnTime[pool] = endTime;
+        return (travel > Effect::MIN_TRAVEL) ? 1 : 0;
+    } else {
+        if (dist <= 0.f) return 0;
+        // Sparser at lower detail
+        const float spacing = Effect::SPAWN_SPACING / detail;
+        return static_cast<uint32_t>(std::max(1, static_cast<int>(dist / spacing)));
+    }
+}
+
+template <class Effect>
+static void FillSpawns(Emitter& e, ParticlePool& pool, size_t first, uint32_t n, uint32_t planned, double time)
+{
+    if constexpr (Effect::SPAWN == SpawnPattern::AT_CURSOR) {
+        (void)planned;
+        const CursorPathVertex& end = e.path.vertices.back();
+        for (uint32_t k = 0; k < n; k++) {
+            pool.Store(first + k, SpawnAtCursorParticle<Effect>(end.x, end.y, EmitterSpawnAge(end, time), e.rng));
+            Effect::InitShape(pool, first + k, e.rng);
+        }
+    } else {
+        for (uint32_t k = 0; k < n; k++) {
+            float t = (k + 1) / static_cast<float>(planned + 1);
+            CursorPathVertex at = e.path.PointAt(t);
+            pool.Store(first + k, SpawnAlongPathParticle<Effect>(at.x, at.y, EmitterSpawnAge(at, time), e.rng));
+            Effect::InitShape(pool, first + k, e.rng);
+        }
+    }
+}
+
+template <class Effect>
+static void SpawnEmitterBatch(double time, float detail)
+{
+    const uint32_t bit = EffectBit(Effect::TYPE);
+    size_t total = 0;
+    for (size_t k = 0; k < s_emitters.size(); k++) {
+        Emitter& e = s_emitters[k];
+        s_spawnCounts[k] = (e.hasPath && (e.effects & bit)) ? CountSpawns<Effect>(e, detail) : 0;
+        total += s_spawnCounts[k];
+    }
+    if (total == 0) return;
+
+    // One reservation for the whole batch; what the overflow policy
+    // turns away is dropped from the last emitters
+    ParticlePool& pool = GetPool(Effect::TYPE);
+    size_t next;
+    size_t room = pool.Reserve(total, &next);
+    for (size_t k = 0; k < s_emitters.size() && room > 0; k++) {
+        const uint32_t n = static_cast<uint32_t>(std::min<size_t>(s_spawnCounts[k], room));
+        if (n == 0) continue;
+        FillSpawns<Effect>(s_emitters[k], pool, next, n, s_spawnCounts[k], time);
+        next += n;
+        room -= n;
+    }
+}
+
+//---------------------------------------------------
+// SpawnEmitters
+//---------------------------------------------------
+void SpawnEmitters(double time)
+{
+    MT_PROFILE_SCOPE(ProfileStage::SPAWN);
+    for (Emitter& e : s_emitters) {
+        e.hasPath = GatherEmitterPath(e, time);
+    }
+    s_spawnCounts.resize(s_emitters.size());
+    const float detail = GetDetailLevel();
+    Effects::ForEach([time, detail](auto effect) { SpawnEmitterBatch<decltype(effect)>(time, detail); });
+}
@@ -0,0 +1,168 @@
+// src/falloff_kernels.cpp
+#include "falloff_kernels.h"
+#include "rng.h"
+#include <cmath>
+#include <algorithm>
+#include <deque>
+
+//---------------------------------------------------
+// Falloff kernels
+//---------------------------------------------------
+static std::deque<FalloffKernel> s_kernels; // Growing a deque keeps references valid
+
+static void BuildFalloffKernel(int radius, FalloffKernel& kernel)
+{
+    const int size = 2 * radius + 1;
+    kernel.radius = radius;
+    kernel.alpha.assign(static_cast<size_t>(size) * size, 0);
+    kernel.spanStart.assign(size, 0);
+    kernel.spanEnd.assign(size, 0);
+
+    for (int j = 0; j < size; j++) {
+        int dy = j - radius;
+        int start = size, end = 0;
+        for (int i = 0; i < size; i++) {
+            int dx = i - radius;
+            float dist = sqrtf(static_cast<float>(dx * dx + dy * dy));
+            if (dist > radius) continue;
+
+            // Squared falloff for a smoother edge (a single-pixel puff has no falloff to show)
+            float a = (radius > 0) ? 1.0f - dist / radius : 0.0f;
+            kernel.alpha[j * size + i] = static_cast<uint16_t>(a * a * FALLOFF_ONE + 0.5f);
+            start = std::min(start, i);
+            end = i + 1;
+        }
+        kernel.spanStart[j] = std::min(start, end);
+        kernel.spanEnd[j] = end;
+    }
+}
+
+const FalloffKernel& GetFalloffKernel(int radius)
+{
+    radius = std::max(radius, 0);
+    if (radius >= static_cast<int>(s_kernels.size())) {
+        size_t first = s_kernels.size();
+        s_kernels.resize(radius + 1);
+        for (size_t r = first; r < s_kernels.size(); r++) {
+            BuildFalloffKernel(static_cast<int>(r), s_kernels[r]);
+        }
+    }
+    return s_kernels[radius];
+}
+
+//---------------------------------------------------
+// Blue noise (void-and-cluster)
+//  Every pixel gets a rank by how "void" its neighbourhood is on a
+//  torus, so the texture tiles seamlessly and thresholds at any level
+//  give evenly spread, clump-free points.
+//---------------------------------------------------
+#define BLUE_NOISE_AREA (BLUE_NOISE_SIZE * BLUE_NOISE_SIZE)
+
+static const float BLUE_NOISE_SIGMA = 1.5f;
+
+// Gaussian energy contribution of a point at toroidal offset (dx, dy)
+static void BuildEnergyFilter(std::vector<float>& filter)
+{
+    filter.resize(BLUE_NOISE_AREA);
+    for (int y = 0; y < BLUE_NOISE_SIZE; y++) {
+        for (int x = 0; x < BLUE_NOISE_SIZE; x++) {
+            int dx = std::min(x, BLUE_NOISE_SIZE - x);
+            int dy = std::min(y, BLUE_NOISE_SIZE - y);
+            filter[y * BLUE_NOISE_SIZE + x] =
+                expf(-(dx * dx + dy * dy) / (2.0f * BLUE_NOISE_SIGMA * BLUE_NOISE_SIGMA));
+        }
+    }
+}
+
+static void Splat(std::vector<float>& energy, const std::vector<float>& filter, int pos, float sign)
+{
+    const int px = pos % BLUE_NOISE_SIZE;
+    const int py = pos / BLUE_NOISE_SIZE;
+    for (int y = 0; y < BLUE_NOISE_SIZE; y++) {
+        const float* row = filter.data() + ((y - py) & (BLUE_NOISE_SIZE - 1)) * BLUE_NOISE_SIZE;
+        float* out = energy.data() + y * BLUE_NOISE_SIZE;
+        for (int x = 0; x < BLUE_NOISE_SIZE; x++) {
+            out[x] += sign * row[(x - px) & (BLUE_NOISE_SIZE - 1)];
+        }
+    }
+}
+
+// Highest-energy set pixel (tightest cluster) or lowest-energy empty
+// pixel (largest void)
+static int FindExtreme(const std::vector<float>& energy, const std::vector<uint8_t>& set,
+                       bool wantSet)
+{
+    int best = -1;
+    for (int i = 0; i < BLUE_NOISE_AREA; i++) {
+        if ((set[i] != 0) != wantSet) continue;
+        if (best < 0 || (wantSet ? energy[i] > energy[best] : energy[i] < energy[best])) best = i;
+    }
+    return best;
+}
+
+static void BuildBlueNoise(uint8_t* out)
+{
+    std::vector<float> filter;
+    BuildEnergyFilter(filter);
+
+    // Initial pattern: 10% random points, relaxed by moving the tightest
+    // cluster into the largest void until that stops changing anything
+    // (capped, in case it ends up cycling).
+    Rng rng(0x5eed);
+    std::vector<uint8_t> set(BLUE_NOISE_AREA, 0);
+    std::vector<float> energy(BLUE_NOISE_AREA, 0.0f);
+    const int initial = BLUE_NOISE_AREA / 10;
+    for (int placed = 0; placed < initial; ) {
+        int pos = rng.NextInt(BLUE_NOISE_AREA);
+        if (set[pos]) continue;
+        set[pos] = 1;
+        Splat(energy, filter, pos, 1.0f);
+        placed++;
+    }
+    for (int pass = 0; pass < BLUE_NOISE_AREA; pass++) {
+        int cluster = FindExtreme(energy, set, true);
+        set[cluster] = 0;
+        Splat(energy, filter, cluster, -1.0f);
+        int voidPos = FindExtreme(energy, set, false);
+        set[voidPos] = 1;
+        Splat(energy, filter, voidPos, 1.0f);
+        if (voidPos == cluster) break;
+    }
+
+    std::vector<int> rank(BLUE_NOISE_AREA, 0);
+
+    // Ranks below the initial pattern: peel off tightest clusters
+    {
+        std::vector<uint8_t> peel = set;
+        std::vector<float> peelEnergy = energy;
+        for (int r = initial - 1; r >= 0; r--) {
+            int cluster = FindExtreme(peelEnergy, peel, true);
+            peel[cluster] = 0;
+            Splat(peelEnergy, filter, cluster, -1.0f);
+            rank[cluster] = r;
+        }
+    }
+
+    // Ranks above it: keep filling the largest void
+    for (int r = initial; r < BLUE_NOISE_AREA; r++) {
+        int voidPos = FindExtreme(energy, set, false);
+        set[voidPos] = 1;
+        Splat(energy, filter, voidPos, 1.0f);
+        rank[voidPos] = r;
+    }
+
+    for (int i = 0; i < BLUE_NOISE_AREA; i++) {
+        out[i] = static_cast<uint8_t>(rank[i] * 256 / BLUE_NOISE_AREA);
+    }
+}
+
+struct BlueNoiseTexture {
+    uint8_t texels[BLUE_NOISE_AREA];
+    BlueNoiseTexture() { BuildBlueNoise(texels); }
+};
+
+const uint8_t* GetBlueNoise()
+{
+    static const BlueNoiseTexture texture; // Thread-safe one-time build
+    return texture.texels;
+}
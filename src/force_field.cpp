@@ -0,0 +1,513 @@
+// src/force_field.cpp
+//
+// Force grid building and sampling. The grid holds one acceleration per
+// node, FORCE_CELL_PX apart, as two planes (ax, ay). Each row carries
+// one padding node past the last and there is one padding row, copies
+// of the edge, so a sample never has to clamp its cell index: it clamps
+// its position to the grid and the right/bottom neighbours it weights
+// by 0 at the edge are still there. The sampling kernels process 4
+// (SSE2/NEON) or 8 (AVX2, gathers) particles per instruction and finish
+// the remainder with the scalar kernel.
+
+#include "force_field.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define MT_HAVE_X86_KERNELS 1
+  #include <immintrin.h>
+  #if defined(__GNUC__) || defined(__clang__)
+    #define MT_TARGET_AVX2 __attribute__((target("avx2")))
+  #else
+    #define MT_TARGET_AVX2
+  #endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+  #define MT_HAVE_NEON_KERNELS 1
+  #include <arm_neon.h>
+#endif
+
+struct ForceGrid {
+    std::vector<float> ax, ay; // Row-major, "stride" nodes per row
+    int cols, rows;            // Nodes covering the bounds
+    int stride;                // cols + the padding node
+    float originX, originY;    // Global coordinates of node (0, 0)
+    float invCell;
+};
+
+static ForceGrid s_grid = {};
+static std::vector<float> s_potential; // Scratch: turbulence noise per node
+
+static Rect s_bounds = { 0, 0, 0, 0 };
+static float s_windX = 0.f, s_windY = 0.f;
+static float s_turbulence = 0.f, s_turbulenceFeature = 1.f, s_turbulenceRate = 0.f;
+static ForcePoint s_points[FORCE_MAX_POINTS];
+static int s_pointCount = 0;
+static bool s_active = false;
+
+//---------------------------------------------------
+// Sources
+//---------------------------------------------------
+void SetForceFieldBounds(const Rect& area)
+{
+    s_bounds = area;
+}
+
+void SetWind(float ax, float ay)
+{
+    s_windX = ax;
+    s_windY = ay;
+}
+
+void SetTurbulence(float strength, float featurePx, float changePerSecond)
+{
+    s_turbulence = std::max(strength, 0.f);
+    s_turbulenceFeature = std::max(featurePx, 1.f);
+    s_turbulenceRate = changePerSecond;
+}
+
+bool AddForcePoint(const ForcePoint& point)
+{
+    if (s_pointCount >= FORCE_MAX_POINTS || !(point.radius > 0.f)) return false;
+    s_points[s_pointCount++] = point;
+    return true;
+}
+
+void ClearForcePoints()
+{
+    s_pointCount = 0;
+}
+
+void ClearForceField()
+{
+    SetWind(0.f, 0.f);
+    SetTurbulence(0.f, 1.f, 0.f);
+    ClearForcePoints();
+    s_active = false;
+}
+
+bool IsForceFieldActive()
+{
+    return s_active;
+}
+
+//---------------------------------------------------
+// Turbulence
+//  Value noise over a 3D lattice (x, y, time), smoothed with the
+//  quintic fade; its curl is taken on the grid.
+//---------------------------------------------------
+// Lattice value in [-1, 1)
+static float LatticeNoise(int x, int y, int z)
+{
+    uint32_t h = static_cast<uint32_t>(x) * 0x8DA6B343u ^ static_cast<uint32_t>(y) * 0xD8163841u ^
+                 static_cast<uint32_t>(z) * 0xCB1AB31Fu;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    h *= 0x297A2D39u;
+    h ^= h >> 15;
+    return (h >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+static float Fade(float t)
+{
+    return t * t * t * (t * (t * 6.f - 15.f) + 10.f);
+}
+
+static float Lerp(float a, float b, float t)
+{
+    return a + t * (b - a);
+}
+
+static float ValueNoise(float x, float y, float z)
+{
+    const float fx = std::floor(x), fy = std::floor(y), fz = std::floor(z);
+    const int ix = static_cast<int>(fx), iy = static_cast<int>(fy), iz = static_cast<int>(fz);
+    const float u = Fade(x - fx), v = Fade(y - fy), w = Fade(z - fz);
+
+    float plane[2];
+    for (int k = 0; k < 2; k++) {
+        const float top    = Lerp(LatticeNoise(ix, iy, iz + k),     LatticeNoise(ix + 1, iy, iz + k), u);
+        const float bottom = Lerp(LatticeNoise(ix, iy + 1, iz + k), LatticeNoise(ix + 1, iy + 1, iz + k), u);
+        plane[k] = Lerp(top, bottom, v);
+    }
+    return Lerp(plane[0], plane[1], w);
+}
+
+// Adds the curl of the noise potential to every node: (dP/dy, -dP/dx)
+// is divergence-free, so the swirls neither gather nor scatter
+// particles. Central differences inside, one-sided at the edges.
+static void AddTurbulence(ForceGrid& g, double time)
+{
+    const float toNoise = FORCE_CELL_PX / s_turbulenceFeature;
+    const float noiseX = g.originX / s_turbulenceFeature;
+    const float noiseY = g.originY / s_turbulenceFeature;
+    const float noiseZ = static_cast<float>(std::fmod(time * s_turbulenceRate, 4096.0));
+    s_potential.resize(static_cast<size_t>(g.cols) * g.rows);
+    for (int j = 0; j < g.rows; j++) {
+        for (int i = 0; i < g.cols; i++) {
+            s_potential[static_cast<size_t>(j) * g.cols + i] = ValueNoise(noiseX + i * toNoise, noiseY + j * toNoise, noiseZ);
+        }
+    }
+
+    // The noise changes by about 1 per feature: scaled so the
+    // accelerations come out around "strength"
+    const float gain = s_turbulence * s_turbulenceFeature / FORCE_CELL_PX;
+    for (int j = 0; j < g.rows; j++) {
+        const int up = std::max(j - 1, 0), down = std::min(j + 1, g.rows - 1);
+        for (int i = 0; i < g.cols; i++) {
+            const int left = std::max(i - 1, 0), right = std::min(i + 1, g.cols - 1);
+            const float dPdx = (s_potential[static_cast<size_t>(j) * g.cols + right] -
+                                s_potential[static_cast<size_t>(j) * g.cols + left]) / (right - left);
+            const float dPdy = (s_potential[static_cast<size_t>(down) * g.cols + i] -
+                                s_potential[static_cast<size_t>(up) * g.cols + i]) / (down - up);
+            const size_t k = static_cast<size_t>(j) * g.stride + i;
+            g.ax[k] += gain * dPdy;
+            g.ay[k] -= gain * dPdx;
+        }
+    }
+}
+
+// Adds one attractor/repulsor over the nodes within its radius
+static void AddPoint(ForceGrid& g, const ForcePoint& p)
+{
+    const float cx = (p.x - g.originX) * g.invCell;
+    const float cy = (p.y - g.originY) * g.invCell;
+    const float r = p.radius * g.invCell;
+    const int i0 = std::max(0, static_cast<int>(std::ceil(cx - r)));
+    const int i1 = std::min(g.cols - 1, static_cast<int>(std::floor(cx + r)));
+    const int j0 = std::max(0, static_cast<int>(std::ceil(cy - r)));
+    const int j1 = std::min(g.rows - 1, static_cast<int>(std::floor(cy + r)));
+    for (int j = j0; j <= j1; j++) {
+        for (int i = i0; i <= i1; i++) {
+            const float dx = cx - i, dy = cy - j;
+            const float d = std::sqrt(dx * dx + dy * dy);
+            if (d >= r || d < 1e-3f) continue;
+            // Smooth falloff, pointing at the center
+            float w = 1.f - d / r;
+            w *= w;
+            const size_t k = static_cast<size_t>(j) * g.stride + i;
+            g.ax[k] += p.strength * w * dx / d;
+            g.ay[k] += p.strength * w * dy / d;
+        }
+    }
+}
+
+//---------------------------------------------------
+// BuildForceField
+//---------------------------------------------------
+void BuildForceField(double time)
+{
+    const int width = s_bounds.right - s_bounds.left;
+    const int height = s_bounds.bottom - s_bounds.top;
+    s_active = width > 0 && height > 0 &&
+               (s_windX != 0.f || s_windY != 0.f || s_turbulence > 0.f || s_pointCount > 0);
+    if (!s_active) return;
+
+    ForceGrid& g = s_grid;
+    g.cols = width / FORCE_CELL_PX + 2; // The last node at or past the right edge
+    g.rows = height / FORCE_CELL_PX + 2;
+    g.stride = g.cols + 1;
+    g.originX = static_cast<float>(s_bounds.left);
+    g.originY = static_cast<float>(s_bounds.top);
+    g.invCell = 1.0f / FORCE_CELL_PX;
+    const size_t nodes = static_cast<size_t>(g.stride) * (g.rows + 1);
+    g.ax.assign(nodes, s_windX);
+    g.ay.assign(nodes, s_windY);
+
+    if (s_turbulence > 0.f) AddTurbulence(g, time);
+    for (int n = 0; n < s_pointCount; n++) {
+        AddPoint(g, s_points[n]);
+    }
+
+    // Padding: copies of the last column and row
+    for (int j = 0; j < g.rows; j++) {
+        const size_t last = static_cast<size_t>(j) * g.stride + g.cols - 1;
+        g.ax[last + 1] = g.ax[last];
+        g.ay[last + 1] = g.ay[last];
+    }
+    std::copy_n(g.ax.begin() + static_cast<size_t>(g.rows - 1) * g.stride, g.stride,
+                g.ax.begin() + static_cast<size_t>(g.rows) * g.stride);
+    std::copy_n(g.ay.begin() + static_cast<size_t>(g.rows - 1) * g.stride, g.stride,
+                g.ay.begin() + static_cast<size_t>(g.rows) * g.stride);
+}
+
+//------------------------------------------------------------------
+// Scalar kernel (reference and tail handling)
+//  Clamping keeps NaN positions in the grid the way the SIMD max/min
+//  do; the cell index follows from the clamped position.
+//------------------------------------------------------------------
+static void ApplyRangeScalar(const ForceGrid& g, const float* x, const float* y, float* vx, float* vy,
+                             size_t begin, size_t end, float scale)
+{
+    const float maxX = static_cast<float>(g.cols - 1);
+    const float maxY = static_cast<float>(g.rows - 1);
+    const float stride = static_cast<float>(g.stride);
+    const float* ax = g.ax.data();
+    const float* ay = g.ay.data();
+
+    for (size_t i = begin; i < end; i++) {
+        float gx = (x[i] - g.originX) * g.invCell;
+        float gy = (y[i] - g.originY) * g.invCell;
+        gx = (gx > 0.f) ? gx : 0.f;
+        gy = (gy > 0.f) ? gy : 0.f;
+        gx = (gx < maxX) ? gx : maxX;
+        gy = (gy < maxY) ? gy : maxY;
+        const float cellX = static_cast<float>(static_cast<int>(gx));
+        const float cellY = static_cast<float>(static_cast<int>(gy));
+        const float fx = gx - cellX;
+        const float fy = gy - cellY;
+        const size_t k = static_cast<size_t>(cellY * stride + cellX);
+        const size_t below = k + g.stride;
+
+        float top    = ax[k] + fx * (ax[k + 1] - ax[k]);
+        float bottom = ax[below] + fx * (ax[below + 1] - ax[below]);
+        vx[i] += (top + fy * (bottom - top)) * scale;
+        top    = ay[k] + fx * (ay[k + 1] - ay[k]);
+        bottom = ay[below] + fx * (ay[below + 1] - ay[below]);
+        vy[i] += (top + fy * (bottom - top)) * scale;
+    }
+}
+
+static void ApplyKernelScalar(const ForceGrid& g, const float* x, const float* y, float* vx, float* vy,
+                              size_t count, float scale)
+{
+    ApplyRangeScalar(g, x, y, vx, vy, 0, count, scale);
+}
+
+#if defined(MT_HAVE_X86_KERNELS)
+//------------------------------------------------------------------
+// SSE2 kernel
+//  No gathers: the four cell indices go through memory and the corners
+//  are loaded one lane at a time; the rest is 4-wide.
+//------------------------------------------------------------------
+static void ApplyKernelSSE2(const ForceGrid& g, const float* x, const float* y, float* vx, float* vy,
+                            size_t count, float scale)
+{
+    const __m128 originX = _mm_set1_ps(g.originX);
+    const __m128 originY = _mm_set1_ps(g.originY);
+    const __m128 invCell = _mm_set1_ps(g.invCell);
+    const __m128 maxX    = _mm_set1_ps(static_cast<float>(g.cols - 1));
+    const __m128 maxY    = _mm_set1_ps(static_cast<float>(g.rows - 1));
+    const __m128 stride  = _mm_set1_ps(static_cast<float>(g.stride));
+    const __m128 scaleV  = _mm_set1_ps(scale);
+    const __m128 zero    = _mm_setzero_ps();
+    const float* ax = g.ax.data();
+    const float* ay = g.ay.data();
+    const int s = g.stride;
+    alignas(16) int32_t k[4];
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 gx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(x + i), originX), invCell);
+        __m128 gy = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(y + i), originY), invCell);
+        gx = _mm_min_ps(_mm_max_ps(gx, zero), maxX);
+        gy = _mm_min_ps(_mm_max_ps(gy, zero), maxY);
+        const __m128 cellX = _mm_cvtepi32_ps(_mm_cvttps_epi32(gx));
+        const __m128 cellY = _mm_cvtepi32_ps(_mm_cvttps_epi32(gy));
+        const __m128 fx = _mm_sub_ps(gx, cellX);
+        const __m128 fy = _mm_sub_ps(gy, cellY);
+        _mm_store_si128(reinterpret_cast<__m128i*>(k),
+                        _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(cellY, stride), cellX)));
+
+        __m128 a00 = _mm_setr_ps(ax[k[0]], ax[k[1]], ax[k[2]], ax[k[3]]);
+        __m128 a10 = _mm_setr_ps(ax[k[0] + 1], ax[k[1] + 1], ax[k[2] + 1], ax[k[3] + 1]);
+        __m128 a01 = _mm_setr_ps(ax[k[0] + s], ax[k[1] + s], ax[k[2] + s], ax[k[3] + s]);
+        __m128 a11 = _mm_setr_ps(ax[k[0] + s + 1], ax[k[1] + s + 1], ax[k[2] + s + 1], ax[k[3] + s + 1]);
+        __m128 top    = _mm_add_ps(a00, _mm_mul_ps(fx, _mm_sub_ps(a10, a00)));
+        __m128 bottom = _mm_add_ps(a01, _mm_mul_ps(fx, _mm_sub_ps(a11, a01)));
+        __m128 a = _mm_add_ps(top, _mm_mul_ps(fy, _mm_sub_ps(bottom, top)));
+        _mm_storeu_ps(vx + i, _mm_add_ps(_mm_loadu_ps(vx + i), _mm_mul_ps(a, scaleV)));
+
+        a00 = _mm_setr_ps(ay[k[0]], ay[k[1]], ay[k[2]], ay[k[3]]);
+        a10 = _mm_setr_ps(ay[k[0] + 1], ay[k[1] + 1], ay[k[2] + 1], ay[k[3] + 1]);
+        a01 = _mm_setr_ps(ay[k[0] + s], ay[k[1] + s], ay[k[2] + s], ay[k[3] + s]);
+        a11 = _mm_setr_ps(ay[k[0] + s + 1], ay[k[1] + s + 1], ay[k[2] + s + 1], ay[k[3] + s + 1]);
+        top    = _mm_add_ps(a00, _mm_mul_ps(fx, _mm_sub_ps(a10, a00)));
+        bottom = _mm_add_ps(a01, _mm_mul_ps(fx, _mm_sub_ps(a11, a01)));
+        a = _mm_add_ps(top, _mm_mul_ps(fy, _mm_sub_ps(bottom, top)));
+        _mm_storeu_ps(vy + i, _mm_add_ps(_mm_loadu_ps(vy + i), _mm_mul_ps(a, scaleV)));
+    }
+    ApplyRangeScalar(g, x, y, vx, vy, i, count, scale);
+}
+
+//------------------------------------------------------------------
+// AVX2 kernel
+//------------------------------------------------------------------
+MT_TARGET_AVX2
+static void ApplyKernelAVX2(const ForceGrid& g, const float* x, const float* y, float* vx, float* vy,
+                            size_t count, float scale)
+{
+    const __m256 originX = _mm256_set1_ps(g.originX);
+    const __m256 originY = _mm256_set1_ps(g.originY);
+    const __m256 invCell = _mm256_set1_ps(g.invCell);
+    const __m256 maxX    = _mm256_set1_ps(static_cast<float>(g.cols - 1));
+    const __m256 maxY    = _mm256_set1_ps(static_cast<float>(g.rows - 1));
+    const __m256 stride  = _mm256_set1_ps(static_cast<float>(g.stride));
+    const __m256 scaleV  = _mm256_set1_ps(scale);
+    const __m256 zero    = _mm256_setzero_ps();
+    const __m256i one    = _mm256_set1_epi32(1);
+    const __m256i down   = _mm256_set1_epi32(g.stride);
+    const float* ax = g.ax.data();
+    const float* ay = g.ay.data();
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 gx = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), originX), invCell);
+        __m256 gy = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(y + i), originY), invCell);
+        gx = _mm256_min_ps(_mm256_max_ps(gx, zero), maxX);
+        gy = _mm256_min_ps(_mm256_max_ps(gy, zero), maxY);
+        const __m256 cellX = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(gx));
+        const __m256 cellY = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(gy));
+        const __m256 fx = _mm256_sub_ps(gx, cellX);
+        const __m256 fy = _mm256_sub_ps(gy, cellY);
+        const __m256i k00 = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(cellY, stride), cellX));
+        const __m256i k10 = _mm256_add_epi32(k00, one);
+        const __m256i k01 = _mm256_add_epi32(k00, down);
+        const __m256i k11 = _mm256_add_epi32(k01, one);
+
+        __m256 a00 = _mm256_i32gather_ps(ax, k00, 4);
+        __m256 a10 = _mm256_i32gather_ps(ax, k10, 4);
+        __m256 a01 = _mm256_i32gather_ps(ax, k01, 4);
+        __m256 a11 = _mm256_i32gather_ps(ax, k11, 4);
+        __m256 top    = _mm256_add_ps(a00, _mm256_mul_ps(fx, _mm256_sub_ps(a10, a00)));
+        __m256 bottom = _mm256_add_ps(a01, _mm256_mul_ps(fx, _mm256_sub_ps(a11, a01)));
+        __m256 a = _mm256_add_ps(top, _mm256_mul_ps(fy, _mm256_sub_ps(bottom, top)));
+        _mm256_storeu_ps(vx + i, _mm256_add_ps(_mm256_loadu_ps(vx + i), _mm256_mul_ps(a, scaleV)));
+
+        a00 = _mm256_i32gather_ps(ay, k00, 4);
+        a10 = _mm256_i32gather_ps(ay, k10, 4);
+        a01 = _mm256_i32gather_ps(ay, k01, 4);
+        a11 = _mm256_i32gather_ps(ay, k11, 4);
+        top    = _mm256_add_ps(a00, _mm256_mul_ps(fx, _mm256_sub_ps(a10, a00)));
+        bottom = _mm256_add_ps(a01, _mm256_mul_ps(fx, _mm256_sub_ps(a11, a01)));
+        a = _mm256_add_ps(top, _mm256_mul_ps(fy, _mm256_sub_ps(bottom, top)));
+        _mm256_storeu_ps(vy + i, _mm256_add_ps(_mm256_loadu_ps(vy + i), _mm256_mul_ps(a, scaleV)));
+    }
+    ApplyRangeScalar(g, x, y, vx, vy, i, count, scale);
+}
+#endif // MT_HAVE_X86_KERNELS
+
+#if defined(MT_HAVE_NEON_KERNELS)
+//------------------------------------------------------------------
+// NEON kernel
+//  Like SSE2: indices through memory, corners loaded per lane.
+//------------------------------------------------------------------
+static float32x4_t LoadCorners(const float* a, const int32_t* k, int offset)
+{
+    float32x4_t v = vdupq_n_f32(a[k[0] + offset]);
+    v = vsetq_lane_f32(a[k[1] + offset], v, 1);
+    v = vsetq_lane_f32(a[k[2] + offset], v, 2);
+    v = vsetq_lane_f32(a[k[3] + offset], v, 3);
+    return v;
+}
+
+static void ApplyKernelNEON(const ForceGrid& g, const float* x, const float* y, float* vx, float* vy,
+                            size_t count, float scale)
+{
+    const float32x4_t originX = vdupq_n_f32(g.originX);
+    const float32x4_t originY = vdupq_n_f32(g.originY);
+    const float32x4_t invCell = vdupq_n_f32(g.invCell);
+    const float32x4_t maxX    = vdupq_n_f32(static_cast<float>(g.cols - 1));
+    const float32x4_t maxY    = vdupq_n_f32(static_cast<float>(g.rows - 1));
+    const float32x4_t stride  = vdupq_n_f32(static_cast<float>(g.stride));
+    const float32x4_t scaleV  = vdupq_n_f32(scale);
+    const float32x4_t zero    = vdupq_n_f32(0.f);
+    const float* ax = g.ax.data();
+    const float* ay = g.ay.data();
+    const int s = g.stride;
+    int32_t k[4];
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t gx = vmulq_f32(vsubq_f32(vld1q_f32(x + i), originX), invCell);
+        float32x4_t gy = vmulq_f32(vsubq_f32(vld1q_f32(y + i), originY), invCell);
+        // vmaxnmq picks the number over a NaN, as the scalar clamp does
+        gx = vminq_f32(vmaxnmq_f32(gx, zero), maxX);
+        gy = vminq_f32(vmaxnmq_f32(gy, zero), maxY);
+        const float32x4_t cellX = vcvtq_f32_s32(vcvtq_s32_f32(gx));
+        const float32x4_t cellY = vcvtq_f32_s32(vcvtq_s32_f32(gy));
+        const float32x4_t fx = vsubq_f32(gx, cellX);
+        const float32x4_t fy = vsubq_f32(gy, cellY);
+        vst1q_s32(k, vcvtq_s32_f32(vaddq_f32(vmulq_f32(cellY, stride), cellX)));
+
+        float32x4_t a00 = LoadCorners(ax, k, 0), a10 = LoadCorners(ax, k, 1);
+        float32x4_t a01 = LoadCorners(ax, k, s), a11 = LoadCorners(ax, k, s + 1);
+        float32x4_t top    = vaddq_f32(a00, vmulq_f32(fx, vsubq_f32(a10, a00)));
+        float32x4_t bottom = vaddq_f32(a01, vmulq_f32(fx, vsubq_f32(a11, a01)));
+        float32x4_t a = vaddq_f32(top, vmulq_f32(fy, vsubq_f32(bottom, top)));
+        vst1q_f32(vx + i, vaddq_f32(vld1q_f32(vx + i), vmulq_f32(a, scaleV)));
+
+        a00 = LoadCorners(ay, k, 0);
+        a10 = LoadCorners(ay, k, 1);
+        a01 = LoadCorners(ay, k, s);
+        a11 = LoadCorners(ay, k, s + 1);
+        top    = vaddq_f32(a00, vmulq_f32(fx, vsubq_f32(a10, a00)));
+        bottom = vaddq_f32(a01, vmulq_f32(fx, vsubq_f32(a11, a01)));
+        a = vaddq_f32(top, vmulq_f32(fy, vsubq_f32(bottom, top)));
+        vst1q_f32(vy + i, vaddq_f32(vld1q_f32(vy + i), vmulq_f32(a, scaleV)));
+    }
+    ApplyRangeScalar(g, x, y, vx, vy, i, count, scale);
+}
+#endif // MT_HAVE_NEON_KERNELS
+
+//------------------------------------------------------------------
+// Dispatch
+//------------------------------------------------------------------
+typedef void (*ForceKernelFn)(const ForceGrid&, const float*, const float*, float*, float*, size_t, float);
+
+static ForceKernelFn KernelForLevel(SimdLevel level)
+{
+    switch (level) {
+#if defined(MT_HAVE_X86_KERNELS)
+        case SimdLevel::AVX2: return ApplyKernelAVX2;
+        case SimdLevel::SSE2: return ApplyKernelSSE2;
+#endif
+#if defined(MT_HAVE_NEON_KERNELS)
+        case SimdLevel::NEON: return ApplyKernelNEON;
+#endif
+        default:              return ApplyKernelScalar;
+    }
+}
+
+// Kernels missing from this build fall back to scalar.
+static SimdLevel EffectiveLevel(SimdLevel level)
+{
+    return KernelForLevel(level) == ApplyKernelScalar ? SimdLevel::SCALAR : level;
+}
+
+static SimdLevel     s_kernelLevel = EffectiveLevel(DetectSimdLevel());
+static ForceKernelFn s_kernel      = KernelForLevel(s_kernelLevel);
+
+void ApplyForceField(const float* x, const float* y, float* vx, float* vy, size_t count, float scale)
+{
+    if (s_active) s_kernel(s_grid, x, y, vx, vy, count, scale);
+}
+
+void ApplyForceFieldScalar(const float* x, const float* y, float* vx, float* vy, size_t count, float scale)
+{
+    if (s_active) ApplyKernelScalar(s_grid, x, y, vx, vy, count, scale);
+}
+
+void SampleForceField(float x, float y, float* ax, float* ay)
+{
+    *ax = 0.f;
+    *ay = 0.f;
+    ApplyForceFieldScalar(&x, &y, ax, ay, 1, 1.0f);
+}
+
+bool SetForceKernelLevel(SimdLevel level)
+{
+    if (!IsSimdLevelSupported(level)) return false;
+    s_kernelLevel = EffectiveLevel(level);
+    s_kernel      = KernelForLevel(s_kernelLevel);
+    return s_kernelLevel == level;
+}
+
+SimdLevel GetForceKernelLevel()
+{
+    return s_kernelLevel;
+}
@@ -0,0 +1,53 @@
+// src/frame_governor.cpp
+#include "frame_governor.h"
+#include <algorithm>
+
+FrameGovernor::FrameGovernor(double budgetSeconds)
+    : stats(), budget(budgetSeconds), sinceCut(0)
+{
+    Reset();
+}
+
+void FrameGovernor::SetBudget(double seconds)
+{
+    budget = seconds;
+}
+
+void FrameGovernor::Reset()
+{
+    stats = GovernorStats();
+    stats.detail = 1.0f;
+    stats.minDetail = 1.0f;
+    sinceCut = GOVERNOR_CUT_INTERVAL;
+}
+
+//------------------------------------------------------------------
+// FrameMeasured
+//  Over budget on average: cut detail in proportion to the overrun
+//  (frame cost falls roughly with detail), then wait a few frames for
+//  the average to reflect it before cutting again. Well under budget:
+//  add detail back a small step per frame, so the trail fills in
+//  without visibly popping and a recovering load is not overshot.
+//------------------------------------------------------------------
+float FrameGovernor::FrameMeasured(double seconds)
+{
+    stats.frames++;
+    if (seconds > budget) stats.budgetMisses++;
+    stats.averageSeconds = (stats.frames == 1)
+        ? seconds
+        : stats.averageSeconds + (seconds - stats.averageSeconds) * GOVERNOR_SMOOTHING;
+
+    sinceCut++;
+    if (stats.averageSeconds > budget) {
+        if (sinceCut >= GOVERNOR_CUT_INTERVAL && stats.detail > GOVERNOR_MIN_DETAIL) {
+            const float keep = std::max(GOVERNOR_MAX_CUT, static_cast<float>(budget / stats.averageSeconds));
+            stats.detail = std::max(GOVERNOR_MIN_DETAIL, stats.detail * keep);
+            stats.minDetail = std::min(stats.minDetail, stats.detail);
+            stats.cuts++;
+            sinceCut = 0;
+        }
+    } else if (stats.averageSeconds < budget * GOVERNOR_HEADROOM) {
+        stats.detail = std::min(1.0f, stats.detail + GOVERNOR_RESTORE_STEP);
+    }
+    return stats.detail;
+}
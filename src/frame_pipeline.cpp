@@ -0,0 +1,64 @@
+// src/frame_pipeline.cpp
+#include "frame_pipeline.h"
+
+//------------------------------------------------------------------
+// FrameTripleBuffer
+//  "middle" is the only shared state. Publish swaps the back slot into
+//  it with the fresh bit set; AcquireLatest swaps the front slot in
+//  (clearing the bit) only if it is set. The acq_rel exchanges order
+//  the producer's pixel writes before the consumer's reads.
+//------------------------------------------------------------------
+#define FRESH_FRAME_BIT 4u
+#define SLOT_INDEX_MASK 3u
+
+FrameTripleBuffer::FrameTripleBuffer()
+{
+    Reset();
+}
+
+void FrameTripleBuffer::Reset()
+{
+    back  = 0;
+    middle.store(1, std::memory_order_relaxed);
+    front = 2;
+}
+
+void FrameTripleBuffer::Publish()
+{
+    uint32_t old = middle.exchange(static_cast<uint32_t>(back) | FRESH_FRAME_BIT,
+                                   std::memory_order_acq_rel);
+    back = static_cast<int>(old & SLOT_INDEX_MASK);
+}
+
+bool FrameTripleBuffer::AcquireLatest()
+{
+    // Only the producer changes middle behind our back, and it always
+    // leaves the bit set, so the exchange still returns a fresh frame.
+    if (!(middle.load(std::memory_order_relaxed) & FRESH_FRAME_BIT)) return false;
+    uint32_t old = middle.exchange(static_cast<uint32_t>(front), std::memory_order_acq_rel);
+    front = static_cast<int>(old & SLOT_INDEX_MASK);
+    return true;
+}
+
+//------------------------------------------------------------------
+// FixedTimestep
+//------------------------------------------------------------------
+FixedTimestep::FixedTimestep(float step, int maxSteps)
+    : step(step), accumulator(0.f), maxSteps(maxSteps)
+{
+}
+
+int FixedTimestep::Advance(float dt)
+{
+    accumulator += dt;
+    int steps = static_cast<int>(accumulator / step);
+    if (steps > maxSteps) {
+        // Catching up after a long stall would stall the next frame too
+        steps = maxSteps;
+        accumulator = 0.f;
+        return steps;
+    }
+    accumulator -= steps * step;
+    if (accumulator < 0.f) accumulator = 0.f;
+    return steps;
+}
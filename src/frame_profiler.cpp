@@ -0,0 +1,291 @@
+// src/frame_profiler.cpp
+#include "frame_profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+static const char* STAGE_NAMES[static_cast<int>(ProfileStage::COUNT)] = {
+    "frame", "spawn", "update", "draw",
+    "draw_hearts", "draw_stars", "draw_fire", "draw_sparks", "draw_smoke", "draw_sword",
+    "present"
+};
+
+static const char* COUNTER_NAMES[static_cast<int>(ProfileCounter::COUNT)] = {
+    "live_particles", "pixels_written", "spawned", "expired", "detail_percent"
+};
+
+const char* ProfileStageName(ProfileStage stage)
+{
+    return STAGE_NAMES[static_cast<int>(stage)];
+}
+
+const char* ProfileCounterName(ProfileCounter counter)
+{
+    return COUNTER_NAMES[static_cast<int>(counter)];
+}
+
+uint64_t ProfileNowNs()
+{
+    static const std::chrono::steady_clock::time_point s_start = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - s_start).count());
+}
+
+//------------------------------------------------------------------
+// Event ring
+//  Producers claim an index with one fetch_add and fill the slot
+//  seqlock-style: "sequence" reads PROFILE_SLOT_BUSY while the fields
+//  change and index + 1 once they are complete. The consumer accepts a
+//  slot only if it saw the same complete sequence before and after
+//  copying the fields, so a slot overwritten mid-read is dropped, not
+//  torn. Fields are relaxed atomics; the fences order them.
+//  A writer lapped mid-write can land after the newer lap's writer and
+//  leave an older sequence behind; s_committed tells the consumer when
+//  no write is in flight, so such a slot is counted lost, not waited on.
+//------------------------------------------------------------------
+#define PROFILE_RING_MASK (PROFILE_RING_CAPACITY - 1)
+#define PROFILE_SLOT_BUSY (~0ull)
+
+// "packed": value (bits 0-31), stage/counter id (32-39), counter flag (40),
+// thread (48-63)
+#define PROFILE_COUNTER_FLAG (1ull << 40)
+
+struct ProfileSlot {
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> time;   // Start of a span / time of a counter sample
+    std::atomic<uint64_t> packed;
+};
+
+struct ProfileEvent {
+    uint64_t time;
+    uint32_t value;   // Span duration (ns) or counter value
+    uint8_t  id;
+    bool     counter;
+    uint16_t thread;
+};
+
+static ProfileSlot s_ring[PROFILE_RING_CAPACITY];
+static std::atomic<uint64_t> s_writeIndex(0);
+static std::atomic<uint64_t> s_committed(0); // Writes finished
+static std::atomic<uint32_t> s_nextThreadId(0);
+
+static uint64_t s_readIndex = 0; // Consumer only
+static uint64_t s_lost = 0;
+static bool s_capture = false;
+static std::vector<ProfileEvent> s_trace;
+static ProfileHistogram s_stageHistograms[static_cast<int>(ProfileStage::COUNT)];
+static ProfileHistogram s_counterHistograms[static_cast<int>(ProfileCounter::COUNT)];
+
+static uint16_t ProfileThreadId()
+{
+    thread_local uint16_t t_id = static_cast<uint16_t>(s_nextThreadId.fetch_add(1) + 1);
+    return t_id;
+}
+
+static void PushProfileEvent(uint64_t time, uint64_t packed)
+{
+    const uint64_t index = s_writeIndex.fetch_add(1, std::memory_order_relaxed);
+    ProfileSlot& slot = s_ring[index & PROFILE_RING_MASK];
+    slot.sequence.store(PROFILE_SLOT_BUSY, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.time.store(time, std::memory_order_relaxed);
+    slot.packed.store(packed | (static_cast<uint64_t>(ProfileThreadId()) << 48), std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+    s_committed.fetch_add(1, std::memory_order_release);
+}
+
+void RecordProfileSpan(ProfileStage stage, uint64_t startNs, uint64_t endNs)
+{
+    const uint64_t duration = std::min<uint64_t>(endNs - startNs, 0xFFFFFFFFull);
+    PushProfileEvent(startNs, duration | (static_cast<uint64_t>(stage) << 32));
+}
+
+void RecordProfileCounter(ProfileCounter counter, uint64_t value)
+{
+    value = std::min<uint64_t>(value, 0xFFFFFFFFull);
+    PushProfileEvent(ProfileNowNs(), value | (static_cast<uint64_t>(counter) << 32) | PROFILE_COUNTER_FLAG);
+}
+
+//------------------------------------------------------------------
+// ProfileHistogram
+//------------------------------------------------------------------
+static int HistogramBucket(uint64_t value)
+{
+    const uint64_t sub = 1ull << PROFILE_HISTOGRAM_SUB_BITS;
+    if (value < sub) return static_cast<int>(value);
+    int magnitude = PROFILE_HISTOGRAM_SUB_BITS;
+    while (value >> (magnitude + 1)) magnitude++;
+    const int shift = magnitude - PROFILE_HISTOGRAM_SUB_BITS;
+    return (shift + 1) * static_cast<int>(sub) + static_cast<int>((value >> shift) & (sub - 1));
+}
+
+static uint64_t HistogramBucketValue(int bucket)
+{
+    const int sub = 1 << PROFILE_HISTOGRAM_SUB_BITS;
+    if (bucket < sub) return static_cast<uint64_t>(bucket);
+    const int shift = bucket / sub - 1;
+    return static_cast<uint64_t>(sub + bucket % sub) << shift;
+}
+
+void ProfileHistogram::Reset()
+{
+    std::fill(counts, counts + PROFILE_HISTOGRAM_BUCKETS, 0ull);
+    total = 0;
+    min = max = 0;
+    sum = 0.0;
+}
+
+void ProfileHistogram::Record(uint64_t value)
+{
+    counts[HistogramBucket(value)]++;
+    min = total ? std::min(min, value) : value;
+    max = total ? std::max(max, value) : value;
+    total++;
+    sum += static_cast<double>(value);
+}
+
+uint64_t ProfileHistogram::Percentile(double pct) const
+{
+    if (total == 0) return 0;
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(pct / 100.0 * total + 0.5));
+    uint64_t seen = 0;
+    for (int i = 0; i < PROFILE_HISTOGRAM_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) return std::min(std::max(HistogramBucketValue(i), min), max);
+    }
+    return max;
+}
+
+//------------------------------------------------------------------
+// CollectProfile
+//------------------------------------------------------------------
+void CollectProfile()
+{
+    const uint64_t written = s_writeIndex.load(std::memory_order_acquire);
+    if (written - s_readIndex > PROFILE_RING_CAPACITY) {
+        s_lost += written - s_readIndex - PROFILE_RING_CAPACITY;
+        s_readIndex = written - PROFILE_RING_CAPACITY;
+    }
+
+    while (s_readIndex < written) {
+        const ProfileSlot& slot = s_ring[s_readIndex & PROFILE_RING_MASK];
+        const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before == PROFILE_SLOT_BUSY || before < s_readIndex + 1) {
+            // Not written yet, unless every claimed write has finished:
+            // then a lapped writer left a stale sequence here
+            if (s_committed.load(std::memory_order_acquire) != s_writeIndex.load(std::memory_order_relaxed)) break;
+            s_lost++;
+            s_readIndex++;
+            continue;
+        }
+        if (before > s_readIndex + 1) { // Overwritten
+            s_lost++;
+            s_readIndex++;
+            continue;
+        }
+        const uint64_t time   = slot.time.load(std::memory_order_relaxed);
+        const uint64_t packed = slot.packed.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before) {
+            s_lost++;
+            s_readIndex++;
+            continue;
+        }
+        s_readIndex++;
+
+        ProfileEvent e;
+        e.time    = time;
+        e.value   = static_cast<uint32_t>(packed);
+        e.id      = static_cast<uint8_t>(packed >> 32);
+        e.counter = (packed & PROFILE_COUNTER_FLAG) != 0;
+        e.thread  = static_cast<uint16_t>(packed >> 48);
+        if (e.counter) {
+            if (e.id < static_cast<int>(ProfileCounter::COUNT)) s_counterHistograms[e.id].Record(e.value);
+        } else {
+            if (e.id < static_cast<int>(ProfileStage::COUNT)) s_stageHistograms[e.id].Record(e.value);
+        }
+        if (s_capture && s_trace.size() < PROFILE_TRACE_MAX_EVENTS) s_trace.push_back(e);
+    }
+}
+
+void SetProfileTraceCapture(bool capture)
+{
+    s_capture = capture;
+}
+
+void ResetProfile()
+{
+    s_readIndex = s_writeIndex.load(std::memory_order_acquire);
+    s_lost = 0;
+    s_trace.clear();
+    for (ProfileHistogram& h : s_stageHistograms) h.Reset();
+    for (ProfileHistogram& h : s_counterHistograms) h.Reset();
+}
+
+const ProfileHistogram& GetStageHistogram(ProfileStage stage)
+{
+    return s_stageHistograms[static_cast<int>(stage)];
+}
+
+const ProfileHistogram& GetCounterHistogram(ProfileCounter counter)
+{
+    return s_counterHistograms[static_cast<int>(counter)];
+}
+
+uint64_t GetProfileEventsLost()
+{
+    return s_lost;
+}
+
+//------------------------------------------------------------------
+// Exports
+//------------------------------------------------------------------
+static void WriteHistogramRow(FILE* out, const char* kind, const char* name, const ProfileHistogram& h)
+{
+    fprintf(out, "%s,%s,%llu,%llu,%.1f,%llu,%llu,%llu,%llu\n", kind, name,
+            static_cast<unsigned long long>(h.total), static_cast<unsigned long long>(h.min), h.Mean(),
+            static_cast<unsigned long long>(h.Percentile(50)), static_cast<unsigned long long>(h.Percentile(90)),
+            static_cast<unsigned long long>(h.Percentile(99)), static_cast<unsigned long long>(h.max));
+}
+
+bool WriteProfileCsv(const char* path)
+{
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+
+    // Stages in nanoseconds, counters in their own units
+    fprintf(out, "kind,name,count,min,mean,p50,p90,p99,max\n");
+    for (int i = 0; i < static_cast<int>(ProfileStage::COUNT); i++) {
+        WriteHistogramRow(out, "stage_ns", STAGE_NAMES[i], s_stageHistograms[i]);
+    }
+    for (int i = 0; i < static_cast<int>(ProfileCounter::COUNT); i++) {
+        WriteHistogramRow(out, "counter", COUNTER_NAMES[i], s_counterHistograms[i]);
+    }
+    return fclose(out) == 0;
+}
+
+bool WriteChromeTrace(const char* path)
+{
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+
+    // Spans are complete ("X") events, counters "C" events; times in us
+    fprintf(out, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+    bool first = true;
+    for (const ProfileEvent& e : s_trace) {
+        fprintf(out, "%s\n", first ? "" : ",");
+        first = false;
+        if (e.counter) {
+            fprintf(out, "{\"name\": \"%s\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 1, \"tid\": %u, "
+                         "\"args\": {\"value\": %u}}",
+                    COUNTER_NAMES[e.id], e.time / 1000.0, static_cast<unsigned>(e.thread), e.value);
+        } else {
+            fprintf(out, "{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %u}",
+                    STAGE_NAMES[e.id], e.time / 1000.0, e.value / 1000.0, static_cast<unsigned>(e.thread));
+        }
+    }
+    fprintf(out, "\n]}\n");
+    return fclose(out) == 0;
+}
@@ -0,0 +1,120 @@
+// src/frame_scheduler.cpp
+#include "frame_scheduler.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+//------------------------------------------------------------------
+// Steady clock
+//------------------------------------------------------------------
+struct SteadyClockState {
+    std::mutex mutex;
+    std::condition_variable wakeCv;
+    bool pending = false;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+};
+
+static double SteadyNow(void* context)
+{
+    SteadyClockState* state = static_cast<SteadyClockState*>(context);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - state->start).count();
+}
+
+static void SteadySleepUntil(void* context, double time)
+{
+    SteadyClockState* state = static_cast<SteadyClockState*>(context);
+    std::this_thread::sleep_until(state->start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                     std::chrono::duration<double>(time)));
+}
+
+static void SteadyWaitForWake(void* context)
+{
+    SteadyClockState* state = static_cast<SteadyClockState*>(context);
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->wakeCv.wait(lock, [state] { return state->pending; });
+    state->pending = false;
+}
+
+static void SteadyWake(void* context)
+{
+    SteadyClockState* state = static_cast<SteadyClockState*>(context);
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->pending = true;
+    }
+    state->wakeCv.notify_one();
+}
+
+SchedulerClock GetSteadySchedulerClock()
+{
+    static SteadyClockState s_state;
+    SchedulerClock clock;
+    clock.now         = SteadyNow;
+    clock.sleepUntil  = SteadySleepUntil;
+    clock.waitForWake = SteadyWaitForWake;
+    clock.wake        = SteadyWake;
+    clock.context     = &s_state;
+    return clock;
+}
+
+//------------------------------------------------------------------
+// FrameScheduler
+//------------------------------------------------------------------
+FrameScheduler::FrameScheduler(const SchedulerClock& clock, double frameInterval)
+    : clock(clock), frameInterval(frameInterval), nextFrame(0.0), emptySince(0),
+      inputAtFrame(0), presented(0), inputCount(0), idle(false), stats()
+{
+    nextFrame = clock.now(clock.context);
+}
+
+bool FrameScheduler::WaitForNextFrame()
+{
+    // The screen is clear once the first of a run of empty frames has
+    // been presented; later empty frames would change nothing.
+    bool resumed = false;
+    if (emptySince != 0 && presented.load() >= emptySince) {
+        idle.store(true);
+
+        // Input that arrived before "idle" was visible did not wake us;
+        // it is still counted, so look before sleeping.
+        if (inputCount.load() == inputAtFrame) {
+            stats.idleEntries++;
+            stats.idleSince = clock.now(clock.context);
+            clock.waitForWake(clock.context);
+            stats.wakeUps++;
+            stats.wokeAt = clock.now(clock.context);
+            nextFrame = stats.wokeAt;
+            resumed = true;
+        }
+        idle.store(false);
+        emptySince = 0;
+    }
+    if (!resumed) clock.sleepUntil(clock.context, nextFrame);
+
+    // Late frames start the next interval from now instead of bursting
+    const double now = clock.now(clock.context);
+    nextFrame = (nextFrame + frameInterval > now) ? nextFrame + frameInterval : now + frameInterval;
+    inputAtFrame = inputCount.load();
+    return resumed;
+}
+
+void FrameScheduler::FrameProduced(uint64_t sequence, bool empty)
+{
+    if (!empty) {
+        emptySince = 0;
+    } else if (emptySince == 0) {
+        emptySince = sequence;
+    }
+}
+
+void FrameScheduler::FramePresented(uint64_t sequence)
+{
+    presented.store(sequence);
+}
+
+void FrameScheduler::Wake()
+{
+    inputCount.fetch_add(1);
+    if (idle.load()) clock.wake(clock.context);
+}
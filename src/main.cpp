@@ -7,9 +7,21 @@
 
 
 #include <windows.h>
+#include <atomic>
 #include <chrono>
-#include "window.h"       // CreateOverlayWindow, CreateDIB, UpdateOverlay, g_hInstance, g_hWnd, etc.
-#include "particles.h"    // SpawnParticlesOnMouseMove, UpdateParticles, DrawParticlesToDIB
+#include <cstring>
+#include <string>
+#include <thread>
+#include "window.h"       // CreateOverlayWindow, CreateFrameDIBs, UpdateOverlay, g_hInstance, g_hWnd, etc.
+#include "particles.h"    // SpawnParticlesUntil, UpdateParticles, DrawParticlesToTarget
+#include "frame_pipeline.h" // FrameTripleBuffer, FixedTimestep
+#include "frame_scheduler.h" // FrameScheduler, GetSteadySchedulerClock
+#include "frame_governor.h" // FrameGovernor
+#include "cursor_input.h" // CursorEventQueue, InputTimestamp
+#include "overlay_surface.h" // OverlaySurface
+#include "force_field.h"  // BuildForceField
+#include "frame_profiler.h" // MT_PROFILE_*, WriteProfileCsv
+#include "session_record.h" // StartSessionRecording (--record)
 #include "utils.h"        // RandomHeartColor (if needed)
 #include <shellscalingapi.h> // For SetProcessDpiAwarenessContext, SetProcessDPIAware
 
@@ -17,7 +29,190 @@
 #pragma comment(lib, "user32.lib")
 #pragma comment(lib, "gdi32.lib")
 
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
+// Cursor source for the particle core
+static bool GetDesktopCursorPos(Point* pt)
+{
+    POINT cursor;
+    if (!GetCursorPos(&cursor)) return false;
+    pt->x = cursor.x;
+    pt->y = cursor.y;
+    return true;
+}
+
+//------------------------------------------------------------------
+// Frame pipeline
+//  The simulation thread steps the particles at a fixed rate and draws
+//  into the back slot; the present thread pushes the newest finished
+//  frame to the window. The UI thread only pumps messages. Once the
+//  trail has faded and the window is clear, the scheduler parks the
+//  simulation thread until the mouse reports input, so an idle overlay
+//  costs no CPU at all. Every raw mouse report is queued with its time,
+//  so the trail follows the cursor's real path at any frame rate.
+//------------------------------------------------------------------
+#define FRAME_INTERVAL_SECONDS (1.0 / 60.0) // ~60 fps
+
+static FrameSlot s_slots[FRAME_SLOT_COUNT];
+static FrameTripleBuffer s_frames;
+static FrameScheduler s_scheduler(GetSteadySchedulerClock(), FRAME_INTERVAL_SECONDS);
+static std::atomic<bool> s_running(true);
+static HANDLE s_frameReady = nullptr; // Auto-reset; set after every Publish
+static CursorEventQueue s_cursorEvents; // UI thread -> simulation thread
+static OverlaySurface s_surface;         // Simulation thread
+static FrameGovernor s_governor;         // Simulation thread
+static std::string s_recordPath;         // --record <file>: session to write
+static Rect s_desktop;                   // Virtual screen, global coordinates
+
+// UI thread, once per raw mouse report (up to the mouse's polling rate)
+static void OnMouseInput()
+{
+    // Buttons and the wheel report too; only moves are queued
+    static Point s_lastQueued = { -1, -1 };
+    Point pt;
+    if (GetDesktopCursorPos(&pt) && (pt.x != s_lastQueued.x || pt.y != s_lastQueued.y)) {
+        CursorEvent e;
+        e.time = InputTimestampNow();
+        e.x = static_cast<float>(pt.x);
+        e.y = static_cast<float>(pt.y);
+        s_cursorEvents.Push(e);
+        s_lastQueued = pt;
+    }
+    s_scheduler.Wake();
+}
+
+// Simulation thread, once per frame: a gentle breeze, slow swirls and
+// a repulsor at the cursor while the tray toggle is on. Left off while
+// recording, since a session does not hold the field.
+static void UpdateForceField(double simTime)
+{
+    if (!g_forceField.load(std::memory_order_relaxed) || !s_recordPath.empty()) {
+        if (IsForceFieldActive()) ClearForceField();
+        return;
+    }
+    SetForceFieldBounds(s_desktop);
+    SetWind(25.f, 0.f);
+    SetTurbulence(150.f, 200.f, 0.3f);
+    ClearForcePoints();
+    ForcePoint repulsor = { static_cast<float>(g_lastMousePos.x), static_cast<float>(g_lastMousePos.y), -400.f, 120.f };
+    AddForcePoint(repulsor);
+    BuildForceField(simTime);
+}
+
+static void SimulationThread()
+{
+    FixedTimestep timestep;
+    uint64_t sequence = 0;
+    auto last = std::chrono::steady_clock::now();
+
+    // Recording starts here: the session must come from the thread that
+    // drives the engine
+    if (!s_recordPath.empty()) {
+        const uint64_t seed = static_cast<uint64_t>(last.time_since_epoch().count());
+        if (!StartSessionRecording(s_recordPath.c_str(), s_desktop, seed)) s_recordPath.clear();
+    }
+
+    for (;;) {
+        if (s_scheduler.WaitForNextFrame()) {
+            // Back from idle: run one step right away so the movement
+            // that woke us shows up in this frame.
+            last = std::chrono::steady_clock::now();
+            timestep.accumulator = timestep.step;
+        }
+        if (!s_running.load(std::memory_order_relaxed)) break;
+
+        // This thread also drains the profiler (profiling builds only)
+        MT_PROFILE_COLLECT();
+        MT_PROFILE_SCOPE(ProfileStage::FRAME);
+
+        auto now = std::chrono::steady_clock::now();
+        float dt = std::chrono::duration<float>(now - last).count();
+        last = now;
+
+        int request = g_requestedParticleSystem.exchange(0);
+        if (request) SetActiveParticleSystem(request);
+
+        // 1) Spawn and update in whole steps, whatever the frame rate.
+        // The simulation trails real time by the accumulator; each step
+        // takes the cursor moves that happened up to its end.
+        const int steps = timestep.Advance(dt);
+        const double simTime = InputTimestamp(now) - timestep.accumulator;
+        UpdateForceField(simTime);
+        for (int i = steps; i > 0; i--) {
+            SpawnParticlesUntil(simTime - (i - 1) * static_cast<double>(timestep.step));
+            UpdateParticles(timestep.step);
+        }
+
+        // 2) Place the surface over the trail. A slot gets a new DIB
+        // when the surface's size changed since it was last drawn;
+        // moving only shifts its origin (the pixels to clear stay put).
+        const int back = s_frames.BackSlot();
+        FrameSlot& slot = s_slots[back];
+        s_surface.SetFitToTrail(g_fitOverlayToTrail.load(std::memory_order_relaxed));
+        const Rect area = s_surface.Place(GetParticleBounds());
+        if (slot.target.fb.width != area.right - area.left ||
+            slot.target.fb.height != area.bottom - area.top) {
+            CreateFrameDIB(back, area, slot);
+        }
+        slot.target.fb.originX = area.left;
+        slot.target.fb.originY = area.top;
+
+        // 3) Draw between the last two steps into the slot we own.
+        // Note: DrawParticlesToTarget converts global coordinates to
+        // overlay coordinates by subtracting the framebuffer origin.
+        DrawParticlesToTarget(slot.target, timestep.Alpha());
+        slot.sequence = ++sequence;
+        bool empty = GetLiveParticleCount() == 0 && slot.target.drawn.count == 0;
+
+        // 4) Hand it over
+        s_frames.Publish();
+        SetEvent(s_frameReady);
+        s_scheduler.FrameProduced(sequence, empty);
+
+        // 5) Keep the next frame's work within the budget
+        const double work = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
+        SetDetailLevel(s_governor.FrameMeasured(work));
+        MT_PROFILE_COUNTER(ProfileCounter::DETAIL_PERCENT, static_cast<uint64_t>(GetDetailLevel() * 100.0f + 0.5f));
+    }
+    if (!s_recordPath.empty()) StopSessionRecording();
+}
+
+static void PresentThread()
+{
+    // What the window shows, in pixels that may be non-transparent;
+    // the initial present left it fully transparent.
+    DirtyRegion onScreen;
+    ClearDirtyRegion(onScreen);
+    Framebuffer shown = s_slots[s_frames.FrontSlot()].target.fb; // Window size
+
+    for (;;) {
+        WaitForSingleObject(s_frameReady, INFINITE);
+        if (!s_running.load(std::memory_order_relaxed)) break;
+        if (!s_frames.AcquireLatest()) continue;
+
+        // Pixels that differ: whatever the shown frame drew plus
+        // whatever the new one draws, in surface coordinates, so this
+        // holds when the surface only moved too (the window keeps its
+        // contents). A resized surface replaces them as a whole.
+        const FrameSlot& slot = s_slots[s_frames.FrontSlot()];
+        const Framebuffer& fb = slot.target.fb;
+        DirtyRegion dirty;
+        ClearDirtyRegion(dirty);
+        if (fb.width != shown.width || fb.height != shown.height) {
+            AddDirtyRect(dirty, Rect{ 0, 0, fb.width, fb.height });
+        } else {
+            dirty = onScreen;
+            AddDirtyRegion(dirty, slot.target.drawn);
+        }
+        {
+            MT_PROFILE_SCOPE(ProfileStage::PRESENT);
+            UpdateOverlay(g_hWnd, s_frames.FrontSlot(), fb, dirty);
+        }
+        onScreen = slot.target.drawn;
+        shown = fb;
+        s_scheduler.FramePresented(slot.sequence);
+    }
+}
+
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR lpCmdLine, int nCmdShow)
 {
     // Set the DPI awareness early on.
     // For Windows 10 version 1703 and later, attempt to use Per-Monitor Aware V2.
@@ -30,57 +225,77 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
     // Set global instance (defined in window.cpp)
     g_hInstance = hInstance;
 
+    // "--record <file>" writes the session for mousetrail_replay
+    const char* record = strstr(lpCmdLine, "--record ");
+    if (record) {
+        record += strlen("--record ");
+        while (*record == ' ') record++;
+        s_recordPath = record;
+        while (!s_recordPath.empty() && s_recordPath.back() == ' ') s_recordPath.pop_back();
+    }
+
+    // Particles follow the real desktop cursor, move by move
+    SetCursorSource(GetDesktopCursorPos);
+    SetCursorEventQueue(&s_cursorEvents);
+
+    // Rasterize large frames on every core (small ones stay on the simulation thread)
+    SetDrawThreadCount(0);
+
+    // Any mouse input wakes the scheduler when it is idle
+    g_onMouseInput = OnMouseInput;
+
     // 1) Create the overlay window
     if (!CreateOverlayWindow(nCmdShow)) {
         MessageBox(nullptr, TEXT("Failed to create overlay window."), TEXT("Error"), MB_ICONERROR);
         return 1;
     }
 
-    // 2) Create the 32-bit ARGB DIB (the DIB size is based on our calculated virtual screen bounds)
-    CreateDIB(g_ScreenWidth, g_ScreenHeight);
+    // 2) Create the 32-bit ARGB DIBs: the whole virtual screen, or a
+    // small surface that grows with the first trail
+    s_desktop = { g_VirtualOffsetX, g_VirtualOffsetY,
+                  g_VirtualOffsetX + g_ScreenWidth, g_VirtualOffsetY + g_ScreenHeight };
+    s_surface.SetFitToTrail(g_fitOverlayToTrail.load());
+    s_surface.Reset(s_desktop);
+    if (!CreateFrameDIBs(s_surface.Current(), s_slots)) {
+        MessageBox(nullptr, TEXT("Failed to create frame buffers."), TEXT("Error"), MB_ICONERROR);
+        return 1;
+    }
 
-    // 3) Initial update
-    UpdateOverlay(g_hWnd);
+    // 3) Initial update: the whole (transparent) surface
+    const Framebuffer& initial = s_slots[s_frames.FrontSlot()].target.fb;
+    DirtyRegion full;
+    ClearDirtyRegion(full);
+    AddDirtyRect(full, Rect{ 0, 0, initial.width, initial.height });
+    UpdateOverlay(g_hWnd, s_frames.FrontSlot(), initial, full);
 
     // 4) Show the window
     ShowWindow(g_hWnd, nCmdShow);
     UpdateWindow(g_hWnd);
 
-    // Setup for main loop
-    MSG msg;
-    g_lastFrameTime = std::chrono::steady_clock::now();
-
-    // Main loop
-    while (true) {
-        if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
-            if (msg.message == WM_QUIT)
-                break;
-            TranslateMessage(&msg);
-            DispatchMessage(&msg);
-        } else {
-            // Calculate delta time
-            auto now = std::chrono::steady_clock::now();
-            float dt = std::chrono::duration<float>(now - g_lastFrameTime).count();
-            g_lastFrameTime = now;
+    // 5) Start producing and presenting frames
+    s_frameReady = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    std::thread simulation(SimulationThread);
+    std::thread present(PresentThread);
 
-            // 1) Spawn particles on mouse move
-            SpawnParticlesOnMouseMove();
-
-            // 2) Update particle positions, rotations, lifetimes
-            UpdateParticles(dt);
-
-            // 3) Draw particles into the DIB.
-            // Note: In DrawParticlesToDIB(), we convert global coordinates
-            // to overlay coordinates by subtracting g_VirtualOffsetX/Y.
-            DrawParticlesToDIB();
+    // Main loop: messages only (tray menu, exit)
+    MSG msg = {};
+    while (GetMessage(&msg, nullptr, 0, 0) > 0) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
 
-            // 4) Update overlay
-            UpdateOverlay(g_hWnd);
+    s_running = false;
+    s_scheduler.Wake();
+    SetEvent(s_frameReady);
+    simulation.join();
+    present.join();
+    CloseHandle(s_frameReady);
 
-            // ~60 fps
-            Sleep(16);
-        }
-    }
+#if MT_ENABLE_PROFILING
+    // Stage and counter histograms of the whole session
+    CollectProfile();
+    WriteProfileCsv("mousetrail_profile.csv");
+#endif
 
     return static_cast<int>(msg.wParam);
 }
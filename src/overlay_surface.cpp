@@ -0,0 +1,118 @@
+// src/overlay_surface.cpp
+#include "overlay_surface.h"
+#include "dirty_region.h"  // IsEmptyRect
+#include <algorithm>
+
+static int RectWidth(const Rect& rc)  { return rc.right - rc.left; }
+static int RectHeight(const Rect& rc) { return rc.bottom - rc.top; }
+
+static bool SameRect(const Rect& a, const Rect& b)
+{
+    return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+static bool ContainsRect(const Rect& outer, const Rect& inner)
+{
+    return inner.left >= outer.left && inner.top >= outer.top &&
+           inner.right <= outer.right && inner.bottom <= outer.bottom;
+}
+
+// Grown by the growth factor and rounded up to the alignment, at most "limit"
+static int SurfaceSize(int needed, int limit)
+{
+    int size = static_cast<int>(needed * SURFACE_GROWTH);
+    size = (size + SURFACE_ALIGN - 1) / SURFACE_ALIGN * SURFACE_ALIGN;
+    return std::min(std::max(size, SURFACE_ALIGN), limit);
+}
+
+// Start of a span of "size" centered on [from, to), kept within [lo, hi)
+static int CenterSpan(int from, int to, int size, int lo, int hi)
+{
+    int start = (from + to - size) / 2;
+    return std::max(lo, std::min(start, hi - size));
+}
+
+OverlaySurface::OverlaySurface(bool fitToTrail)
+    : stats(), desktop(), current(), fitToTrail(fitToTrail), smallFrames(0)
+{
+}
+
+//------------------------------------------------------------------
+// Reset
+//  Fitted surfaces start as one alignment block in the desktop's
+//  corner and grow with the first trail.
+//------------------------------------------------------------------
+void OverlaySurface::Reset(const Rect& desktopRect)
+{
+    desktop = desktopRect;
+    current = desktop;
+    if (fitToTrail) {
+        current.right  = desktop.left + std::min(SURFACE_ALIGN, RectWidth(desktop));
+        current.bottom = desktop.top + std::min(SURFACE_ALIGN, RectHeight(desktop));
+    }
+    smallFrames = 0;
+    stats = SurfaceStats();
+}
+
+void OverlaySurface::SetFitToTrail(bool fit)
+{
+    fitToTrail = fit;
+}
+
+//------------------------------------------------------------------
+// Place
+//------------------------------------------------------------------
+Rect OverlaySurface::Place(const Rect& bounds)
+{
+    if (!fitToTrail) {
+        if (!SameRect(current, desktop)) {
+            current = desktop;
+            stats.resizes++;
+        }
+        return current;
+    }
+    if (IsEmptyRect(bounds)) return current;
+
+    // Everything the particles may draw, on the desktop
+    Rect need;
+    need.left   = std::max(bounds.left - SURFACE_PARTICLE_REACH, desktop.left);
+    need.top    = std::max(bounds.top - SURFACE_PARTICLE_REACH, desktop.top);
+    need.right  = std::min(bounds.right + SURFACE_PARTICLE_REACH, desktop.right);
+    need.bottom = std::min(bounds.bottom + SURFACE_PARTICLE_REACH, desktop.bottom);
+    if (IsEmptyRect(need)) return current;
+
+    const int needW = RectWidth(need);
+    const int needH = RectHeight(need);
+    int width  = RectWidth(current);
+    int height = RectHeight(current);
+
+    // Grow at once; shrink only after a sustained stretch of frames
+    // that need a small part of the surface.
+    bool resize = false;
+    if (needW > width || needH > height) {
+        resize = true;
+    } else if (static_cast<long long>(needW) * needH * SURFACE_SHRINK_RATIO <
+               static_cast<long long>(width) * height) {
+        resize = ++smallFrames >= SURFACE_SHRINK_FRAMES;
+    } else {
+        smallFrames = 0;
+    }
+
+    if (resize) {
+        width  = SurfaceSize(needW, RectWidth(desktop));
+        height = SurfaceSize(needH, RectHeight(desktop));
+        smallFrames = 0;
+        stats.resizes++;
+    } else if (ContainsRect(current, need)) {
+        return current;
+    } else {
+        stats.moves++;
+    }
+
+    // Recenter on the trail, so it can drift a while before the next move
+    current.left   = CenterSpan(need.left, need.right, width, desktop.left, desktop.right);
+    current.top    = CenterSpan(need.top, need.bottom, height, desktop.top, desktop.bottom);
+    current.right  = current.left + width;
+    current.bottom = current.top + height;
+    return current;
+}
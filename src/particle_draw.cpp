@@ -0,0 +1,678 @@
+// src/particle_draw.cpp
+#include "particles.h"
+#include "effect_policies.h"
+#include "rng.h"
+#include "sprite_cache.h"
+#include "falloff_kernels.h"
+#include "thread_pool.h"
+#include "blend_kernels.h"
+#include "frame_profiler.h"
+#include "raster.h"
+#include "session_record.h"
+#include <cmath>
+#include <algorithm>
+#include <cstring>   // memset
+#include <atomic>
+
+// Global Variables
+Framebuffer g_framebuffer = {};
+DirtyRegion g_dirtyRegion = {};
+
+static DirtyRegion s_prevDrawnRegion = {}; // Pixels written by the previous frame
+static float s_drawDetail = 1.0f;           // GetDetailLevel() for the frame being drawn
+
+#define SMOKE_MIN_RADIUS_SCALE 0.5f // Puff radius at the lowest level of detail, relative to full
+
+// Counts of flames, arms etc. at the frame's level of detail (at least one)
+static int DetailCount(int count)
+{
+    return std::max(1, static_cast<int>(count * s_drawDetail + 0.5f));
+}
+
+//---------------------------------------------------
+// Particle Rendering (Draw Functions)
+//---------------------------------------------------
+// Each routine writes only inside "clip", which callers keep within the
+// particle's bounds (see the effects' Prepare) and the framebuffer. Opaque
+// pixels are stored directly; translucent ones (fire, smoke) are
+// composited over what is already there as premultiplied spans. Random
+// variation comes from a per-particle stream, so the pixels a particle
+// produces do not depend on how the frame is split up.
+void DrawShape(const Particle& p, const Sprite& sprite, const Rect& clip);
+void DrawFire(const Particle& p, const Rect& clip, Rng& rng);
+void DrawSparks(const Particle& p, const SparkArcs& arcs, const Rect& clip, Rng& rng);
+void DrawSmoke(const Particle& p, const FalloffKernel& kernel, const Rect& clip);
+
+static Rect IntersectRects(const Rect& a, const Rect& b)
+{
+    Rect rc;
+    rc.left   = std::max(a.left, b.left);
+    rc.top    = std::max(a.top, b.top);
+    rc.right  = std::min(a.right, b.right);
+    rc.bottom = std::min(a.bottom, b.bottom);
+    return rc;
+}
+
+// Square of half-size "radius" around the particle, clipped to the framebuffer
+static Rect ParticleBounds(const Particle& p, int radius)
+{
+    Rect rc;
+    rc.left   = static_cast<int>(p.x) - radius;
+    rc.top    = static_cast<int>(p.y) - radius;
+    rc.right  = static_cast<int>(p.x) + radius + 1;
+    rc.bottom = static_cast<int>(p.y) + radius + 1;
+    return ClipRectToSurface(rc, g_framebuffer.width, g_framebuffer.height);
+}
+
+
+//---------------------------------------------------
+// Draw a Cached Sprite (Hearts, Stars & Swords)
+//  Copies the sprite centered on the particle; opaque pixels of a
+//  tinted sprite take the particle's color.
+//---------------------------------------------------
+static Rect SpriteBounds(const Particle& p, const Sprite& sprite)
+{
+    Rect rc;
+    rc.left   = static_cast<int>(p.x) + sprite.offsetX;
+    rc.top    = static_cast<int>(p.y) + sprite.offsetY;
+    rc.right  = rc.left + sprite.width;
+    rc.bottom = rc.top + sprite.height;
+    return rc;
+}
+
+void DrawShape(const Particle& p, const Sprite& sprite, const Rect& clip)
+{
+    const Rect rc = SpriteBounds(p, sprite);
+    const Rect clipped = IntersectRects(rc, clip);
+    if (IsEmptyRect(clipped)) return;
+
+    const uint32_t tintColor = (0xFF << 24) | (p.color & 0xFFFFFF);
+    const int spanWidth = clipped.right - clipped.left;
+    for (int sy = clipped.top; sy < clipped.bottom; sy++) {
+        const uint8_t* src = sprite.pixels.data() + (sy - rc.top) * sprite.width + (clipped.left - rc.left);
+        uint32_t* dst = g_framebuffer.pixels + sy * g_framebuffer.width + clipped.left;
+        for (int i = 0; i < spanWidth; i++) {
+            uint8_t index = src[i];
+            if (index == 0) continue;
+            dst[i] = sprite.tinted ? tintColor : sprite.palette[index];
+        }
+    }
+}
+
+// Span sink for RasterizeTriangle: one color blended into the frame
+struct SpanTarget {
+    uint32_t* pixels;
+    int       stride;
+    uint32_t  color; // Premultiplied
+};
+
+static void BlendSpan(int y, int x0, int x1, void* context)
+{
+    const SpanTarget& target = *static_cast<const SpanTarget*>(context);
+    BlendSpanSolid(target.pixels + static_cast<size_t>(y) * target.stride + x0, x1 - x0, target.color);
+}
+
+//---------------------------------------------------
+// Draw Fire (Fast-Fading Triangle Flames)
+//---------------------------------------------------
+// Flames jitter by a few pixels around the particle and extend
+// up to 15 * scale above it.
+static Rect FireBounds(const Particle& p)
+{
+    int halfWidth = static_cast<int>(p.scale * 10) / 2 + 2;
+    int height    = static_cast<int>(p.scale * 15);
+    Rect bounds;
+    bounds.left   = static_cast<int>(p.x) - halfWidth;
+    bounds.right  = static_cast<int>(p.x) + halfWidth + 1;
+    bounds.top    = static_cast<int>(p.y) - height - 6;
+    bounds.bottom = static_cast<int>(p.y) + 1;
+    return bounds;
+}
+
+
+void DrawFire(const Particle& p, const Rect& clip, Rng& rng)
+{
+    // Per particle: flicker, flame size and anchor are the same for
+    // every triangle
+    float alpha = 0.5f + 0.5f * sinf(p.life * 15.0f);
+    const uint32_t flickerAlpha = static_cast<uint32_t>(alpha * 255) << 24;
+    const int halfWidth = static_cast<int>(p.scale * 10) / 2;
+    const int height    = static_cast<int>(p.scale * 15);
+    const int px = static_cast<int>(p.x);
+    const int py = static_cast<int>(p.y);
+
+    SpanTarget target;
+    target.pixels = g_framebuffer.pixels;
+    target.stride = g_framebuffer.width;
+
+    int numTriangles = DetailCount(3 + rng.NextInt(3)); // 3-5 small flames per particle
+    for (int i = 0; i < numTriangles; i++) {
+        int tx = px + (rng.NextInt(4) - 2);
+        int ty = py - rng.NextInt(6); // Moves upwards slightly
+
+        // Orange to yellow
+        int phase = rng.NextInt(3);
+        uint32_t g = (phase == 0) ? (80 + rng.NextInt(100)) : (150 + rng.NextInt(50));
+        target.color = PremultiplyARGB(flickerAlpha | (0xFFu << 16) | (g << 8));
+
+        // Upward flame: apex above, base on row ty. Tiny particles give
+        // zero-area triangles, which draw nothing.
+        RasterizeTriangle(RasterPixel(tx, ty - height),
+                          RasterPixel(tx - halfWidth, ty),
+                          RasterPixel(tx + halfWidth, ty),
+                          clip, BlendSpan, &target);
+    }
+}
+
+//---------------------------------------------------
+// Draw Sparks (Chaotic Electric Arcs)
+//  The arcs are laid out once at spawn; each frame only nudges their
+//  bend and end points by a pixel or two so they keep crackling.
+//---------------------------------------------------
+#define SPARK_JITTER_PIXELS 2
+
+// Offsets picked by two random bits; never 0, so every point moves
+static const int8_t s_sparkJitter[4] = { -SPARK_JITTER_PIXELS, -1, 1, SPARK_JITTER_PIXELS };
+
+// Unit vectors for whole-degree arm directions
+struct SparkDirections {
+    float cosine[360], sine[360];
+
+    SparkDirections()
+    {
+        for (int degrees = 0; degrees < 360; degrees++) {
+            const float angle = (degrees * 3.14159f) / 180.0f;
+            cosine[degrees] = cosf(angle);
+            sine[degrees]   = sinf(angle);
+        }
+    }
+};
+
+void SparksEffect::InitShape(ParticlePool& pool, size_t i, Rng& rng)
+{
+    static const SparkDirections s_directions;
+    SparkArcs& arcs = pool.arcs[i];
+    arcs = SparkArcs();
+    arcs.armCount = static_cast<uint8_t>(2 + rng.NextInt(3));
+
+    int reach = 0;
+    for (int arm = 0; arm < arcs.armCount; arm++) {
+        const int numPoints = 3 + rng.NextInt(SPARK_MAX_POINTS - 2); // 3 to 6
+        const int arcLength = 10 + rng.NextInt(31);
+        const int degrees = rng.NextInt(360);
+        arcs.pointCount[arm] = static_cast<uint8_t>(numPoints);
+
+        // Straight from the particle to the end, then bent sideways by
+        // up to a quarter of the length at the points in between
+        const int endX = static_cast<int>(floorf(arcLength * s_directions.cosine[degrees]));
+        const int endY = static_cast<int>(floorf(arcLength * s_directions.sine[degrees]));
+        const float len = sqrtf(static_cast<float>(endX * endX + endY * endY));
+        const float perpX = (len != 0) ? -endY / len : 0.f;
+        const float perpY = (len != 0) ? endX / len : 0.f;
+
+        int8_t (*offset)[2] = arcs.offset[arm];
+        for (int k = 1; k < numPoints - 1; k++) {
+            const float t = k / static_cast<float>(numPoints - 1);
+            const int bend = rng.NextInt(arcLength / 2 + 1) - arcLength / 4;
+            offset[k - 1][0] = static_cast<int8_t>(static_cast<int>(floorf(t * endX)) + static_cast<int>(perpX * bend));
+            offset[k - 1][1] = static_cast<int8_t>(static_cast<int>(floorf(t * endY)) + static_cast<int>(perpY * bend));
+        }
+        offset[numPoints - 2][0] = static_cast<int8_t>(endX);
+        offset[numPoints - 2][1] = static_cast<int8_t>(endY);
+
+        for (int k = 0; k < numPoints - 1; k++) {
+            reach = std::max(reach, std::max(abs(offset[k][0]), abs(offset[k][1])));
+        }
+    }
+    arcs.reach = static_cast<uint8_t>(reach + SPARK_JITTER_PIXELS);
+}
+
+void DrawSparks(const Particle& p, const SparkArcs& arcs, const Rect& clip, Rng& rng)
+{
+    const uint32_t color = 0xFF000000u | (p.color & 0xFFFFFF); // Opaque, so already premultiplied
+    const int px = static_cast<int>(p.x);
+    const int py = static_cast<int>(p.y);
+    const int numArms = DetailCount(arcs.armCount);
+    for (int arm = 0; arm < numArms; arm++) {
+        // Two bits per coordinate: enough for the at most five points
+        uint32_t bits = rng.NextU32();
+        int x0 = px, y0 = py;
+        for (int k = 0; k < arcs.pointCount[arm] - 1; k++) {
+            const int x1 = px + arcs.offset[arm][k][0] + s_sparkJitter[bits & 3];
+            const int y1 = py + arcs.offset[arm][k][1] + s_sparkJitter[(bits >> 2) & 3];
+            bits >>= 4;
+            FillLine(g_framebuffer.pixels, g_framebuffer.width, x0, y0, x1, y1, clip, color);
+            x0 = x1;
+            y0 = y1;
+        }
+    }
+}
+
+//---------------------------------------------------
+// Draw Smoke (Soft Puffs)
+//  Stamps the cached falloff kernel for the puff's radius, one span per
+//  row, with blue noise standing in for per-pixel random jitter.
+//---------------------------------------------------
+static int s_noiseOffsetX = 0; // Blue-noise scroll, changes every frame
+static int s_noiseOffsetY = 0;
+
+// Coverage is built and blended this many pixels at a time
+#define SMOKE_SPAN_CHUNK 256
+
+// Determine the "radius" of the smoke puff based on its scale (and the
+// level of detail).
+static int SmokeRadius(const Particle& p)
+{
+    const float detailScale = SMOKE_MIN_RADIUS_SCALE + (1.0f - SMOKE_MIN_RADIUS_SCALE) * s_drawDetail;
+    return static_cast<int>(p.scale * (8 * detailScale));
+}
+
+void DrawSmoke(const Particle& p, const FalloffKernel& kernel, const Rect& clip)
+{
+    const int radius = kernel.radius;
+    const uint8_t* noise = GetBlueNoise();
+    const int size = 2 * radius + 1;
+    const int left = static_cast<int>(p.x) - radius;
+    const int top  = static_cast<int>(p.y) - radius;
+    const uint32_t color = (0xFF << 24) | (p.color & 0xFFFFFF); // p.color is assumed to be a grayish tone.
+    uint8_t coverage[SMOKE_SPAN_CHUNK];
+
+    // Noise is anchored to the desktop, not the surface, so a surface
+    // that moves with the trail does not change the pixels.
+    const int noiseX = g_framebuffer.originX + s_noiseOffsetX;
+    const int noiseY = g_framebuffer.originY + s_noiseOffsetY;
+
+    const Rect bounds = IntersectRects(ParticleBounds(p, radius), clip);
+    for (int y = bounds.top; y < bounds.bottom; y++) {
+        const int j = y - top;
+        const int x0 = std::max(left + kernel.spanStart[j], bounds.left);
+        const int x1 = std::min(left + kernel.spanEnd[j], bounds.right);
+        const uint16_t* alpha = kernel.alpha.data() + j * size;
+        const uint8_t* noiseRow = noise + ((y + noiseY) & (BLUE_NOISE_SIZE - 1)) * BLUE_NOISE_SIZE;
+        uint32_t* dst = g_framebuffer.pixels + y * g_framebuffer.width;
+
+        for (int xs = x0; xs < x1; xs += SMOKE_SPAN_CHUNK) {
+            const int count = std::min(x1 - xs, SMOKE_SPAN_CHUNK);
+            for (int k = 0; k < count; k++) {
+                // Falloff plus noise in [-0.1, 0.1) to simulate the
+                // turbulent, wispy nature of smoke, clamped to [0, 1].
+                const int x = xs + k;
+                int n = noiseRow[(x + noiseX) & (BLUE_NOISE_SIZE - 1)];
+                int a = alpha[x - left] + ((n * 52) >> 8) - 26;
+                a = std::min(FALLOFF_ONE, std::max(0, a));
+
+                // Smoke tops out at 150 (out of 255) opacity.
+                coverage[k] = static_cast<uint8_t>((a * 150) >> 8);
+            }
+            BlendSpanCoverage(dst + xs, coverage, count, color);
+        }
+    }
+}
+
+
+//---------------------------------------------------
+// Draw items & tiles
+//  A frame is drawn in two passes. The first collects every visible
+//  particle in draw order, with its clipped bounds and whatever it
+//  needs from the (single-threaded) sprite and kernel caches. The
+//  second clears and draws. With several draw threads the surface is
+//  cut into DRAW_TILE_SIZE tiles, each listing the items that overlap
+//  it in the same order; one worker clears and draws a whole tile, so
+//  no two threads ever write the same pixel and no locking is needed.
+//  Every pixel ends up with the same value as on a single thread.
+//---------------------------------------------------
+#define DRAW_TILE_SIZE 128 // Particles span up to ~90 px; smaller tiles mostly redraw them
+#define PARALLEL_DRAW_MIN_ITEMS 256 // Below this, waking the workers costs more than it saves
+
+// Index range of one effect's items in s_drawItems
+struct DrawRange {
+    size_t begin, end;
+};
+
+static std::vector<DrawItem> s_drawItems;             // In Effects order
+static DrawRange s_drawRanges[PARTICLE_TYPE_COUNT];   // Per pool
+static std::vector<std::vector<uint32_t>> s_tileItems; // Indices into s_drawItems, per tile
+static int s_tilesX = 0;
+static int s_tilesY = 0;
+static uint64_t s_drawSeed = 0; // Base seed of this frame's per-particle streams
+static const DirtyRegion* s_clearRegion = nullptr; // Previous contents the tiles clear
+
+#if MT_ENABLE_PROFILING
+static std::atomic<uint64_t> s_typeDrawNs[PARTICLE_TYPE_COUNT]; // This frame, all threads
+static PoolStats s_profiledStats[PARTICLE_TYPE_COUNT];           // As of the previous frame
+#endif
+
+// Adds the time spent drawing a run of one effect's items to that
+// effect's draw time. Does nothing unless profiling.
+struct TypeDrawTimer {
+#if MT_ENABLE_PROFILING
+    explicit TypeDrawTimer(ParticleType type) : type(PoolIndex(type)), start(ProfileNowNs()) {}
+    ~TypeDrawTimer() { s_typeDrawNs[type].fetch_add(ProfileNowNs() - start, std::memory_order_relaxed); }
+
+    int type;
+    uint64_t start;
+#else
+    explicit TypeDrawTimer(ParticleType) {}
+#endif
+};
+
+//---------------------------------------------------
+// Effect draw routines (see effect_policies.h)
+//---------------------------------------------------
+template <SpriteShape SHAPE>
+Rect SpriteDraw<SHAPE>::Prepare(DrawItem& item)
+{
+    item.sprite = &GetSprite(SHAPE, item.p.scale, item.p.angle);
+    return SpriteBounds(item.p, *item.sprite);
+}
+
+template <SpriteShape SHAPE>
+void SpriteDraw<SHAPE>::Draw(const DrawItem& item, const Rect& clip, size_t)
+{
+    DrawShape(item.p, *item.sprite, clip);
+}
+
+Rect FireEffect::Prepare(DrawItem& item)
+{
+    return FireBounds(item.p);
+}
+
+void FireEffect::Draw(const DrawItem& item, const Rect& clip, size_t index)
+{
+    Rng rng(s_drawSeed, index);
+    DrawFire(item.p, clip, rng);
+}
+
+Rect SparksEffect::Prepare(DrawItem& item)
+{
+    return ParticleBounds(item.p, item.arcs->reach);
+}
+
+void SparksEffect::Draw(const DrawItem& item, const Rect& clip, size_t index)
+{
+    Rng rng(s_drawSeed, index);
+    DrawSparks(item.p, *item.arcs, clip, rng);
+}
+
+Rect SmokeEffect::Prepare(DrawItem& item)
+{
+    item.kernel = &GetFalloffKernel(SmokeRadius(item.p));
+    return ParticleBounds(item.p, item.kernel->radius);
+}
+
+void SmokeEffect::Draw(const DrawItem& item, const Rect& clip, size_t)
+{
+    DrawSmoke(item.p, *item.kernel, clip);
+}
+
+//---------------------------------------------------
+// Per-effect draw loops
+//---------------------------------------------------
+// Appends the effect's visible particles to s_drawItems and their
+// bounds to "drawn"
+template <class Effect>
+static void CollectDrawItems(float alpha, DirtyRegion& drawn)
+{
+    const ParticlePool& pool = GetPool(Effect::TYPE);
+    DrawRange& range = s_drawRanges[PoolIndex(Effect::TYPE)];
+    range.begin = s_drawItems.size();
+
+    const size_t count = pool.Size();
+    for (size_t i = 0; i < count; i++) {
+        float x = pool.x[i];
+        float y = pool.y[i];
+        if (alpha < 1.0f) {
+            const float prevX = pool.PrevX(i), prevY = pool.PrevY(i);
+            x = prevX + (x - prevX) * alpha;
+            y = prevY + (y - prevY) * alpha;
+        }
+
+        // Convert global coordinates into the overlay's coordinate
+        // space by subtracting the framebuffer origin.
+        int adjustedX = static_cast<int>(x) - g_framebuffer.originX;
+        int adjustedY = static_cast<int>(y) - g_framebuffer.originY;
+
+        // Only draw if the particle lies within the framebuffer.
+        if (adjustedX < 0 || adjustedX >= g_framebuffer.width ||
+            adjustedY < 0 || adjustedY >= g_framebuffer.height)
+            continue;
+
+        // Create a local record of the particle with adjusted coordinates.
+        DrawItem item;
+        item.p = pool.Get(i);
+        item.p.x = adjustedX;
+        item.p.y = adjustedY;
+        item.sprite = nullptr;
+        item.kernel = nullptr;
+        item.arcs = pool.arcs.empty() ? nullptr : &pool.arcs[i];
+        item.bounds = ClipRectToSurface(Effect::Prepare(item), g_framebuffer.width, g_framebuffer.height);
+        if (IsEmptyRect(item.bounds)) continue;
+
+        s_drawItems.push_back(item);
+        AddDirtyRect(drawn, item.bounds);
+    }
+    range.end = s_drawItems.size();
+}
+
+// Draws the effect's items whole (single-threaded frames)
+template <class Effect>
+static void DrawItems()
+{
+    const DrawRange& range = s_drawRanges[PoolIndex(Effect::TYPE)];
+    if (range.begin == range.end) return;
+
+    TypeDrawTimer timer(Effect::TYPE);
+    for (size_t i = range.begin; i < range.end; i++) {
+        Effect::Draw(s_drawItems[i], s_drawItems[i].bounds, i);
+    }
+}
+
+// Draws the effect's items at the front of a tile's list, which is in
+// s_drawItems order, clipped to the tile. Returns where the next
+// effect's items start.
+template <class Effect>
+static const uint32_t* DrawTileItems(const uint32_t* it, const uint32_t* end, const Rect& tileRect)
+{
+    const size_t rangeEnd = s_drawRanges[PoolIndex(Effect::TYPE)].end;
+    if (it == end || *it >= rangeEnd) return it;
+
+    TypeDrawTimer timer(Effect::TYPE);
+    for (; it != end && *it < rangeEnd; ++it) {
+        const DrawItem& item = s_drawItems[*it];
+        Effect::Draw(item, IntersectRects(item.bounds, tileRect), *it);
+    }
+    return it;
+}
+
+static void ClearRect(const Rect& rc)
+{
+    if (IsEmptyRect(rc)) return;
+    size_t rowBytes = (rc.right - rc.left) * sizeof(unsigned int);
+    for (int y = rc.top; y < rc.bottom; y++) {
+        memset(g_framebuffer.pixels + y * g_framebuffer.width + rc.left, 0, rowBytes);
+    }
+}
+
+// Appends every item to the tiles its bounds overlap
+static void BinDrawItems()
+{
+    s_tilesX = (g_framebuffer.width + DRAW_TILE_SIZE - 1) / DRAW_TILE_SIZE;
+    s_tilesY = (g_framebuffer.height + DRAW_TILE_SIZE - 1) / DRAW_TILE_SIZE;
+    s_tileItems.resize(static_cast<size_t>(s_tilesX) * s_tilesY);
+    for (std::vector<uint32_t>& tile : s_tileItems) tile.clear();
+
+    for (size_t i = 0; i < s_drawItems.size(); i++) {
+        const Rect& rc = s_drawItems[i].bounds;
+        for (int ty = rc.top / DRAW_TILE_SIZE; ty <= (rc.bottom - 1) / DRAW_TILE_SIZE; ty++) {
+            for (int tx = rc.left / DRAW_TILE_SIZE; tx <= (rc.right - 1) / DRAW_TILE_SIZE; tx++) {
+                s_tileItems[ty * s_tilesX + tx].push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+}
+
+// ParallelFor task: clears and draws one tile
+static void DrawTile(size_t tile, void*)
+{
+    const int tx = static_cast<int>(tile % s_tilesX);
+    const int ty = static_cast<int>(tile / s_tilesX);
+    Rect tileRect;
+    tileRect.left   = tx * DRAW_TILE_SIZE;
+    tileRect.top    = ty * DRAW_TILE_SIZE;
+    tileRect.right  = std::min(tileRect.left + DRAW_TILE_SIZE, g_framebuffer.width);
+    tileRect.bottom = std::min(tileRect.top + DRAW_TILE_SIZE, g_framebuffer.height);
+
+    for (int i = 0; i < s_clearRegion->count; i++) {
+        ClearRect(IntersectRects(s_clearRegion->rects[i], tileRect));
+    }
+    const std::vector<uint32_t>& items = s_tileItems[tile];
+    const uint32_t* it = items.data();
+    const uint32_t* end = it + items.size();
+    Effects::ForEach([&](auto effect) {
+        it = DrawTileItems<decltype(effect)>(it, end, tileRect);
+    });
+}
+
+#if MT_ENABLE_PROFILING
+// Per-type draw spans (summed thread time, starting with the frame) and
+// the frame's counters
+static void RecordDrawProfile(uint64_t drawStart, const DirtyRegion& drawn)
+{
+    for (int i = 0; i < PARTICLE_TYPE_COUNT; i++) {
+        const uint64_t ns = s_typeDrawNs[i].exchange(0, std::memory_order_relaxed);
+        if (ns) RecordProfileSpan(DrawStageForPool(i), drawStart, drawStart + ns);
+    }
+
+    const uint64_t pixels = g_frameStats.bytesCleared / sizeof(unsigned int) + GetDirtyArea(drawn);
+
+    uint64_t live = 0, spawned = 0, expired = 0;
+    for (int i = 0; i < PARTICLE_TYPE_COUNT; i++) {
+        const PoolStats stats = GetPoolStats(static_cast<ParticleType>(i + 1));
+        const PoolStats& prev = s_profiledStats[i];
+        live += stats.live;
+        // The stats may have been reset since the previous frame
+        spawned += stats.spawned >= prev.spawned ? stats.spawned - prev.spawned : stats.spawned;
+        expired += stats.expired >= prev.expired ? stats.expired - prev.expired : stats.expired;
+        s_profiledStats[i] = stats;
+    }
+    RecordProfileCounter(ProfileCounter::LIVE_PARTICLES, live);
+    RecordProfileCounter(ProfileCounter::PIXELS_WRITTEN, pixels);
+    RecordProfileCounter(ProfileCounter::SPAWNED, spawned);
+    RecordProfileCounter(ProfileCounter::EXPIRED, expired);
+}
+#endif
+
+//---------------------------------------------------
+// DrawFrame
+//  Draws every particle into g_framebuffer, which still holds the frame
+//  that wrote "prevDrawn", and replaces prevDrawn with this frame's
+//  region. Positions are interpolated by "alpha" (see
+//  DrawParticlesToTarget).
+//---------------------------------------------------
+static void DrawFrame(DirtyRegion& prevDrawn, float alpha)
+{
+    MT_PROFILE_SCOPE(ProfileStage::DRAW);
+#if MT_ENABLE_PROFILING
+    const uint64_t drawStart = ProfileNowNs();
+#endif
+    BeginSpriteFrame();
+    s_drawDetail = GetDetailLevel();
+
+    // Fire and sparks draw particle i of this frame from stream
+    // (s_drawSeed, i), whichever thread or tile ends up drawing it.
+    s_drawSeed = ThreadRng().NextU32();
+
+    // Move the blue noise so smoke keeps flickering from frame to frame
+    s_noiseOffsetX = static_cast<int>(s_drawSeed) & (BLUE_NOISE_SIZE - 1);
+    s_noiseOffsetY = static_cast<int>(s_drawSeed >> 8) & (BLUE_NOISE_SIZE - 1);
+
+    DirtyRegion drawn;
+    ClearDirtyRegion(drawn);
+    s_drawItems.clear();
+    Effects::ForEach([&](auto effect) { CollectDrawItems<decltype(effect)>(alpha, drawn); });
+
+    // Clear only what the previous frame drew; everything else in the
+    // DIB is already transparent.
+    g_frameStats.bytesCleared = GetDirtyArea(prevDrawn) * sizeof(unsigned int);
+
+    if (GetWorkerThreadCount() > 1 && s_drawItems.size() >= PARALLEL_DRAW_MIN_ITEMS) {
+        s_clearRegion = &prevDrawn;
+        BinDrawItems();
+        ParallelFor(s_tileItems.size(), DrawTile, nullptr);
+    } else {
+        for (int i = 0; i < prevDrawn.count; i++) {
+            ClearRect(prevDrawn.rects[i]);
+        }
+        Effects::ForEach([](auto effect) { DrawItems<decltype(effect)>(); });
+    }
+
+#if MT_ENABLE_PROFILING
+    RecordDrawProfile(drawStart, drawn);
+#endif
+    prevDrawn = drawn;
+}
+
+//---------------------------------------------------
+// DrawParticlesToDIB (Now draws full shapes, not single pixels)
+//---------------------------------------------------
+void DrawParticlesToDIB()
+{
+    if (!g_framebuffer.pixels) return;
+
+    // Pixels that changed on screen: this frame's drawing plus the
+    // previous frame's drawing that gets cleared.
+    RecordSession(SessionRecordType::DRAW, 1.0f);
+    g_dirtyRegion = s_prevDrawnRegion;
+    DrawFrame(s_prevDrawnRegion, 1.0f);
+    AddDirtyRegion(g_dirtyRegion, s_prevDrawnRegion);
+}
+
+//---------------------------------------------------
+// DrawParticlesToTarget
+//---------------------------------------------------
+void DrawParticlesToTarget(FrameTarget& target, float alpha)
+{
+    g_framebuffer = target.fb;
+    if (!g_framebuffer.pixels) return;
+
+    RecordSession(SessionRecordType::DRAW, alpha);
+    DrawFrame(target.drawn, alpha);
+}
+
+//---------------------------------------------------
+// SetDrawThreadCount / GetDrawThreadCount
+//---------------------------------------------------
+void SetDrawThreadCount(int count)
+{
+    SetWorkerThreadCount(count);
+}
+
+int GetDrawThreadCount()
+{
+    return GetWorkerThreadCount();
+}
+
+//---------------------------------------------------
+// SetFramebuffer
+//---------------------------------------------------
+void SetFramebuffer(const Framebuffer& fb)
+{
+    g_framebuffer = fb;
+    ResetDirtyTracking();
+}
+
+//---------------------------------------------------
+// ResetDirtyTracking
+//  A new framebuffer is expected to be zero-filled, so nothing needs
+//  clearing; the whole surface must be presented once though.
+//---------------------------------------------------
+void ResetDirtyTracking()
+{
+    ClearDirtyRegion(s_prevDrawnRegion);
+    ClearDirtyRegion(g_dirtyRegion);
+
+    Rect full = { 0, 0, g_framebuffer.width, g_framebuffer.height };
+    AddDirtyRect(g_dirtyRegion, full);
+}
+
+
@@ -1,835 +1,638 @@
 // src/particles.cpp
 #include "particles.h"
-#include "window.h"   // For g_ScreenWidth, g_ScreenHeight, g_pPixels
+#include "effect_policies.h"
 #include "utils.h"
+#include "update_kernels.h"
+#include "force_field.h"
+#include "rng.h"
+#include "frame_profiler.h"
+#include "session_record.h"
 #include <cmath>
 #include <algorithm>
-#include <cstdlib>   // rand()
 
 // Global Variables
-std::vector<Particle> g_particles;
+ParticlePool g_pools[PARTICLE_TYPE_COUNT] = {
+    ParticlePool(ParticleType::HEARTS, MAX_PARTICLES),
+    ParticlePool(ParticleType::STARS,  MAX_PARTICLES),
+    ParticlePool(ParticleType::FIRE,   MAX_PARTICLES),
+    ParticlePool(ParticleType::SPARKS, MAX_PARTICLES),
+    ParticlePool(ParticleType::SMOKE,  MAX_PARTICLES),
+    ParticlePool(ParticleType::SWORD,  MAX_PARTICLES),
+};
 ParticleType g_activeParticleSystem = ParticleType::SMOKE;
-POINT g_lastMousePos = { -1, -1 };
+Point g_lastMousePos = { -1, -1 };
 std::chrono::steady_clock::time_point g_lastFrameTime = std::chrono::steady_clock::now();
 
+static CursorSourceFn s_cursorSource = nullptr;
+
+static float s_detailLevel = 1.0f; // See SetDetailLevel
+
+static CursorEventQueue* s_cursorQueue = nullptr;
+static double s_spawnUntil = 0.0;
+static CursorPathJoin s_pathJoin;      // Last two events walked
+static std::vector<CursorEvent> s_stepEvents;
+static CursorPath s_cursorPath;        // Where the cursor went since the last spawn
+
+// SpawnAtCursor: queued travel since its last particle (reset by ClearParticles)
+static float s_spawnTravel = 0.f;
+static double s_lastSpawnTime = 0.0;
+
 //---------------------------------------------------
-// SetActiveParticleSystem
-//  systemId: 1=Hearts, 2=Stars, 3=Fire, 4=Sparks, 5=Smoke 6=SWORD
+// SetCursorSource
+//  The front end injects where cursor positions come from
+//  (GetCursorPos on Windows, a synthetic path when headless).
 //---------------------------------------------------
-void SetActiveParticleSystem(int systemId)
+void SetCursorSource(CursorSourceFn source)
 {
-    switch (systemId) {
-        case 1: g_activeParticleSystem = ParticleType::SMOKE; break;
-        case 2: g_activeParticleSystem = ParticleType::STARS;  break;
-        case 3: g_activeParticleSystem = ParticleType::FIRE;   break;
-        case 4: g_activeParticleSystem = ParticleType::SPARKS; break;
-        case 5: g_activeParticleSystem = ParticleType::HEARTS;  break;
-		case 6: g_activeParticleSystem = ParticleType::SWORD;  break;
-        default:
-            g_activeParticleSystem = ParticleType::SMOKE;
-            break;
-    }
+    s_cursorSource = source;
 }
 
-//---------------------------------------------------
-// SpawnParticlesOnMouseMove
-//---------------------------------------------------
-void SpawnParticlesOnMouseMove()
+static bool ReadCursor(Point* pt)
 {
-    switch (g_activeParticleSystem) {
-        case ParticleType::SMOKE:  SpawnSmokeOnMouseMove(); break;
-        case ParticleType::STARS:   SpawnStarsOnMouseMove();  break;
-        case ParticleType::FIRE:    SpawnFireOnMouseMove();   break;
-        case ParticleType::SPARKS:  SpawnSparksOnMouseMove(); break;
-        case ParticleType::HEARTS:   SpawnHeartsOnMouseMove();  break;
-		case ParticleType::SWORD:   SpawnSwordOnMouseMove();  break;
-		
-    }
+    return s_cursorSource && s_cursorSource(pt);
 }
 
 //---------------------------------------------------
-// Particle Rendering (Draw Functions)
+// SetCursorEventQueue / SpawnParticlesUntil
 //---------------------------------------------------
-void DrawShape(const Particle& p, const unsigned char* mask, int width, int height);
-void DrawStar(const Particle& p);
-void DrawFire(const Particle& p);
-void DrawSparks(const Particle& p);
-void DrawSmoke(const Particle& p);
-void DrawSword(const Particle& p);
-
+void SetCursorEventQueue(CursorEventQueue* queue)
+{
+    s_cursorQueue = queue;
+    s_pathJoin.count = 0;
+}
 
-//---------------------------------------------------
-// Common function: calculates # of particles
-//  and interpolates spawn positions along the mouse path
-//---------------------------------------------------
-static void SpawnParticlesCommon(ParticleType type,
-                                 float distBetweenParticles,
-                                 COLORREF (*colorFunc)(),
-                                 float minLife, float maxLife,
-                                 float scaleMin, float scaleMax,
-                                 bool allowRotation,
-                                 bool upwardVelocityBias = true)
-{
-    POINT pt;
-    GetCursorPos(&pt);
-
-    // If first time, just store the last pos
-    if (g_lastMousePos.x == -1 && g_lastMousePos.y == -1) {
-        g_lastMousePos = pt;
-        return;
-    }
+CursorEventQueue* GetCursorEventQueue()
+{
+    return s_cursorQueue;
+}
 
-    float dx = static_cast<float>(pt.x - g_lastMousePos.x);
-    float dy = static_cast<float>(pt.y - g_lastMousePos.y);
-    float dist = std::sqrt(dx * dx + dy * dy);
-
-    if (dist > 0.f) {
-        int numParticles = std::max(1, static_cast<int>(dist / distBetweenParticles));
-        for (int i = 0; i < numParticles; i++) {
-            float t = (i + 1) / static_cast<float>(numParticles + 1);
-
-            Particle p = {};
-            p.x = g_lastMousePos.x + t * dx;
-            p.y = g_lastMousePos.y + t * dy;
-
-            // Random angle & speed
-            float angle = ((rand() % 360) / 180.0f) * 3.14159f;
-            float speed = 25.f + (rand() % 30); // default: 25..55
-            if (!upwardVelocityBias) {
-                // Use normal random velocity, no forced negative vy
-                p.vx = speed * cosf(angle) * 0.5f;
-                p.vy = speed * sinf(angle) * 0.5f;
-            } else {
-                // Negative vy for upward bias
-                p.vx = speed * cosf(angle) * 0.5f;
-                p.vy = -fabsf(speed * sinf(angle));
-            }
-
-            // Use color function
-            if (colorFunc) {
-                p.color = colorFunc();
-            } else {
-                // default to white if no colorFunc is specified
-                p.color = 0xFFFFFF;
-            }
-
-            // Life
-            float lifeRange = maxLife - minLife;
-            float chosenLife = minLife + (rand() / (float)RAND_MAX) * lifeRange;
-            p.maxLife = chosenLife;
-            p.life    = chosenLife;
-
-            // Scale
-            float chosenScale = scaleMin + (rand() / (float)RAND_MAX) * (scaleMax - scaleMin);
-            p.scale = chosenScale;
-
-            // Rotation
-            if (allowRotation) {
-                p.angle = static_cast<float>(rand() % 360) * 3.14159f / 180.0f;
-                // rotation speed from -3..3
-                p.rotationSpeed = ((rand() % 601) - 300) / 100.0f;
-            } else {
-                p.angle = 0.f;
-                p.rotationSpeed = 0.f;
-            }
-
-            p.type = type;
-            g_particles.push_back(p);
-        }
-    }
-    g_lastMousePos = pt;
+void SpawnParticlesUntil(double time)
+{
+    s_spawnUntil = time;
+    SpawnParticlesOnMouseMove();
 }
 
 //---------------------------------------------------
-// 1) Hearts
+// GatherCursorPath
+//  Fills s_cursorPath with the cursor's way from where the last spawn
+//  left off. Sampling gives a straight line to the current position;
+//  queued events give the curve through every move. False on the very
+//  first position (nothing to connect it to yet).
 //---------------------------------------------------
-void SpawnHeartsOnMouseMove()
+static bool GatherCursorPath()
 {
+    if (!s_cursorQueue) {
+        Point pt;
+        if (!ReadCursor(&pt)) {
+            RecordSession(SessionRecordType::NO_CURSOR);
+            return false;
+        }
+        if (IsRecordingSession()) {
+            SessionRecord record = {};
+            record.type = SessionRecordType::CURSOR_SAMPLE;
+            record.x = pt.x;
+            record.y = pt.y;
+            RecordSession(record);
+        }
 
+        // If first time, just store the last pos
+        if (g_lastMousePos.x == -1 && g_lastMousePos.y == -1) {
+            g_lastMousePos = pt;
+            return false;
+        }
 
-    auto colorFn = []() -> COLORREF {
-        return RandomHeartColor(); 
-    };
-
-    POINT pt;
-    GetCursorPos(&pt);
-
-    // First time: Just store position, don't spawn yet
-    if (g_lastMousePos.x == -1 && g_lastMousePos.y == -1) {
+        CursorEvent ends[2] = {};
+        ends[0].x = static_cast<float>(g_lastMousePos.x);
+        ends[0].y = static_cast<float>(g_lastMousePos.y);
+        ends[1].x = static_cast<float>(pt.x);
+        ends[1].y = static_cast<float>(pt.y);
+        FlattenCursorPath(ends, 2, 0, s_cursorPath);
         g_lastMousePos = pt;
-        return;
+        return true;
     }
 
-    float dx = static_cast<float>(pt.x - g_lastMousePos.x);
-    float dy = static_cast<float>(pt.y - g_lastMousePos.y);
-    float dist = sqrtf(dx * dx + dy * dy);
-
-    if (dist > 5.0f) // Ensures movement before spawning
-    {
-        Particle p = {};
-        p.x = pt.x;
-        p.y = pt.y;
-
-        // **Make each heart move fast & spread widely**
-        float angle = ((rand() % 160) - 80) * (3.14159f / 180.0f); // Wide spread
-        float speed = 150.f + (rand() % 50);  // **Much faster**
-        p.vx = speed * cosf(angle);
-        p.vy = -fabsf(speed * sinf(angle)); // Move upwards
-
-        // **Prevent overlapping**
-        p.x += (rand() % 50) - 30;  // Slight horizontal offset
-        p.y += (rand() % 50) - 30;  // Slight vertical offset
-
-        p.color = colorFn();
-        p.maxLife = 0.9f; // **Longer lifespan**
-        p.life = p.maxLife;
-        p.scale = 1.0f + (rand() % 100) / 200.0f; // Slight variation in size
-        p.angle = static_cast<float>(rand() % 360) * 3.14159f / 180.0f;
-        p.rotationSpeed = ((rand() % 601) - 300) / 100.0f; 
-
-        p.type = ParticleType::HEARTS;
-        g_particles.push_back(p);
+    // The previous path's last event starts this one; the event before
+    // it keeps the tangent continuous across the join.
+    s_stepEvents.assign(s_pathJoin.events, s_pathJoin.events + s_pathJoin.count);
+    CursorEvent e;
+    while (s_cursorQueue->PopUntil(s_spawnUntil, &e)) {
+        if (IsRecordingSession()) {
+            SessionRecord record = {};
+            record.type = SessionRecordType::CURSOR_EVENT;
+            record.time = e.time;
+            record.x = static_cast<int>(std::lround(e.x));
+            record.y = static_cast<int>(std::lround(e.y));
+            RecordSession(record);
+        }
+        s_stepEvents.push_back(e);
     }
+    if (s_stepEvents.size() == static_cast<size_t>(s_pathJoin.count)) return false;
 
-    g_lastMousePos = pt;
+    g_lastMousePos.x = static_cast<int>(std::lround(e.x));
+    g_lastMousePos.y = static_cast<int>(std::lround(e.y));
+    return ContinueCursorPath(s_pathJoin, s_stepEvents, s_cursorPath);
 }
 
-
-
-
-//---------------------------------------------------
-// 2) Stars
-//---------------------------------------------------
-void SpawnStarsOnMouseMove()
-{
-    // Sparkly star color
-    auto colorFn = []() -> COLORREF {
-        // White/yellowish
-        return RGB(200 + rand() % 56, 200 + rand() % 56, 180 + rand() % 76);
-    };
-
-    // More distance => fewer stars
-    // life ~0.7..1.0, scale ~1.5..2.5
-    SpawnParticlesCommon(
-        ParticleType::STARS,
-        10.0f,
-        colorFn,
-        0.3f, 0.5f,
-        0.5f, 1.5f,
-        true,   // rotation
-        true    // upward velocity bias
-    );
+// Seconds since the cursor passed "point", as far as this spawn is concerned
+static float SpawnAge(const CursorPathVertex& point)
+{
+    if (!s_cursorQueue) return 0.f;
+    float age = static_cast<float>(s_spawnUntil - point.time);
+    return std::min(std::max(age, 0.f), MAX_SPAWN_AGE_SECONDS);
 }
 
 //---------------------------------------------------
-// 3) Fire
+// SetActiveParticleSystem
+//  systemId: the effect's SYSTEM_ID (1=Smoke, 2=Stars, 3=Fire,
+//  4=Sparks, 5=Hearts, 6=Sword); anything else picks smoke.
 //---------------------------------------------------
-void SpawnFireOnMouseMove()
+void SetActiveParticleSystem(int systemId)
 {
-    auto colorFn = []() -> COLORREF {
-        int r = 200 + (rand() % 56);  // 200..255
-        int g = 50 + (rand() % 80);   // 50..129
-        int b = 0;                    // No blue
-        return RGB(r, g, b);
-    };
-
-	SpawnParticlesCommon(
-		ParticleType::FIRE,
-		4.0f,  //  Spawn more fire particles per movement (Before: 4.0f)
-		colorFn,
-		0.3f, 0.5f,   //  Slightly longer lifespan
-		1.0f, 1.1f,  //  MASSIVE FLAMES (Before: 5.0f, 9.0f)
-		false,
-		false
-	);
-
+    RecordSession(SessionRecordType::EFFECT, systemId);
+    g_activeParticleSystem = ParticleType::SMOKE;
+    Effects::ForEach([systemId](auto effect) {
+        using Effect = decltype(effect);
+        if (Effect::SYSTEM_ID == systemId) g_activeParticleSystem = Effect::TYPE;
+    });
 }
 
 //---------------------------------------------------
-// 4) Sparks (Chaotic arcs)
+// SpawnAlongPath
+//  Spaces particles evenly along the mouse path, SPAWN_SPACING apart.
 //---------------------------------------------------
-void SpawnSparksOnMouseMove()
-{
-    // Electric arcs: bright bluish/purple
-    auto colorFn = []() -> COLORREF {
-		int r = 0;   
-        int g = 100 + (rand() % 56);
-        int b = 200 + (rand() % 56);
-                         
-        return RGB(r, g, b);
-    };
-
-    // Sparks: short life, small scale but rotate quickly
-    // We'll keep upwardVelocityBias = false for chaotic outward fling
-    SpawnParticlesCommon(
-        ParticleType::SPARKS,
-        2.0f,
-        colorFn,
-        0.1f, 0.2f,  // short life
-        1.0f, 2.0f,  // scale
-        true,        // yes rotation
-        false        // no upward bias
-    );
+template <class Effect>
+static void SpawnAlongPath()
+{
+    if (!GatherCursorPath()) return;
+
+    float dist = s_cursorPath.Length();
+    if (dist <= 0.f) return;
+
+    Rng& rng = ThreadRng();
+    ParticlePool& pool = GetPool(Effect::TYPE);
+    // Sparser at lower detail
+    const float spacing = Effect::SPAWN_SPACING / s_detailLevel;
+    int numParticles = std::max(1, static_cast<int>(dist / spacing));
+    for (int i = 0; i < numParticles; i++) {
+        float t = (i + 1) / static_cast<float>(numParticles + 1);
+
+        CursorPathVertex at = s_cursorPath.PointAt(t);
+        Particle p = SpawnAlongPathParticle<Effect>(at.x, at.y, SpawnAge(at), rng);
+        if (pool.Push(p)) Effect::InitShape(pool, pool.Size() - 1, rng);
+    }
 }
 
 //---------------------------------------------------
-// 5) Smoke
+// SpawnAtCursor
+//  One particle where the cursor ended up, once it has moved more than
+//  MIN_TRAVEL.
 //---------------------------------------------------
-void SpawnSmokeOnMouseMove()
-{
-    // Smoke color: grayish
-    auto colorFn = []() -> COLORREF {
-        int shade = 100 + rand() % 100; // 100..199
-        return RGB(shade, shade, shade);
-    };
-
-    // Smoke: bigger scale, medium life, no rotation
-    // Upward velocity bias so it drifts upward
-    SpawnParticlesCommon(
-        ParticleType::SMOKE,
-        10.0f,
-        colorFn,
-        0.3f, 0.5f,
-        1.0f, 1.5f,   // bigger scale
-        false,        // no rotation
-        true          // upward velocity
-    );
+template <class Effect>
+static void SpawnAtCursor()
+{
+    // First time: Just store position, don't spawn yet
+    if (!GatherCursorPath()) return;
+
+    const CursorPathVertex& end = s_cursorPath.vertices.back();
+    float dist = s_cursorPath.Length();
+
+    // Queued input arrives in short per-step pieces: add them up and
+    // keep to one particle per SPAWN_INTERVAL, as sampling at 60 fps did.
+    if (s_cursorQueue) {
+        s_spawnTravel += dist;
+        if (end.time - s_lastSpawnTime < Effect::SPAWN_INTERVAL) return;
+        dist = s_spawnTravel;
+        s_spawnTravel = 0.f;
+        s_lastSpawnTime = end.time;
+    }
+    if (dist <= Effect::MIN_TRAVEL) return;
+
+    Rng& rng = ThreadRng();
+    Particle p = SpawnAtCursorParticle<Effect>(end.x, end.y, SpawnAge(end), rng);
+    ParticlePool& pool = GetPool(Effect::TYPE);
+    if (pool.Push(p)) Effect::InitShape(pool, pool.Size() - 1, rng);
 }
 
 //---------------------------------------------------
-// 6) Sword
+// SpawnParticlesOnMouseMove
 //---------------------------------------------------
-void SpawnSwordOnMouseMove()
-{
-    // Sword color:
-	// Smoke color: grayish
-    auto colorFn = []() -> COLORREF {
-        int shade = 100;
-        return RGB(shade, shade, shade);
-    };
-	 
-    // Sword: bigger scale, medium life, no rotation
-    // Upward velocity bias so it drifts upward
-    SpawnParticlesCommon(
-        ParticleType::SWORD,
-        10.0f,
-        colorFn,
-        0.3f, 0.5f,
-        0.5f, 0.5f,   // bigger scale
-        true,        // no rotation
-        true          // upward velocity
-    );
+void SpawnParticlesOnMouseMove()
+{
+    MT_PROFILE_SCOPE(ProfileStage::SPAWN);
+    Effects::With(g_activeParticleSystem, [](auto effect) {
+        using Effect = decltype(effect);
+        if constexpr (Effect::SPAWN == SpawnPattern::AT_CURSOR) {
+            SpawnAtCursor<Effect>();
+        } else {
+            SpawnAlongPath<Effect>();
+        }
+    });
+    // After the cursor records it consumed, so a replay has them queued
+    if (IsRecordingSession()) {
+        SessionRecord record = {};
+        record.type = SessionRecordType::SPAWN;
+        record.time = s_spawnUntil;
+        RecordSession(record);
+    }
 }
 
 //---------------------------------------------------
-// UpdateParticles
+// ParticlePool
 //---------------------------------------------------
-void UpdateParticles(float dt)
-{
-    for (auto &p : g_particles) {
-        // Special behavior for hearts
-        if (p.type == ParticleType::HEARTS) {
-            // Increase speed to spread them out more
-            p.vx *= 1.01f;  // Increase horizontal movement
-            p.vy *= 1.03f;  // Increase vertical movement
-
-            // Add slight random drift to make them float more naturally
-            p.vx += (rand() % 5 - 2) * 0.05f;
+#define PALETTE_SEED 0x9A1E77Eull // Palettes are the same in every run
 
-            // Reduce gravity effect so they do not fall too fast
-            p.vy -= 5.0f * dt;
-        }
-
-        // Update position
-        p.x += p.vx * dt;
-        p.y += p.vy * dt;
+// The effect's range of lives (AT_CURSOR effects have one)
+template <class Effect>
+static void EffectLifeRange(float* lifeMin, float* lifeMax)
+{
+    if constexpr (Effect::SPAWN == SpawnPattern::AT_CURSOR) {
+        *lifeMin = *lifeMax = Effect::LIFE;
+    } else {
+        *lifeMin = Effect::LIFE_MIN;
+        *lifeMax = Effect::LIFE_MAX;
+    }
+    static_assert(Effect::SCALE_MAX * 16384 < 65536, "scale exceeds PARTICLE_SCALE_UNIT's range");
+}
 
-        // Apply gravity for other particles
-        if (p.type != ParticleType::FIRE && p.type != ParticleType::HEARTS) {
-            p.vy += 20.f * dt;
+ParticlePool::ParticlePool(ParticleType type, size_t capacity)
+    : type(type), policy(OverflowPolicy::EVICT_OLDEST), lifeMin(0.f), lifeStep(0.f),
+      stepDt(0.f), stepGravityDv(0.f), count(0), limit(0), stats()
+{
+    Effects::With(type, [this](auto effect) {
+        using Effect = decltype(effect);
+        float lifeMax;
+        EffectLifeRange<Effect>(&lifeMin, &lifeMax);
+        lifeStep = (lifeMax - lifeMin) / 255.0f;
+
+        Rng rng(PALETTE_SEED, PoolIndex(Effect::TYPE));
+        for (Color& color : palette) {
+            color = Effect::MakeColor(rng);
         }
+    });
+    SetCapacity(capacity);
+}
 
-        // Rotate particles unless they are fire or smoke
-        if (p.type != ParticleType::FIRE && p.type != ParticleType::SMOKE) {
-            p.angle += p.rotationSpeed * dt;
-        }
+void ParticlePool::SetCapacity(size_t capacity)
+{
+    x.assign(capacity, 0.f);
+    y.assign(capacity, 0.f);
+    vx.assign(capacity, 0.f);
+    vy.assign(capacity, 0.f);
+    life.assign(capacity, 0);
+    lifeSpan.assign(capacity, 0);
+    scale.assign(capacity, 0);
+    spawnAngle.assign(capacity, 0);
+    spin.assign(capacity, 0);
+    paletteIndex.assign(capacity, 0);
+    arcs.assign(type == ParticleType::SPARKS ? capacity : 0, SparkArcs());
+    evictScratch.reserve(capacity);
+    count = 0;
+    limit = capacity;
+    stats.live = 0;
+    stats.capacity = capacity;
+}
 
-        // Decrease life over time
-        p.life -= dt;
+void ParticlePool::SetLimit(size_t newLimit)
+{
+    limit = std::min(newLimit, Capacity());
+}
 
-        // Smooth fade-out effect by scaling down over time
-        float ratio = (p.life > 0.f) ? (p.life / p.maxLife) : 0.f;
-        float fadeFactor = 1.0f - powf(1.0f - ratio, 3.0f);  // Smooth fade effect
-		p.scale = p.scale * fadeFactor;  // Scale relative to original size
+// Nearest step of "unit" in [lo, hi]
+static int Quantize(float value, float unit, int lo, int hi)
+{
+    const long steps = std::lround(value / unit);
+    return static_cast<int>(std::min<long>(std::max<long>(steps, lo), hi));
+}
 
+bool ParticlePool::Push(const Particle& p)
+{
+    size_t i;
+    if (Reserve(1, &i) == 0) return false;
+    Store(i, p);
+    return true;
+}
 
+size_t ParticlePool::Reserve(size_t n, size_t* first)
+{
+    if (count + n > limit) {
+        if (policy == OverflowPolicy::DROP_NEW || limit == 0) {
+            const size_t room = (count < limit) ? limit - count : 0;
+            stats.dropped += n - room;
+            n = room;
+        } else {
+            const size_t fits = std::min(n, limit);
+            stats.dropped += n - fits;
+            n = fits;
+            if (count + n > limit) EvictBatch(n);
+        }
     }
 
-    // Remove expired particles
-    g_particles.erase(
-        std::remove_if(g_particles.begin(), g_particles.end(),
-            [](const Particle &p){ return (p.life <= 0.f); }),
-        g_particles.end()
-    );
+    *first = count;
+    count += n;
+    stats.spawned += n;
+    stats.live = count;
+    if (count > stats.peak) stats.peak = count;
+    return n;
 }
 
+void ParticlePool::Store(size_t i, const Particle& p)
+{
+    x[i]  = p.x;
+    y[i]  = p.y;
+    vx[i] = p.vx;
+    vy[i] = p.vy;
+    const int span = (lifeStep > 0.f) ? Quantize(p.maxLife - lifeMin, lifeStep, 0, 255) : 0;
+    lifeSpan[i] = static_cast<uint8_t>(span);
+    // Never more than maxLife: the fade assumes life <= maxLife
+    const int maxLifeUnits = static_cast<int>(MaxLife(i) / PARTICLE_LIFE_UNIT);
+    life[i]  = static_cast<uint16_t>(Quantize(p.life, PARTICLE_LIFE_UNIT, 0, std::min(maxLifeUnits, 65535)));
+    scale[i] = static_cast<uint16_t>(Quantize(p.scale, PARTICLE_SCALE_UNIT, 0, 65535));
+    spawnAngle[i] = static_cast<uint8_t>(std::lround(p.angle * (PARTICLE_ANGLE_STEPS / 6.2831853f)) &
+                                         (PARTICLE_ANGLE_STEPS - 1));
+    spin[i] = static_cast<int8_t>(Quantize(p.rotationSpeed, PARTICLE_SPIN_UNIT, -127, 127));
+    paletteIndex[i] = p.paletteIndex;
+}
 
+Particle ParticlePool::Get(size_t i) const
+{
+    Particle p;
+    p.x             = x[i];
+    p.y             = y[i];
+    p.vx            = vx[i];
+    p.vy            = vy[i];
+    p.life          = Life(i);
+    p.maxLife       = MaxLife(i);
+    p.paletteIndex  = paletteIndex[i];
+    p.color         = palette[p.paletteIndex];
+    p.rotationSpeed = spin[i] * PARTICLE_SPIN_UNIT;
+    p.angle         = spawnAngle[i] * (6.2831853f / PARTICLE_ANGLE_STEPS) + p.rotationSpeed * (p.maxLife - p.life);
+    p.scale         = scale[i] * PARTICLE_SCALE_UNIT;
+    p.type          = type;
+    return p;
+}
 
-//---------------------------------------------------
-// DrawParticlesToDIB
-//  Currently draws them as single pixels. If you want
-//  shape masks (hearts, stars, etc.), see earlier examples
-//---------------------------------------------------
-// Heart Mask (16x16)
-// 10x11 Heart Mask (More Defined and Larger)
-static const unsigned char HEART_MASK[10 * 11] = {
-    0,0,0,1,1,0,0,0,1,1,0, 
-    0,0,1,1,1,1,0,1,1,1,1, 
-    0,1,1,1,1,1,1,1,1,1,1, 
-    1,1,1,1,1,1,1,1,1,1,1, 
-    1,1,1,1,1,1,1,1,1,1,1, 
-    0,1,1,1,1,1,1,1,1,1,0, 
-    0,0,1,1,1,1,1,1,1,0,0, 
-    0,0,0,1,1,1,1,1,0,0,0, 
-    0,0,0,0,1,1,1,0,0,0,0, 
-    0,0,0,0,0,1,0,0,0,0,0  
-};
-
+void ParticlePool::MoveEntry(size_t from, size_t to)
+{
+    x[to]            = x[from];
+    y[to]            = y[from];
+    vx[to]           = vx[from];
+    vy[to]           = vy[from];
+    life[to]         = life[from];
+    lifeSpan[to]     = lifeSpan[from];
+    scale[to]        = scale[from];
+    spawnAngle[to]   = spawnAngle[from];
+    spin[to]         = spin[from];
+    paletteIndex[to] = paletteIndex[from];
+    if (!arcs.empty()) arcs[to] = arcs[from];
+}
 
-// 16x16 Star Mask
-static const unsigned char STAR_MASK[16 * 16] = {
-    // Row  0: 1 at col0, col7, col15
-    1,0,0,0,0,0,0,1,0,0,0,0,0,0,0,1,
-    // Row  1: 1 at col1, col7, col14
-    0,1,0,0,0,0,0,1,0,0,0,0,0,0,1,0,
-    // Row  2: 1 at col2, col7, col13
-    0,0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,
-    // Row  3: 1 at col3, col7, col12
-    0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,
-    // Row  4: 1 at col4, col7, col11
-    0,0,0,0,1,0,0,1,0,0,0,1,0,0,0,0,
-    // Row  5: 1 at col5, col7, col10
-    0,0,0,0,0,1,0,1,0,0,1,0,0,0,0,0,
-    // Row  6: 1 at col6, col7, col9
-    0,0,0,0,0,0,1,1,0,1,0,0,0,0,0,0,
-    // Row  7: (center row) all 1’s for a bold horizontal arm
-    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
-    // Row  8: 1 at col7 and col8
-    0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,
-    // Row  9: 1 at col6, col7, col9
-    0,0,0,0,0,0,1,1,0,1,0,0,0,0,0,0,
-    // Row 10: 1 at col5, col7, col10
-    0,0,0,0,0,1,0,1,0,0,1,0,0,0,0,0,
-    // Row 11: 1 at col4, col7, col11
-    0,0,0,0,1,0,0,1,0,0,0,1,0,0,0,0,
-    // Row 12: 1 at col3, col7, col12
-    0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,
-    // Row 13: 1 at col2, col7, col13
-    0,0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,
-    // Row 14: 1 at col1, col7, col14
-    0,1,0,0,0,0,0,1,0,0,0,0,0,0,1,0,
-    // Row 15: 1 at col0, col7, col15
-    1,0,0,0,0,0,0,1,0,0,0,0,0,0,0,1
-};
+void ParticlePool::Remove(size_t i)
+{
+    // Swap-remove: the last entry fills the hole
+    count--;
+    if (i != count) MoveEntry(count, i);
+    stats.live = count;
+}
 
+void ParticlePool::RemoveExpired()
+{
+    size_t i = 0;
+    while (i < count) {
+        if (life[i] == 0) {
+            Remove(i);   // Re-examine slot i: it now holds the former last entry
+            stats.expired++;
+        } else {
+            i++;
+        }
+    }
+}
 
+void ParticlePool::Clear()
+{
+    count = 0;
+    stepDt = 0.f;
+    stepGravityDv = 0.f;
+    stats.live = 0;
+}
 
 //---------------------------------------------------
-// Draw a Masked Shape (For Hearts & Stars)
+// EvictBatch
+//  Frees a batch of slots (1/64 of the capacity) in one O(n) selection
+//  pass, so eviction costs O(1) per spawn amortized instead of a full
+//  scan for every particle that arrives while the pool is full. The
+//  batch also takes whatever "incoming" new entries (at most the limit)
+//  need beyond that, e.g. after the limit was lowered.
 //---------------------------------------------------
-void DrawShape(const Particle& p, const unsigned char* mask, int width, int height)
-{
-    unsigned int* dst = static_cast<unsigned int*>(g_pPixels);
-    const float cx = width / 2.0f;
-    const float cy = height / 2.0f;
-
-    for (int j = 0; j < height; j++) {
-        for (int i = 0; i < width; i++) {
-            if (mask[j * width + i] == 1) {
-                // Scale and rotate
-                float localX = (i - cx) * p.scale;
-                float localY = (j - cy) * p.scale;
-                float cosA = cosf(p.angle);
-                float sinA = sinf(p.angle);
-                float rotX = localX * cosA - localY * sinA;
-                float rotY = localX * sinA + localY * cosA;
-
-                // Final screen coordinates
-                int screenX = static_cast<int>(p.x + rotX);
-                int screenY = static_cast<int>(p.y + rotY);
-
-                if (screenX < 0 || screenX >= g_ScreenWidth ||
-                    screenY < 0 || screenY >= g_ScreenHeight) continue;
-
-                // Write pixel with full alpha
-                dst[screenY * g_ScreenWidth + screenX] = (0xFF << 24) | (p.color & 0xFFFFFF);
-
-                // **Fix holes: Fill adjacent pixels**
-                for (int dx = -1; dx <= 1; dx++) {
-                    for (int dy = -1; dy <= 1; dy++) {
-                        int nx = screenX + dx;
-                        int ny = screenY + dy;
-
-                        if (nx >= 0 && nx < g_ScreenWidth && ny >= 0 && ny < g_ScreenHeight) {
-                            dst[ny * g_ScreenWidth + nx] = (0xFF << 24) | (p.color & 0xFFFFFF);
-                        }
-                    }
-                }
-            }
-        }
+void ParticlePool::EvictBatch(size_t incoming)
+{
+    size_t batch = std::max<size_t>(1, Capacity() / 64);
+    batch = std::min(count, std::max(batch, count + incoming - limit));
+
+    // Smaller key = evicted first. Age is maxLife - life since life
+    // counts down from maxLife.
+    evictScratch.clear();
+    for (size_t i = 0; i < count; i++) {
+        float key = (policy == OverflowPolicy::EVICT_OLDEST) ? -(MaxLife(i) - Life(i)) : Life(i);
+        evictScratch.emplace_back(key, static_cast<uint32_t>(i));
+    }
+    std::nth_element(evictScratch.begin(), evictScratch.begin() + (batch - 1), evictScratch.end());
+
+    // Remove from the highest index down so swap-removes never move
+    // another victim.
+    std::sort(evictScratch.begin(), evictScratch.begin() + batch,
+              [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) {
+                  return a.second > b.second;
+              });
+    for (size_t k = 0; k < batch; k++) {
+        Remove(evictScratch[k].second);
     }
+    stats.evicted += batch;
 }
 
-
-
-
-
 //---------------------------------------------------
-// Draw Fire (Fast-Fading Triangle Flames)
+// Budgets and overflow policy
 //---------------------------------------------------
-void DrawFire(const Particle& p)
+// Pool limit at the current level of detail
+static size_t DetailLimit(size_t capacity)
 {
-    if (!g_pPixels) return;
-
-    unsigned int* dst = static_cast<unsigned int*>(g_pPixels);
-    
-    // 🔥 Reduce the number of flame triangles to prevent excessive writes
-    int numTriangles = 3 + (rand() % 3); // 3-5 small flames per particle
-
-    for (int i = 0; i < numTriangles; i++) {
-        float angle = ((rand() % 30) - 15) * (3.14159f / 180.0f);
-        float scale = p.scale * (0.5f + (rand() % 50) / 100.0f);  // 50%-100% scale flickering
-        int baseWidth = static_cast<int>(p.scale * 10);  // 🔥 Now directly using p.scale
-		int height = static_cast<int>(p.scale * 15);     // 🔥 Scaling fire flames properly
-
-
-        int tx = static_cast<int>(p.x) + (rand() % 4 - 2);
-        int ty = static_cast<int>(p.y) - (rand() % 6);  // Moves upwards slightly
-
-        // 🔥 Fire Color Gradient (Flame animation)
-        int phase = rand() % 3;
-        int r = 255;
-        int g = (phase == 0) ? (80 + rand() % 100) : (150 + rand() % 50);  // More orange-y tones
-        int b = 0;  // No blue
-
-        // Windows expects BGR, swap manually
-        unsigned int color = (0xFF << 24) | (r << 16) | (g << 8) | b;
-
-        // Triangle Shape
-        int p1x = tx;
-        int p1y = ty - height;
-        int p2x = tx - baseWidth / 2;
-        int p2y = ty;
-        int p3x = tx + baseWidth / 2;
-        int p3y = ty;
-
-        // Draw Triangle
-		
-		int dy = p2y - p1y;
-		if (dy == 0) return;
-
-        for (int y = p1y; y <= p2y; y++) {
-            float progress = (y - p1y) / (float)(p2y - p1y);
-            int leftX = p1x + static_cast<int>((p2x - p1x) * progress);
-            int rightX = p1x + static_cast<int>((p3x - p1x) * progress);
+    if (s_detailLevel >= 1.0f) return capacity;
+    return std::max<size_t>(1, static_cast<size_t>(capacity * s_detailLevel));
+}
 
-            for (int x = leftX; x <= rightX; x++) {
-                if (x < 0 || x >= g_ScreenWidth || y < 0 || y >= g_ScreenHeight) continue;
+void SetParticleBudget(ParticleType type, size_t budget)
+{
+    RecordSession(SessionRecordType::BUDGET, static_cast<int>(type), budget);
+    ParticlePool& pool = GetPool(type);
+    if (pool.Capacity() != budget) pool.SetCapacity(budget);
+    pool.SetLimit(DetailLimit(budget));
+}
 
-                // 🔥 Faster flickering brightness effect
-                float alpha = 0.5f + 0.5f * sinf(p.life * 15.0f); // Adjusted flicker rate
-                unsigned int finalColor = (static_cast<int>(alpha * 255) << 24) | (color & 0xFFFFFF);
+void SetOverflowPolicy(ParticleType type, OverflowPolicy policy)
+{
+    RecordSession(SessionRecordType::POLICY, static_cast<int>(type), static_cast<uint64_t>(policy));
+    GetPool(type).policy = policy;
+}
 
-                dst[y * g_ScreenWidth + x] = finalColor;
-            }
-        }
+void SetOverflowPolicy(OverflowPolicy policy)
+{
+    for (ParticlePool& pool : g_pools) {
+        SetOverflowPolicy(pool.type, policy);
     }
 }
 
+void SetDetailLevel(float detail)
+{
+    detail = std::min(1.0f, std::max(detail, 0.01f));
+    // The governor sets it every frame; record only changes
+    if (detail != s_detailLevel) RecordSession(SessionRecordType::DETAIL, detail);
+    s_detailLevel = detail;
+    for (ParticlePool& pool : g_pools) {
+        pool.SetLimit(DetailLimit(pool.Capacity()));
+    }
+}
 
+float GetDetailLevel()
+{
+    return s_detailLevel;
+}
 
-
-// Helper function to draw a line between two points using Bresenham's algorithm.
-void DrawLine(int x0, int y0, int x1, int y1, unsigned int color)
+PoolStats GetPoolStats(ParticleType type)
 {
-    int dx = abs(x1 - x0);
-    int dy = abs(y1 - y0);
-    int sx = (x0 < x1) ? 1 : -1;
-    int sy = (y0 < y1) ? 1 : -1;
-    int err = dx - dy;
+    return GetPool(type).stats;
+}
 
-    while (true) {
-        if (x0 >= 0 && x0 < g_ScreenWidth && y0 >= 0 && y0 < g_ScreenHeight) {
-            ((unsigned int*)g_pPixels)[y0 * g_ScreenWidth + x0] = color;
-        }
-        if (x0 == x1 && y0 == y1)
-            break;
-        int e2 = 2 * err;
-        if (e2 > -dy) { err -= dy; x0 += sx; }
-        if (e2 < dx) { err += dx; y0 += sy; }
+void ResetPoolStats()
+{
+    for (ParticlePool& pool : g_pools) {
+        pool.stats.peak = pool.Size();
+        pool.stats.spawned = 0;
+        pool.stats.dropped = 0;
+        pool.stats.evicted = 0;
+        pool.stats.expired = 0;
     }
 }
 
 //---------------------------------------------------
-// Draw Sparks (Chaotic Electric Arcs)
+// GetLiveParticleCount / ClearParticles
 //---------------------------------------------------
-void DrawSparks(const Particle& p)
-{
-    // Decide how many arms (arcs) to draw for this spark.
-    // For example, choose between 2 and 4 arms.
-    int numArms = 2 + (rand() % 3);  // 2, 3, or 4 arms
-
-    // Use the spark's color (with full alpha) for all arms.
-    unsigned int color = (0xFF << 24) | (p.color & 0xFFFFFF);
-
-    for (int arm = 0; arm < numArms; arm++) {
-        // For each arm, choose a random number of control points (segments).
-        int numPoints = 3 + (rand() % 4);  // 3 to 6 control points
-
-        // Choose a random arc length for this arm.
-        // For example, arc lengths will range between 10 and 40 pixels.
-        int arcLength = 10 + (rand() % 31);
-
-        // Pick a random overall angle (in radians) for the arm.
-        float angle = ((rand() % 360) * 3.14159f) / 180.0f;
-
-        // Starting point is the spark particle's position.
-        int startX = static_cast<int>(p.x);
-        int startY = static_cast<int>(p.y);
-
-        // Compute the end point based on the arc length and angle.
-        int endX = static_cast<int>(p.x + arcLength * cosf(angle));
-        int endY = static_cast<int>(p.y + arcLength * sinf(angle));
-
-        // Create an array to hold the control points.
-        // (You can also use a vector if preferred.)
-        POINT points[10];  // Ensure enough room (we use at most 6 points here)
-        points[0].x = startX;
-        points[0].y = startY;
-        points[numPoints - 1].x = endX;
-        points[numPoints - 1].y = endY;
-
-        // Generate intermediate control points.
-        for (int i = 1; i < numPoints - 1; i++) {
-            // t goes from 0 to 1 along the line between start and end.
-            float t = i / static_cast<float>(numPoints - 1);
-            // Base point by linear interpolation.
-            int baseX = static_cast<int>(p.x + t * (endX - p.x));
-            int baseY = static_cast<int>(p.y + t * (endY - p.y));
-
-            // Determine a perpendicular vector to the line from start to end.
-            float dx = endX - p.x;
-            float dy = endY - p.y;
-            float len = sqrtf(dx * dx + dy * dy);
-            float perpX = 0, perpY = 0;
-            if (len != 0) {
-                perpX = -dy / len;
-                perpY = dx / len;
-            }
-            // Random offset magnitude:
-            int offsetMagnitude = (rand() % (arcLength / 2 + 1)) - (arcLength / 4);
-            int offsetX = static_cast<int>(perpX * offsetMagnitude);
-            int offsetY = static_cast<int>(perpY * offsetMagnitude);
-
-            points[i].x = baseX + offsetX;
-            points[i].y = baseY + offsetY;
-        }
+size_t GetLiveParticleCount()
+{
+    size_t count = 0;
+    for (const ParticlePool& pool : g_pools) {
+        count += pool.Size();
+    }
+    return count;
+}
 
-        // Draw the arc by connecting successive control points.
-        for (int i = 0; i < numPoints - 1; i++) {
-            DrawLine(points[i].x, points[i].y, points[i + 1].x, points[i + 1].y, color);
+Rect GetParticleBounds()
+{
+    float minX = 0.f, minY = 0.f, maxX = -1.f, maxY = -1.f;
+    bool any = false;
+    for (const ParticlePool& pool : g_pools) {
+        const size_t count = pool.Size();
+        if (count == 0) continue;
+        if (!any) {
+            minX = maxX = pool.x[0];
+            minY = maxY = pool.y[0];
+            any = true;
         }
+        for (size_t i = 0; i < count; i++) {
+            const float prevX = pool.PrevX(i), prevY = pool.PrevY(i);
+            minX = std::min(minX, std::min(pool.x[i], prevX));
+            maxX = std::max(maxX, std::max(pool.x[i], prevX));
+            minY = std::min(minY, std::min(pool.y[i], prevY));
+            maxY = std::max(maxY, std::max(pool.y[i], prevY));
+        }
+    }
+
+    Rect bounds = { 0, 0, 0, 0 };
+    if (any) {
+        bounds.left   = static_cast<int>(std::floor(minX));
+        bounds.top    = static_cast<int>(std::floor(minY));
+        bounds.right  = static_cast<int>(std::floor(maxX)) + 1;
+        bounds.bottom = static_cast<int>(std::floor(maxY)) + 1;
     }
+    return bounds;
 }
 
-//---------------------------------------------------
-// Draw Smoke (Soft Puffs)
-//---------------------------------------------------
-//---------------------------------------------------
-// Draw Smoke (Improved Soft Puffs)
-//---------------------------------------------------
-void DrawSmoke(const Particle& p)
-{
-    unsigned int* dst = static_cast<unsigned int*>(g_pPixels);
-    
-    // Determine the "radius" of the smoke puff based on its scale.
-    int radius = static_cast<int>(p.scale * 8);
-    
-    // Loop over a square region that fully contains the smoke circle.
-    for (int dy = -radius; dy <= radius; dy++) {
-        for (int dx = -radius; dx <= radius; dx++) {
-            int screenX = static_cast<int>(p.x) + dx;
-            int screenY = static_cast<int>(p.y) + dy;
-            
-            // Skip drawing if we're outside the screen.
-            if (screenX < 0 || screenX >= g_ScreenWidth ||
-                screenY < 0 || screenY >= g_ScreenHeight)
-                continue;
-            
-            // Compute the distance from the center of the puff.
-            float dist = sqrtf(dx * dx + dy * dy);
-            if (dist > radius)
-                continue;
-            
-            // Compute alpha with a squared falloff for a smoother edge.
-            float alpha = 1.0f - (dist / (float)radius);
-            alpha = alpha * alpha;  // Squared falloff
-            
-            // Optionally, add a small amount of randomness to the alpha
-            // to simulate the turbulent, wispy nature of smoke.
-            float noise = (rand() % 20) / 100.0f - 0.1f;  // Random value in [-0.1, 0.1]
-            alpha = std::min(1.0f, std::max(0.0f, alpha + noise));
-            
-            // You might want to lower the overall opacity for smoke;
-            // here we multiply by 150 (out of 255) to limit the maximum alpha.
-            unsigned int finalAlpha = static_cast<int>(alpha * 150);
-            
-            // Construct the final color.
-            // p.color is assumed to be a grayish tone.
-            unsigned int color = (finalAlpha << 24) | (p.color & 0xFFFFFF);
-            
-            dst[screenY * g_ScreenWidth + screenX] = color;
-        }
+void ClearParticles()
+{
+    RecordSession(SessionRecordType::CLEAR);
+    for (ParticlePool& pool : g_pools) {
+        pool.Clear();
     }
+    g_lastMousePos = { -1, -1 };
+    s_pathJoin.count = 0;
+    s_spawnTravel = 0.f;
+    s_lastSpawnTime = 0.0;
 }
 
+//---------------------------------------------------
+// IntegratePool
+//  Runs the SIMD update kernel over one pool's arrays, remembering the
+//  step for interpolated drawing.
+//---------------------------------------------------
+static void IntegratePool(ParticlePool& pool, const UpdateParams& params, const float* driftX = nullptr)
+{
+    pool.stepDt = params.dt;
+    pool.stepGravityDv = params.gravity * params.dt;
+
+    UpdateStreams streams;
+    streams.x        = pool.x.data();
+    streams.y        = pool.y.data();
+    streams.vx       = pool.vx.data();
+    streams.vy       = pool.vy.data();
+    streams.life     = pool.life.data();
+    streams.scale    = pool.scale.data();
+    streams.lifeSpan = pool.lifeSpan.data();
+    streams.driftX   = driftX;
+    streams.count    = pool.Size();
+    RunUpdateKernel(streams, params);
+}
 
 //---------------------------------------------------
-// DrawParticlesToDIB (Now draws full shapes, not single pixels)
+// UpdateEffect
+//  Integrates one effect's pool with its forces and drops what expired.
+//  The force field goes into the velocities first, so PrevX/PrevY still
+//  work back along the step.
 //---------------------------------------------------
-void DrawParticlesToDIB()
-{
-    if (!g_pPixels) return;
-
-    // Clear the screen buffer.
-    unsigned int* dst = static_cast<unsigned int*>(g_pPixels);
-    memset(dst, 0, g_ScreenWidth * g_ScreenHeight * sizeof(unsigned int));
-
-    // For each particle, convert its global coordinates into the overlay's
-    // coordinate space by subtracting the virtual offsets.
-    for (const auto &p : g_particles)
-    {
-        // Compute adjusted coordinates.
-        int adjustedX = static_cast<int>(p.x) - g_VirtualOffsetX;
-        int adjustedY = static_cast<int>(p.y) - g_VirtualOffsetY;
-
-        // Only draw if the particle lies within the DIB.
-        if (adjustedX < 0 || adjustedX >= g_ScreenWidth ||
-            adjustedY < 0 || adjustedY >= g_ScreenHeight)
-            continue;
-
-        // Create a local copy of the particle with adjusted coordinates.
-        Particle pAdjusted = p;
-        pAdjusted.x = adjustedX;
-        pAdjusted.y = adjustedY;
-
-        // Now use the adjusted particle for drawing.
-        switch (p.type) {
-            case ParticleType::HEARTS:
-                DrawShape(pAdjusted, HEART_MASK, 11, 10); // Use new mask dimensions.
-                break;
-            case ParticleType::STARS:
-                DrawShape(pAdjusted, STAR_MASK, 16, 16);
-                break;
-            case ParticleType::FIRE:
-                DrawFire(pAdjusted);
-                break;
-            case ParticleType::SPARKS:
-                DrawSparks(pAdjusted);
-                break;
-            case ParticleType::SMOKE:
-                DrawSmoke(pAdjusted);
-                break;
-            case ParticleType::SWORD:
-                DrawSword(pAdjusted);
-                break;
+template <class Effect>
+static void UpdateEffect(float dt)
+{
+    UpdateParams params = {};
+    params.dt         = dt;
+    params.vxScale    = Effect::VX_SCALE;
+    params.vyScale    = Effect::VY_SCALE;
+    params.preAccel   = Effect::PRE_ACCEL;
+    params.gravity    = Effect::GRAVITY;
+
+    ParticlePool& pool = GetPool(Effect::TYPE);
+    params.lifeMin    = pool.lifeMin;
+    params.lifeStep   = pool.lifeStep;
+    const float* drift = nullptr;
+    if constexpr (Effect::DRIFT > 0.f) {
+        // Slight random drift so they float more naturally
+        static std::vector<float> s_drift;
+        s_drift.resize(pool.Size());
+        ThreadRng().FillFloats(s_drift.data(), s_drift.size(), -Effect::DRIFT, Effect::DRIFT);
+        drift = s_drift.data();
+    }
+    if constexpr (Effect::FORCE_RESPONSE > 0.f) {
+        if (IsForceFieldActive()) {
+            ApplyForceField(pool.x.data(), pool.y.data(), pool.vx.data(), pool.vy.data(), pool.Size(),
+                            Effect::FORCE_RESPONSE * dt);
         }
     }
+    IntegratePool(pool, params, drift);
+    pool.RemoveExpired();
 }
 
-
 //---------------------------------------------------
-// Draw Sword (Composite Particle)
-// This function draws a sword composed of a blade,
-// a cross-guard, a hilt, and a pommel.
+// UpdateParticles
 //---------------------------------------------------
-void DrawSword(const Particle& p)
-{
-    // We'll assume that p.x and p.y are the center position
-    // of the sword particle. The sword is defined in local
-    // coordinates (in pixels) and then transformed by the
-    // particle's scale and rotation (p.angle).
-
-    // Pre-calculate rotation values.
-    float cosA = cosf(p.angle);
-    float sinA = sinf(p.angle);
-
-    // Define a bounding box in local coordinates that encloses the whole sword.
-    // (These values are chosen based on our sword design below.)
-    int localMinX = -20;
-    int localMaxX = 20;
-    int localMinY = -60;
-    int localMaxY = 20;
-
-    // Loop over the bounding box.
-    for (int ly = localMinY; ly <= localMaxY; ly++) {
-        for (int lx = localMinX; lx <= localMaxX; lx++) {
-
-            // Transform local coordinates (lx, ly) to screen space.
-            float localX = lx * p.scale;
-            float localY = ly * p.scale;
-            float rotX = localX * cosA - localY * sinA;
-            float rotY = localX * sinA + localY * cosA;
-            int screenX = static_cast<int>(p.x + rotX);
-            int screenY = static_cast<int>(p.y + rotY);
-
-            // Skip if outside the screen.
-            if (screenX < 0 || screenX >= g_ScreenWidth ||
-                screenY < 0 || screenY >= g_ScreenHeight)
-                continue;
-
-            // Determine which part of the sword the point falls in.
-            // --- Sword Design in Local Coordinates ---
-            // Blade: A narrow vertical rectangle.
-            //     x in [-3, 3], y in [-50, 0]
-            bool inBlade = (lx >= -3 && lx <= 3 && ly >= -50 && ly <= 0);
-
-            // Cross-guard: A wide, thin horizontal rectangle.
-            //     x in [-10, 10], y in [0, 4]
-            bool inGuard = (lx >= -10 && lx <= 10 && ly >= 0 && ly <= 4);
-
-            // Hilt: A narrow vertical rectangle.
-            //     x in [-2, 2], y in [4, 14]
-            bool inHilt = (lx >= -2 && lx <= 2 && ly >= 4 && ly <= 14);
-
-            // Pommel: A circle at the end of the hilt.
-            //     Centered at (0, 14) with radius 3.
-            float dx = lx - 0;
-            float dy = ly - 14;
-            bool inPommel = (dx * dx + dy * dy <= 9);
-
-            // Choose a color based on which part we are drawing.
-            // Colors are defined as 0xAARRGGBB.
-            unsigned int color = 0;
-            if (inBlade) {
-                // Blade: A shining silver.
-                color = (0xFF << 24) | (0xC0C0C0 & 0xFFFFFF);
-            } else if (inGuard) {
-                // Guard: A rich golden color.
-                color = (0xFF << 24) | (0xFFD700 & 0xFFFFFF);
-            } else if (inHilt) {
-                // Hilt: A deep brown.
-                color = (0xFF << 24) | (0x8B4513 & 0xFFFFFF);
-            } else if (inPommel) {
-                // Pommel: A dark grey.
-                color = (0xFF << 24) | (0x696969 & 0xFFFFFF);
-            } else {
-                // Not part of the sword.
-                continue;
-            }
-
-            // Draw the pixel.
-            ((unsigned int*)g_pPixels)[screenY * g_ScreenWidth + screenX] = color;
-        }
-    }
+void UpdateParticles(float dt)
+{
+    MT_PROFILE_SCOPE(ProfileStage::UPDATE);
+    RecordSession(SessionRecordType::UPDATE, dt);
+    Effects::ForEach([dt](auto effect) { UpdateEffect<decltype(effect)>(dt); });
 }
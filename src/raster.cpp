@@ -0,0 +1,226 @@
+// src/raster.cpp
+#include "raster.h"
+#include <algorithm>
+#include <cstdlib>   // abs
+#include <cstddef>   // ptrdiff_t
+#include <utility>
+
+// floor(a / b) for b > 0
+static int64_t FloorDiv(int64_t a, int64_t b)
+{
+    int64_t q = a / b;
+    return (a % b != 0 && a < 0) ? q - 1 : q;
+}
+
+// ceil(a / b) for b > 0
+static int64_t CeilDiv(int64_t a, int64_t b)
+{
+    return -FloorDiv(-a, b);
+}
+
+// ceil(a / 16) as a pixel index
+static int CeilPixel(int32_t v)
+{
+    return static_cast<int>(FloorDiv(static_cast<int64_t>(v) + RASTER_ONE - 1, RASTER_ONE));
+}
+
+//------------------------------------------------------------------
+// EdgeStepper
+//  First pixel column at or right of the edge on successive rows:
+//  ceil(X(Y) / 16) for Y = 16 * row, where X(Y) is the edge's exact
+//  (rational) x. That is the first pixel inside for a left edge and
+//  the first pixel outside for a right edge, which is the top-left
+//  rule. The column is kept as quotient and remainder of a fraction
+//  with denominator 16 * dy, so stepping a row is two additions.
+//------------------------------------------------------------------
+struct EdgeStepper {
+    int64_t column; // ceil(X(Y) / 16) for the current row
+    int64_t rem;    // In [0, den)
+    int64_t stepColumn, stepRem, den;
+
+    // Edge from "from" to "to" (to.y > from.y), starting at "row"
+    void Init(RasterVertex from, RasterVertex to, int row)
+    {
+        const int64_t dx = static_cast<int64_t>(to.x) - from.x;
+        const int64_t dy = static_cast<int64_t>(to.y) - from.y;
+        den = dy * RASTER_ONE;
+
+        // ceil(A / den) = floor((A + den - 1) / den), A = 16 * X(Y) * dy / 16
+        const int64_t y = static_cast<int64_t>(row) * RASTER_ONE;
+        const int64_t numerator = static_cast<int64_t>(from.x) * dy + (y - from.y) * dx + den - 1;
+        column = FloorDiv(numerator, den);
+        rem = numerator - column * den;
+
+        const int64_t step = dx * RASTER_ONE;
+        stepColumn = FloorDiv(step, den);
+        stepRem = step - stepColumn * den;
+    }
+
+    void Step()
+    {
+        column += stepColumn;
+        rem += stepRem;
+        if (rem >= den) {
+            column++;
+            rem -= den;
+        }
+    }
+};
+
+// Rows [rowBegin, rowEnd) between a left and a right edge
+static void EmitRows(EdgeStepper& left, EdgeStepper& right, int rowBegin, int rowEnd,
+                     const Rect& clip, RasterSpanFn emit, void* context)
+{
+    for (int row = rowBegin; row < rowEnd; row++) {
+        const int x0 = static_cast<int>(std::max<int64_t>(left.column, clip.left));
+        const int x1 = static_cast<int>(std::min<int64_t>(right.column, clip.right));
+        if (x0 < x1) emit(row, x0, x1, context);
+        left.Step();
+        right.Step();
+    }
+}
+
+//------------------------------------------------------------------
+// RasterizeTriangle
+//  Sorted by y, the triangle is the long edge v0-v2 on one side and
+//  v0-v1, v1-v2 on the other. A row belongs to the triangle if its
+//  center is at or below the top vertex and above the bottom one, so a
+//  flat top edge is in and a flat bottom edge is out.
+//------------------------------------------------------------------
+void RasterizeTriangle(RasterVertex v0, RasterVertex v1, RasterVertex v2,
+                       const Rect& clip, RasterSpanFn emit, void* context)
+{
+    if (v1.y < v0.y) std::swap(v0, v1);
+    if (v2.y < v1.y) std::swap(v1, v2);
+    if (v1.y < v0.y) std::swap(v0, v1);
+
+    // Twice the signed area; positive if v1 is left of the long edge
+    const int64_t cross = (static_cast<int64_t>(v2.x) - v0.x) * (static_cast<int64_t>(v1.y) - v0.y) -
+                          (static_cast<int64_t>(v2.y) - v0.y) * (static_cast<int64_t>(v1.x) - v0.x);
+    if (cross == 0) return;
+
+    // Rows and columns it can touch, against the clip rectangle
+    const int rowBegin = std::max(CeilPixel(v0.y), clip.top);
+    const int rowMid   = std::min(std::max(CeilPixel(v1.y), rowBegin), clip.bottom);
+    const int rowEnd   = std::min(CeilPixel(v2.y), clip.bottom);
+    if (rowBegin >= rowEnd) return;
+    const int32_t minX = std::min(v0.x, std::min(v1.x, v2.x));
+    const int32_t maxX = std::max(v0.x, std::max(v1.x, v2.x));
+    if (CeilPixel(maxX) <= clip.left || CeilPixel(minX) >= clip.right) return;
+
+    const bool middleOnLeft = cross > 0;
+    EdgeStepper longEdge, shortEdge;
+    longEdge.Init(v0, v2, rowBegin);
+
+    if (rowBegin < rowMid) {
+        shortEdge.Init(v0, v1, rowBegin);
+        if (middleOnLeft) EmitRows(shortEdge, longEdge, rowBegin, rowMid, clip, emit, context);
+        else              EmitRows(longEdge, shortEdge, rowBegin, rowMid, clip, emit, context);
+    }
+    if (rowMid < rowEnd) {
+        shortEdge.Init(v1, v2, rowMid);
+        if (middleOnLeft) EmitRows(shortEdge, longEdge, rowMid, rowEnd, clip, emit, context);
+        else              EmitRows(longEdge, shortEdge, rowMid, rowEnd, clip, emit, context);
+    }
+}
+
+//------------------------------------------------------------------
+// FillLine
+//  Walks the major axis u (du >= dv steps along the minor axis v). At
+//  step t from the end with the smaller u, v moves
+//  floor((2 t dv + du) / (2 du)) pixels: the nearest to the exact
+//  t dv / du, halfway cases away from that end. The walk keeps the
+//  fraction as a remainder that carries into a minor step.
+//
+//  Segments entirely inside the clip, the common case, start at
+//  (x0, y0) and step toward (x1, y1) with no swapping or branching
+//  on the direction: spark arcs come in every direction, and
+//  mispredicted branches would cost more than the pixels. Walking from
+//  the larger u, halfway cases must go toward the start instead, which
+//  is starting the remainder one lower.
+//
+//  Other segments are put in the order above and mirrored (v -> -v)
+//  if v decreases; solving the step formula for the clip rectangle's
+//  minor range then gives the visible steps directly.
+//------------------------------------------------------------------
+void FillLine(uint32_t* pixels, int stride, int x0, int y0, int x1, int y1,
+              const Rect& clip, uint32_t color)
+{
+    // Direction signs (+1 for 0) and lengths, without branches
+    const int dx = x1 - x0, dy = y1 - y0;
+    const int sx = (dx >> 31) | 1, sy = (dy >> 31) | 1;
+    const int ax = dx * sx, ay = dy * sy;
+    const int xMajor = ax >= ay;
+    int64_t du = std::max(ax, ay);
+    int64_t dv = std::min(ax, ay);
+
+    uint32_t* dst;
+    ptrdiff_t majorPtr, minorPtr; // Pixel pointer step along u and v
+    int64_t rem, count;
+
+    const int inside = (std::min(x0, x1) >= clip.left) & (std::max(x0, x1) < clip.right) &
+                       (std::min(y0, y1) >= clip.top) & (std::max(y0, y1) < clip.bottom);
+    if (inside) {
+        const int majorSign = xMajor * sx + (1 - xMajor) * sy;
+        majorPtr = xMajor * sx + (1 - xMajor) * static_cast<ptrdiff_t>(sy) * stride;
+        minorPtr = xMajor * static_cast<ptrdiff_t>(sy) * stride + (1 - xMajor) * sx;
+        dst = pixels + static_cast<ptrdiff_t>(y0) * stride + x0;
+        rem = du - ((1 - majorSign) >> 1);
+        count = du + 1;
+    } else {
+        if (clip.left >= clip.right || clip.top >= clip.bottom) return;
+        int u0 = xMajor ? x0 : y0, v0 = xMajor ? y0 : x0;
+        int u1 = xMajor ? x1 : y1, v1 = xMajor ? y1 : x1;
+        if (u1 < u0 || (u1 == u0 && v1 < v0)) {
+            std::swap(u0, u1);
+            std::swap(v0, v1);
+        }
+        const int uMin = xMajor ? clip.left : clip.top, uMax = (xMajor ? clip.right : clip.bottom) - 1;
+        int vMin = xMajor ? clip.top : clip.left, vMax = (xMajor ? clip.bottom : clip.right) - 1;
+        const bool mirrored = v1 < v0;
+        int64_t v = v0;
+        if (mirrored) {
+            v = -v;
+            std::swap(vMin, vMax);
+            vMin = -vMin;
+            vMax = -vMax;
+        }
+
+        // Steps t in [tBegin, tEnd] with u and v inside the clip
+        int64_t tBegin = std::max<int64_t>(0, static_cast<int64_t>(uMin) - u0);
+        int64_t tEnd   = std::min<int64_t>(du, static_cast<int64_t>(uMax) - u0);
+        if (dv == 0) {
+            if (v < vMin || v > vMax) return;
+        } else {
+            // v(t) >= vMin  <=>  2 t dv >= 2 du (vMin - v0) - du
+            tBegin = std::max(tBegin, CeilDiv(2 * du * (vMin - v) - du, 2 * dv));
+            // v(t) <= vMax  <=>  2 t dv <= 2 du (vMax + 1 - v0) - du - 1
+            tEnd = std::min(tEnd, FloorDiv(2 * du * (vMax + 1 - v) - du - 1, 2 * dv));
+        }
+        if (tBegin > tEnd) return;
+        rem = du;
+        if (du != 0) {
+            const int64_t numerator = 2 * tBegin * dv + du;
+            v += numerator / (2 * du);
+            rem = numerator % (2 * du);
+        }
+
+        const int64_t u = u0 + tBegin;
+        if (mirrored) v = -v;
+        dst = pixels + (xMajor ? v * stride + u : u * stride + v);
+        majorPtr = xMajor ? 1 : stride;
+        minorPtr = (xMajor ? stride : 1) * (mirrored ? -1 : 1);
+        count = tEnd - tBegin + 1;
+    }
+
+    const int64_t den = 2 * du, step = 2 * dv;
+    for (int64_t i = 0; i < count; i++) {
+        *dst = color;
+        rem += step;
+        // Whether v steps is as good as random along a sloped line:
+        // select rather than branch
+        const bool carry = rem >= den;
+        dst += majorPtr + (carry ? minorPtr : 0);
+        rem -= carry ? den : 0;
+    }
+}
@@ -0,0 +1,51 @@
+// src/rng.cpp
+#include "rng.h"
+#include <atomic>
+
+static std::atomic<uint64_t> s_seed(0x2545F4914F6CDD1Dull);
+static std::atomic<uint32_t> s_generation(1);
+static std::atomic<uint32_t> s_nextThreadIndex(0);
+
+struct ThreadStream {
+    Rng rng;
+    uint32_t generation = 0;
+    uint32_t index = s_nextThreadIndex.fetch_add(1);
+};
+
+//------------------------------------------------------------------
+// SeedParticleRng
+//------------------------------------------------------------------
+void SeedParticleRng(uint64_t seed)
+{
+    s_seed.store(seed);
+    s_generation.fetch_add(1);
+}
+
+static thread_local ThreadStream t_stream;
+
+//------------------------------------------------------------------
+// ThreadRng
+//------------------------------------------------------------------
+Rng& ThreadRng()
+{
+    uint32_t generation = s_generation.load();
+    if (t_stream.generation != generation) {
+        t_stream.rng.Seed(s_seed.load(), t_stream.index);
+        t_stream.generation = generation;
+    }
+    return t_stream.rng;
+}
+
+//------------------------------------------------------------------
+// GetThreadRngStream / SetThreadRngStream
+//------------------------------------------------------------------
+uint32_t GetThreadRngStream()
+{
+    return t_stream.index;
+}
+
+void SetThreadRngStream(uint32_t stream)
+{
+    t_stream.index = stream;
+    t_stream.generation = 0; // Reseed on the next draw
+}
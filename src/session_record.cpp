@@ -0,0 +1,432 @@
+// src/session_record.cpp
+#include "session_record.h"
+#include "cursor_input.h"
+#include "effect_policies.h"
+#include "rng.h"
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+//------------------------------------------------------------------
+// Encoding
+//------------------------------------------------------------------
+static void PutVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Zigzag: small magnitudes of either sign stay small
+static uint64_t EncodeSigned(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t DecodeSigned(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+static void PutSigned(std::vector<uint8_t>& out, int64_t value)
+{
+    PutVarint(out, EncodeSigned(value));
+}
+
+static void PutFloat(std::vector<uint8_t>& out, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(bits >> (i * 8)));
+}
+
+static void PutDouble(std::vector<uint8_t>& out, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 8; i++) out.push_back(static_cast<uint8_t>(bits >> (i * 8)));
+}
+
+//------------------------------------------------------------------
+// Recording
+//  One recorder, used by the engine's thread only.
+//------------------------------------------------------------------
+struct SessionRecorder {
+    FILE* file = nullptr;
+    bool failed = false;
+    std::vector<uint8_t> buffer;
+    int64_t lastTime = 0; // Nanoseconds
+    int lastX = 0, lastY = 0;
+};
+
+static SessionRecorder s_recorder;
+
+static void FlushRecorder()
+{
+    if (!s_recorder.buffer.empty() &&
+        fwrite(s_recorder.buffer.data(), 1, s_recorder.buffer.size(), s_recorder.file) != s_recorder.buffer.size()) {
+        s_recorder.failed = true;
+    }
+    s_recorder.buffer.clear();
+}
+
+// Times: the nearest whole nanoseconds, and how many units in the last
+// place the time lies from the double those give (0 for InputTimestamp,
+// which divides a nanosecond count by 1e9)
+static int64_t Nanoseconds(double time)
+{
+    return std::llround(time * 1e9);
+}
+
+static int64_t TimeResidual(double time, int64_t ns)
+{
+    const double whole = static_cast<double>(ns) / 1e9;
+    uint64_t bits, wholeBits;
+    memcpy(&bits, &time, sizeof(bits));
+    memcpy(&wholeBits, &whole, sizeof(wholeBits));
+    return static_cast<int64_t>(bits - wholeBits);
+}
+
+static double ApplyTimeResidual(int64_t ns, int64_t residual)
+{
+    double time = static_cast<double>(ns) / 1e9;
+    uint64_t bits;
+    memcpy(&bits, &time, sizeof(bits));
+    bits += static_cast<uint64_t>(residual);
+    memcpy(&time, &bits, sizeof(bits));
+    return time;
+}
+
+// The SYSTEM_ID SetActiveParticleSystem takes for the active effect
+static int ActiveSystemId()
+{
+    int id = 0;
+    Effects::With(g_activeParticleSystem, [&id](auto effect) { id = decltype(effect)::SYSTEM_ID; });
+    return id;
+}
+
+bool StartSessionRecording(const char* path, const Rect& desktop, uint64_t seed)
+{
+    if (s_recorder.file) StopSessionRecording();
+    s_recorder.file = fopen(path, "wb");
+    if (!s_recorder.file) return false;
+    s_recorder.failed = false;
+    s_recorder.buffer.clear();
+    s_recorder.buffer.reserve(SESSION_WRITE_BUFFER + 64);
+    const double timeBase = InputTimestampNow();
+    s_recorder.lastTime = Nanoseconds(timeBase);
+    s_recorder.lastX = 0;
+    s_recorder.lastY = 0;
+
+    // Header
+    std::vector<uint8_t>& out = s_recorder.buffer;
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(SESSION_MAGIC >> (i * 8)));
+    PutVarint(out, SESSION_VERSION);
+    PutVarint(out, seed);
+    PutVarint(out, GetThreadRngStream());
+    PutVarint(out, GetCursorEventQueue() ? 1 : 0);
+    PutSigned(out, desktop.left);
+    PutSigned(out, desktop.top);
+    PutSigned(out, desktop.right);
+    PutSigned(out, desktop.bottom);
+    PutDouble(out, timeBase);
+
+    // The state a replay has to start from. The level of detail goes
+    // first: it caps the pools the budgets size.
+    RecordSession(SessionRecordType::DETAIL, GetDetailLevel());
+    for (const ParticlePool& pool : g_pools) {
+        RecordSession(SessionRecordType::BUDGET, static_cast<int>(pool.type), pool.Capacity());
+        RecordSession(SessionRecordType::POLICY, static_cast<int>(pool.type), static_cast<uint64_t>(pool.policy));
+    }
+    RecordSession(SessionRecordType::EFFECT, ActiveSystemId());
+
+    ClearParticles();
+    SeedParticleRng(seed);
+    return true;
+}
+
+bool StopSessionRecording()
+{
+    if (!s_recorder.file) return false;
+    FlushRecorder();
+    if (fclose(s_recorder.file) != 0) s_recorder.failed = true;
+    s_recorder.file = nullptr;
+    return !s_recorder.failed;
+}
+
+bool IsRecordingSession()
+{
+    return s_recorder.file != nullptr;
+}
+
+void RecordSession(const SessionRecord& record)
+{
+    if (!s_recorder.file) return;
+
+    std::vector<uint8_t>& out = s_recorder.buffer;
+    out.push_back(static_cast<uint8_t>(record.type));
+    switch (record.type) {
+    case SessionRecordType::CURSOR_EVENT:
+    case SessionRecordType::SPAWN: {
+        // The change in nanoseconds, shifted left; the low bit says
+        // whether a residual follows
+        const int64_t time = Nanoseconds(record.time);
+        const int64_t residual = TimeResidual(record.time, time);
+        PutVarint(out, (EncodeSigned(time - s_recorder.lastTime) << 1) | (residual != 0 ? 1 : 0));
+        if (residual != 0) PutSigned(out, residual);
+        s_recorder.lastTime = time;
+        if (record.type == SessionRecordType::SPAWN) break;
+    }
+    [[fallthrough]]; // Events carry a position too
+    case SessionRecordType::CURSOR_SAMPLE:
+        PutSigned(out, static_cast<int64_t>(record.x) - s_recorder.lastX);
+        PutSigned(out, static_cast<int64_t>(record.y) - s_recorder.lastY);
+        s_recorder.lastX = record.x;
+        s_recorder.lastY = record.y;
+        break;
+    case SessionRecordType::UPDATE:
+    case SessionRecordType::DRAW:
+    case SessionRecordType::DETAIL:
+        PutFloat(out, record.value);
+        break;
+    case SessionRecordType::EFFECT:
+        PutSigned(out, record.id);
+        break;
+    case SessionRecordType::BUDGET:
+    case SessionRecordType::POLICY:
+        PutVarint(out, static_cast<uint64_t>(record.id));
+        PutVarint(out, record.amount);
+        break;
+    case SessionRecordType::NO_CURSOR:
+    case SessionRecordType::CLEAR:
+        break;
+    }
+    if (out.size() >= SESSION_WRITE_BUFFER) FlushRecorder();
+}
+
+void RecordSession(SessionRecordType type)
+{
+    SessionRecord record = {};
+    record.type = type;
+    RecordSession(record);
+}
+
+void RecordSession(SessionRecordType type, float value)
+{
+    SessionRecord record = {};
+    record.type = type;
+    record.value = value;
+    RecordSession(record);
+}
+
+void RecordSession(SessionRecordType type, int id, uint64_t amount)
+{
+    SessionRecord record = {};
+    record.type = type;
+    record.id = id;
+    record.amount = amount;
+    RecordSession(record);
+}
+
+//------------------------------------------------------------------
+// SessionReader
+//------------------------------------------------------------------
+bool SessionReader::Open(const char* path)
+{
+    data.clear();
+    pos = 0;
+    lastTime = 0;
+    lastX = lastY = 0;
+    error = nullptr;
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        error = "cannot open the file";
+        return false;
+    }
+    uint8_t chunk[64 * 1024];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(file);
+
+    uint32_t magic = 0;
+    for (int i = 0; i < 4 && i < static_cast<int>(data.size()); i++) {
+        magic |= static_cast<uint32_t>(data[i]) << (i * 8);
+    }
+    if (data.size() < 4 || magic != SESSION_MAGIC) {
+        error = "not a session file";
+        return false;
+    }
+    pos = 4;
+
+    uint64_t version, seed, stream, queued;
+    int64_t left, top, right, bottom;
+    if (!ReadVarint(&version)) return false;
+    if (version != SESSION_VERSION) {
+        error = "unsupported session version";
+        return false;
+    }
+    if (!ReadVarint(&seed) || !ReadVarint(&stream) || !ReadVarint(&queued) ||
+        !ReadSigned(&left) || !ReadSigned(&top) || !ReadSigned(&right) || !ReadSigned(&bottom) ||
+        !ReadDouble(&header.timeBase)) {
+        return false;
+    }
+    if (right <= left || bottom <= top ||
+        right - left > SESSION_MAX_DESKTOP || bottom - top > SESSION_MAX_DESKTOP ||
+        left < INT_MIN / 2 || top < INT_MIN / 2 || right > INT_MAX / 2 || bottom > INT_MAX / 2) {
+        error = "empty or oversized desktop";
+        return false;
+    }
+
+    header.seed = seed;
+    header.rngStream = static_cast<uint32_t>(stream);
+    header.queuedInput = queued != 0;
+    header.desktop = Rect{ static_cast<int>(left), static_cast<int>(top),
+                           static_cast<int>(right), static_cast<int>(bottom) };
+    lastTime = Nanoseconds(header.timeBase);
+    return true;
+}
+
+bool SessionReader::ReadVarint(uint64_t* value)
+{
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= data.size()) {
+            error = "truncated record";
+            return false;
+        }
+        const uint8_t byte = data[pos++];
+        result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    error = "malformed varint";
+    return false;
+}
+
+bool SessionReader::ReadSigned(int64_t* value)
+{
+    uint64_t zigzag;
+    if (!ReadVarint(&zigzag)) return false;
+    *value = DecodeSigned(zigzag);
+    return true;
+}
+
+bool SessionReader::ReadFloat(float* value)
+{
+    if (data.size() - pos < 4) {
+        error = "truncated record";
+        return false;
+    }
+    uint32_t bits = 0;
+    for (int i = 0; i < 4; i++) bits |= static_cast<uint32_t>(data[pos + i]) << (i * 8);
+    pos += 4;
+    memcpy(value, &bits, sizeof(bits));
+    return true;
+}
+
+bool SessionReader::ReadDouble(double* value)
+{
+    if (data.size() - pos < 8) {
+        error = "truncated record";
+        return false;
+    }
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; i++) bits |= static_cast<uint64_t>(data[pos + i]) << (i * 8);
+    pos += 8;
+    memcpy(value, &bits, sizeof(bits));
+    return true;
+}
+
+bool SessionReader::Next(SessionRecord* record)
+{
+    if (error || pos >= data.size()) return false;
+
+    *record = SessionRecord();
+    record->type = static_cast<SessionRecordType>(data[pos++]);
+    int64_t residual, delta, dx, dy;
+    uint64_t time, id;
+    switch (record->type) {
+    case SessionRecordType::CURSOR_EVENT:
+    case SessionRecordType::SPAWN:
+        if (!ReadVarint(&time)) return false;
+        lastTime += DecodeSigned(time >> 1);
+        residual = 0;
+        if ((time & 1) && !ReadSigned(&residual)) return false;
+        record->time = ApplyTimeResidual(lastTime, residual);
+        if (record->type == SessionRecordType::SPAWN) return true;
+        [[fallthrough]]; // Events carry a position too
+    case SessionRecordType::CURSOR_SAMPLE:
+        if (!ReadSigned(&dx) || !ReadSigned(&dy)) return false;
+        lastX += static_cast<int>(dx);
+        lastY += static_cast<int>(dy);
+        record->x = lastX;
+        record->y = lastY;
+        return true;
+    case SessionRecordType::UPDATE:
+    case SessionRecordType::DRAW:
+    case SessionRecordType::DETAIL:
+        return ReadFloat(&record->value);
+    case SessionRecordType::EFFECT:
+        if (!ReadSigned(&delta)) return false;
+        record->id = static_cast<int>(delta);
+        return true;
+    case SessionRecordType::BUDGET:
+    case SessionRecordType::POLICY:
+        if (!ReadVarint(&id) || !ReadVarint(&record->amount)) return false;
+        if (id < 1 || id > PARTICLE_TYPE_COUNT) {
+            error = "particle type out of range";
+            return false;
+        }
+        if (record->type == SessionRecordType::BUDGET ? record->amount > SESSION_MAX_BUDGET
+                                                      : record->amount > static_cast<uint64_t>(OverflowPolicy::EVICT_LEAST_LIFE)) {
+            error = "budget or policy out of range";
+            return false;
+        }
+        record->id = static_cast<int>(id);
+        return true;
+    case SessionRecordType::NO_CURSOR:
+    case SessionRecordType::CLEAR:
+        return true;
+    }
+    error = "unknown record type";
+    return false;
+}
+
+//------------------------------------------------------------------
+// FrameChecksum
+//  Sum of a strong mix of (position, pixel) over the non-zero pixels:
+//  addition does not care in which order rectangles are visited.
+//------------------------------------------------------------------
+static uint64_t MixPixel(uint64_t position, uint32_t pixel)
+{
+    uint64_t z = position * 0x9E3779B97F4A7C15ull ^ pixel;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+uint64_t FrameChecksum(const FrameTarget& target)
+{
+    const Framebuffer& fb = target.fb;
+    uint64_t sum = 0;
+    for (int i = 0; i < target.drawn.count; i++) {
+        const Rect& rc = target.drawn.rects[i];
+        for (int y = rc.top; y < rc.bottom; y++) {
+            const uint32_t* row = fb.pixels + static_cast<size_t>(y) * fb.width;
+            const uint64_t globalY = static_cast<uint32_t>(y + fb.originY);
+            for (int x = rc.left; x < rc.right; x++) {
+                if (row[x] == 0) continue;
+                const uint64_t globalX = static_cast<uint32_t>(x + fb.originX);
+                sum += MixPixel((globalY << 32) | globalX, row[x]);
+            }
+        }
+    }
+    return sum;
+}
@@ -0,0 +1,401 @@
+// src/sprite_cache.cpp
+#include "sprite_cache.h"
+#include <cmath>
+#include <list>
+#include <unordered_map>
+#include <algorithm>
+
+//---------------------------------------------------
+// Shape definitions
+//---------------------------------------------------
+// Heart Mask (16x16)
+// 10x11 Heart Mask (More Defined and Larger)
+static const unsigned char HEART_MASK[10 * 11] = {
+    0,0,0,1,1,0,0,0,1,1,0, 
+    0,0,1,1,1,1,0,1,1,1,1, 
+    0,1,1,1,1,1,1,1,1,1,1, 
+    1,1,1,1,1,1,1,1,1,1,1, 
+    1,1,1,1,1,1,1,1,1,1,1, 
+    0,1,1,1,1,1,1,1,1,1,0, 
+    0,0,1,1,1,1,1,1,1,0,0, 
+    0,0,0,1,1,1,1,1,0,0,0, 
+    0,0,0,0,1,1,1,0,0,0,0, 
+    0,0,0,0,0,1,0,0,0,0,0  
+};
+
+
+// 16x16 Star Mask
+static const unsigned char STAR_MASK[16 * 16] = {
+    // Row  0: 1 at col0, col7, col15
+    1,0,0,0,0,0,0,1,0,0,0,0,0,0,0,1,
+    // Row  1: 1 at col1, col7, col14
+    0,1,0,0,0,0,0,1,0,0,0,0,0,0,1,0,
+    // Row  2: 1 at col2, col7, col13
+    0,0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,
+    // Row  3: 1 at col3, col7, col12
+    0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,
+    // Row  4: 1 at col4, col7, col11
+    0,0,0,0,1,0,0,1,0,0,0,1,0,0,0,0,
+    // Row  5: 1 at col5, col7, col10
+    0,0,0,0,0,1,0,1,0,0,1,0,0,0,0,0,
+    // Row  6: 1 at col6, col7, col9
+    0,0,0,0,0,0,1,1,0,1,0,0,0,0,0,0,
+    // Row  7: (center row) all 1’s for a bold horizontal arm
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    // Row  8: 1 at col7 and col8
+    0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,
+    // Row  9: 1 at col6, col7, col9
+    0,0,0,0,0,0,1,1,0,1,0,0,0,0,0,0,
+    // Row 10: 1 at col5, col7, col10
+    0,0,0,0,0,1,0,1,0,0,1,0,0,0,0,0,
+    // Row 11: 1 at col4, col7, col11
+    0,0,0,0,1,0,0,1,0,0,0,1,0,0,0,0,
+    // Row 12: 1 at col3, col7, col12
+    0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,
+    // Row 13: 1 at col2, col7, col13
+    0,0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,
+    // Row 14: 1 at col1, col7, col14
+    0,1,0,0,0,0,0,1,0,0,0,0,0,0,1,0,
+    // Row 15: 1 at col0, col7, col15
+    1,0,0,0,0,0,0,1,0,0,0,0,0,0,0,1
+};
+
+// Opaque pixels of the heart/star masks; the color comes from the particle
+static const uint32_t MASK_PALETTE[2] = { 0, 0xFFFFFFFF };
+
+// Sword parts, colors as 0xAARRGGBB
+enum SwordPart { SWORD_NONE, SWORD_BLADE, SWORD_GUARD, SWORD_HILT, SWORD_POMMEL };
+static const uint32_t SWORD_PALETTE[5] = {
+    0,
+    0xFFC0C0C0, // Blade: A shining silver.
+    0xFFFFD700, // Guard: A rich golden color.
+    0xFF8B4513, // Hilt: A deep brown.
+    0xFF696969  // Pommel: A dark grey.
+};
+
+//---------------------------------------------------
+// Rasterization
+//  Sources are grids of palette indices; texel (pivotX, pivotY) lands
+//  on the particle's position. The rasterizer walks the destination
+//  pixels inside the rotated bounding box and inverse-maps each pixel
+//  into the grid, so every covered pixel is written exactly once and
+//  the result has no holes at any scale. A pixel whose center misses
+//  still picks up a texel under one of its corners, which keeps the
+//  star's one-texel, corner-connected diagonals unbroken.
+//---------------------------------------------------
+struct SpriteSource {
+    const unsigned char* texels;
+    int width;
+    int height;
+    float pivotX;
+    float pivotY;
+};
+
+// Which part of the sword a local-space point falls in
+static SwordPart SwordPartAt(int lx, int ly)
+{
+    // Blade: A narrow vertical rectangle.
+    //     x in [-3, 3], y in [-50, 0]
+    if (lx >= -3 && lx <= 3 && ly >= -50 && ly <= 0) return SWORD_BLADE;
+
+    // Cross-guard: A wide, thin horizontal rectangle.
+    //     x in [-10, 10], y in [0, 4]
+    if (lx >= -10 && lx <= 10 && ly >= 0 && ly <= 4) return SWORD_GUARD;
+
+    // Hilt: A narrow vertical rectangle.
+    //     x in [-2, 2], y in [4, 14]
+    if (lx >= -2 && lx <= 2 && ly >= 4 && ly <= 14) return SWORD_HILT;
+
+    // Pommel: A circle at the end of the hilt.
+    //     Centered at (0, 14) with radius 3.
+    int dx = lx - 0;
+    int dy = ly - 14;
+    if (dx * dx + dy * dy <= 9) return SWORD_POMMEL;
+
+    return SWORD_NONE;
+}
+
+// Sword: a blade, a cross-guard, a hilt and a pommel, defined in local
+// pixel coordinates (x in [-20, 20], y in [-60, 20]) around the particle.
+// Sampled once into a texel grid.
+#define SWORD_GRID_W 41
+#define SWORD_GRID_H 81
+
+static const unsigned char* SwordTexels()
+{
+    static unsigned char texels[SWORD_GRID_W * SWORD_GRID_H];
+    static bool built = false;
+    if (!built) {
+        for (int j = 0; j < SWORD_GRID_H; j++) {
+            for (int i = 0; i < SWORD_GRID_W; i++) {
+                texels[j * SWORD_GRID_W + i] = static_cast<unsigned char>(SwordPartAt(i - 20, j - 60));
+            }
+        }
+        built = true;
+    }
+    return texels;
+}
+
+// Narrows [lo, hi) to the steps t for which a + t * d lies in [0, limit)
+static void ClipSteps(float a, float d, float limit, int& lo, int& hi)
+{
+    if (d == 0.0f) {
+        if (a < 0.0f || a >= limit) hi = lo;
+        return;
+    }
+    float t0 = -a / d;
+    float t1 = (limit - a) / d;
+    if (d < 0.0f) std::swap(t0, t1);
+    lo = std::max(lo, static_cast<int>(ceilf(t0)));
+    hi = std::min(hi, static_cast<int>(ceilf(t1)));
+}
+
+static uint8_t SampleTexel(const SpriteSource& src, float u, float v)
+{
+    if (u < 0.0f || v < 0.0f || u >= src.width || v >= src.height) return 0;
+    return src.texels[static_cast<int>(v) * src.width + static_cast<int>(u)];
+}
+
+// Shrinks the sprite to the rectangle of opaque pixels
+static void TrimSprite(Sprite& sprite)
+{
+    int minX = sprite.width, maxX = -1;
+    int minY = sprite.height, maxY = -1;
+    for (int y = 0; y < sprite.height; y++) {
+        const uint8_t* row = sprite.pixels.data() + y * sprite.width;
+        for (int x = 0; x < sprite.width; x++) {
+            if (row[x] == 0) continue;
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+        }
+    }
+
+    if (maxX < 0) {
+        sprite.width = sprite.height = 0;
+        sprite.pixels.clear();
+        sprite.pixels.shrink_to_fit();
+        return;
+    }
+
+    int width  = maxX - minX + 1;
+    int height = maxY - minY + 1;
+    std::vector<uint8_t> trimmed(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* src = sprite.pixels.data() + (minY + y) * sprite.width + minX;
+        std::copy(src, src + width, trimmed.begin() + y * width);
+    }
+    sprite.offsetX += minX;
+    sprite.offsetY += minY;
+    sprite.width    = width;
+    sprite.height   = height;
+    sprite.pixels.swap(trimmed);
+}
+
+static void RasterizeAffine(const SpriteSource& src, float scale, float angle, Sprite& sprite)
+{
+    sprite.width = sprite.height = 0;
+    sprite.offsetX = sprite.offsetY = 0;
+    sprite.pixels.clear();
+    if (scale <= 0.0f) return;
+
+    const float cosA = cosf(angle);
+    const float sinA = sinf(angle);
+
+    // Destination bounds: the four source corners, scaled and rotated
+    float minX = 0, maxX = 0, minY = 0, maxY = 0;
+    for (int c = 0; c < 4; c++) {
+        float lx = ((c & 1) ? src.width  - src.pivotX : -src.pivotX) * scale;
+        float ly = ((c & 2) ? src.height - src.pivotY : -src.pivotY) * scale;
+        float x = lx * cosA - ly * sinA;
+        float y = lx * sinA + ly * cosA;
+        minX = (c == 0) ? x : std::min(minX, x);
+        maxX = (c == 0) ? x : std::max(maxX, x);
+        minY = (c == 0) ? y : std::min(minY, y);
+        maxY = (c == 0) ? y : std::max(maxY, y);
+    }
+    sprite.offsetX = static_cast<int>(floorf(minX));
+    sprite.offsetY = static_cast<int>(floorf(minY));
+    sprite.width   = static_cast<int>(ceilf(maxX)) - sprite.offsetX;
+    sprite.height  = static_cast<int>(ceilf(maxY)) - sprite.offsetY;
+    sprite.pixels.assign(static_cast<size_t>(sprite.width) * sprite.height, 0);
+
+    // Inverse transform (rotate by -angle, divide by scale), stepped
+    // incrementally along rows and columns.
+    const float invScale = 1.0f / scale;
+    const float duDx =  cosA * invScale, dvDx = -sinA * invScale;
+    const float duDy =  sinA * invScale, dvDy =  cosA * invScale;
+
+    const float px = sprite.offsetX + 0.5f;
+    const float py = sprite.offsetY + 0.5f;
+    float rowU = px * duDx + py * duDy + src.pivotX;
+    float rowV = px * dvDx + py * dvDy + src.pivotY;
+
+    // Half-pixel corner offsets in grid space
+    const float cu0 = 0.5f * (duDx + duDy), cv0 = 0.5f * (dvDx + dvDy);
+    const float cu1 = 0.5f * (duDx - duDy), cv1 = 0.5f * (dvDx - dvDy);
+    const float margin = fabsf(cu0) + fabsf(cu1) + fabsf(cv0) + fabsf(cv1);
+
+    for (int y = 0; y < sprite.height; y++, rowU += duDy, rowV += dvDy) {
+        // Span of this row whose pixels can reach the source grid
+        int lo = 0, hi = sprite.width;
+        ClipSteps(rowU + margin, duDx, src.width + 2 * margin, lo, hi);
+        ClipSteps(rowV + margin, dvDx, src.height + 2 * margin, lo, hi);
+
+        uint8_t* dst = sprite.pixels.data() + y * sprite.width;
+        float u = rowU + lo * duDx;
+        float v = rowV + lo * dvDx;
+        for (int x = lo; x < hi; x++, u += duDx, v += dvDx) {
+            uint8_t index = SampleTexel(src, u, v);
+            if (index == 0) index = SampleTexel(src, u - cu0, v - cv0);
+            if (index == 0) index = SampleTexel(src, u + cu0, v + cv0);
+            if (index == 0) index = SampleTexel(src, u - cu1, v - cv1);
+            if (index == 0) index = SampleTexel(src, u + cu1, v + cv1);
+            dst[x] = index;
+        }
+    }
+
+    TrimSprite(sprite);
+}
+
+static void RasterizeSprite(SpriteShape shape, float scale, float angle, Sprite& sprite)
+{
+    SpriteSource src = {};
+    switch (shape) {
+    case SpriteShape::HEART:
+        src = { HEART_MASK, 11, 10, 5.5f, 5.0f };
+        sprite.tinted  = true;
+        sprite.palette = MASK_PALETTE;
+        break;
+    case SpriteShape::STAR:
+        src = { STAR_MASK, 16, 16, 8.0f, 8.0f };
+        sprite.tinted  = true;
+        sprite.palette = MASK_PALETTE;
+        break;
+    case SpriteShape::SWORD:
+        src = { SwordTexels(), SWORD_GRID_W, SWORD_GRID_H, 20.0f, 60.0f };
+        sprite.tinted  = false;
+        sprite.palette = SWORD_PALETTE;
+        break;
+    }
+    RasterizeAffine(src, scale, angle, sprite);
+}
+
+//---------------------------------------------------
+// Cache (LRU list, most recently used first)
+//---------------------------------------------------
+struct SpriteCacheEntry {
+    uint32_t key;
+    uint32_t lastFrame; // Frame of the most recent lookup
+    Sprite sprite;
+};
+
+typedef std::list<SpriteCacheEntry> SpriteList;
+
+static SpriteList s_sprites;
+static std::unordered_map<uint32_t, SpriteList::iterator> s_spriteIndex;
+static SpriteCacheStats s_stats = { 0, 0, 0, 0, 0, SPRITE_CACHE_DEFAULT_BYTES };
+static uint32_t s_frame = 0;
+
+static const float TWO_PI = 6.28318531f;
+
+static size_t EntryBytes(const SpriteCacheEntry& entry)
+{
+    // Pixel data plus the list node and its index slot
+    return entry.sprite.pixels.capacity() + sizeof(SpriteCacheEntry) +
+           sizeof(SpriteList::iterator) + 4 * sizeof(void*);
+}
+
+// Drops least recently used sprites until the budget is met. Sprites
+// looked up this frame are never dropped (the budget may be exceeded
+// until the next frame), so references handed out stay valid.
+static void TrimSpriteCache()
+{
+    while (s_stats.bytes > s_stats.budgetBytes && !s_sprites.empty()) {
+        SpriteCacheEntry& victim = s_sprites.back();
+        if (victim.lastFrame == s_frame) break;
+        s_stats.bytes -= EntryBytes(victim);
+        s_spriteIndex.erase(victim.key);
+        s_sprites.pop_back();
+        s_stats.evictions++;
+    }
+    s_stats.entries = s_sprites.size();
+}
+
+//---------------------------------------------------
+// GetSprite
+//---------------------------------------------------
+const Sprite& GetSprite(SpriteShape shape, float scale, float angle)
+{
+    // Nearest quantized scale (clamped to the key's 16 bits) and angle
+    long scaleStep = lroundf(std::max(scale, 0.0f) * SPRITE_SCALE_STEPS);
+    scaleStep = std::min(scaleStep, 0xFFFFL);
+    float turns = fmodf(angle / TWO_PI, 1.0f);
+    if (turns < 0) turns += 1.0f;
+    long angleStep = lroundf(turns * SPRITE_ANGLE_STEPS) % SPRITE_ANGLE_STEPS;
+
+    uint32_t key = (static_cast<uint32_t>(shape) << 24) |
+                   (static_cast<uint32_t>(scaleStep) << 8) |
+                   static_cast<uint32_t>(angleStep);
+
+    auto found = s_spriteIndex.find(key);
+    if (found != s_spriteIndex.end()) {
+        s_stats.hits++;
+        s_sprites.splice(s_sprites.begin(), s_sprites, found->second);
+        found->second->lastFrame = s_frame;
+        return found->second->sprite;
+    }
+
+    s_stats.misses++;
+    s_sprites.emplace_front();
+    SpriteCacheEntry& entry = s_sprites.front();
+    entry.key = key;
+    entry.lastFrame = s_frame;
+    RasterizeSprite(shape,
+                    static_cast<float>(scaleStep) / SPRITE_SCALE_STEPS,
+                    static_cast<float>(angleStep) * TWO_PI / SPRITE_ANGLE_STEPS,
+                    entry.sprite);
+    s_spriteIndex[key] = s_sprites.begin();
+    s_stats.bytes += EntryBytes(entry);
+    TrimSpriteCache();
+    return entry.sprite;
+}
+
+//---------------------------------------------------
+// BeginSpriteFrame
+//---------------------------------------------------
+void BeginSpriteFrame()
+{
+    s_frame++;
+    TrimSpriteCache();
+}
+
+//---------------------------------------------------
+// Budget & statistics
+//---------------------------------------------------
+void SetSpriteCacheBudget(size_t bytes)
+{
+    s_stats.budgetBytes = bytes;
+    TrimSpriteCache();
+}
+
+void ClearSpriteCache()
+{
+    s_sprites.clear();
+    s_spriteIndex.clear();
+    s_stats.bytes = 0;
+    s_stats.entries = 0;
+}
+
+SpriteCacheStats GetSpriteCacheStats()
+{
+    return s_stats;
+}
+
+void ResetSpriteCacheStats()
+{
+    s_stats.hits = 0;
+    s_stats.misses = 0;
+    s_stats.evictions = 0;
+}
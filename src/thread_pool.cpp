@@ -0,0 +1,187 @@
+// src/thread_pool.cpp
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------
+// Work slices
+//  Each worker's remaining indices are one [begin, end) range packed
+//  into a 64-bit atomic. The owner takes from the front and thieves
+//  take the back half, both with a single compare-exchange.
+//------------------------------------------------------------------
+struct alignas(64) WorkSlice {
+    std::atomic<uint64_t> range;
+};
+
+static WorkSlice s_slices[MAX_WORKER_THREADS];
+
+static uint64_t PackRange(uint32_t begin, uint32_t end)
+{
+    return (static_cast<uint64_t>(begin) << 32) | end;
+}
+
+static bool PopFront(int worker, uint32_t& index)
+{
+    std::atomic<uint64_t>& slot = s_slices[worker].range;
+    uint64_t range = slot.load(std::memory_order_acquire);
+    for (;;) {
+        uint32_t begin = static_cast<uint32_t>(range >> 32);
+        uint32_t end   = static_cast<uint32_t>(range);
+        if (begin >= end) return false;
+        if (slot.compare_exchange_weak(range, PackRange(begin + 1, end),
+                                       std::memory_order_acq_rel)) {
+            index = begin;
+            return true;
+        }
+    }
+}
+
+// Moves the back half of some other worker's slice into the (empty)
+// slice of the thief. Nobody else writes an empty slice, so a plain
+// store is enough to publish it.
+static bool Steal(int thief, int workers)
+{
+    for (int k = 1; k < workers; k++) {
+        std::atomic<uint64_t>& victim = s_slices[(thief + k) % workers].range;
+        uint64_t range = victim.load(std::memory_order_acquire);
+        for (;;) {
+            uint32_t begin = static_cast<uint32_t>(range >> 32);
+            uint32_t end   = static_cast<uint32_t>(range);
+            if (begin >= end) break;
+            uint32_t take = (end - begin + 1) / 2;
+            if (victim.compare_exchange_weak(range, PackRange(begin, end - take),
+                                             std::memory_order_acq_rel)) {
+                s_slices[thief].range.store(PackRange(end - take, end), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+//------------------------------------------------------------------
+// Worker threads
+//------------------------------------------------------------------
+static std::mutex s_mutex;
+static std::condition_variable s_wake;
+static std::condition_variable s_done;
+static uint64_t s_job = 0;        // Bumped for every ParallelFor
+static int s_jobWorkers = 0;      // Threads taking part in the current job
+static int s_pending = 0;         // Helper threads still running the job
+static bool s_quit = false;
+static ParallelTaskFn s_task = nullptr;
+static void* s_context = nullptr;
+static int s_threadCount = 1;
+
+static void RunSlices(int worker, int workers)
+{
+    for (;;) {
+        uint32_t index;
+        while (PopFront(worker, index)) {
+            s_task(index, s_context);
+        }
+        if (!Steal(worker, workers)) return;
+    }
+}
+
+static void WorkerMain(int worker)
+{
+    uint64_t seen = 0;
+    for (;;) {
+        int workers;
+        {
+            std::unique_lock<std::mutex> lock(s_mutex);
+            s_wake.wait(lock, [&] { return s_quit || s_job != seen; });
+            if (s_quit) return;
+            seen = s_job;
+            workers = s_jobWorkers;
+        }
+        if (worker >= workers) continue;
+
+        RunSlices(worker, workers);
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (--s_pending == 0) s_done.notify_one();
+    }
+}
+
+// Owns the helper threads; joins them on shutdown and at exit
+struct WorkerThreads {
+    std::vector<std::thread> threads;
+
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            s_quit = true;
+        }
+        s_wake.notify_all();
+        for (std::thread& t : threads) t.join();
+        threads.clear();
+        s_quit = false;
+    }
+
+    ~WorkerThreads() { Stop(); }
+};
+
+static WorkerThreads s_workers;
+
+//------------------------------------------------------------------
+// SetWorkerThreadCount / GetWorkerThreadCount
+//------------------------------------------------------------------
+void SetWorkerThreadCount(int count)
+{
+    if (count <= 0) count = static_cast<int>(std::thread::hardware_concurrency());
+    count = std::min(std::max(count, 1), MAX_WORKER_THREADS);
+    if (count == s_threadCount) return;
+
+    s_workers.Stop();
+    s_threadCount = count;
+    for (int w = 1; w < count; w++) {
+        s_workers.threads.emplace_back(WorkerMain, w);
+    }
+}
+
+int GetWorkerThreadCount()
+{
+    return s_threadCount;
+}
+
+//------------------------------------------------------------------
+// ParallelFor
+//------------------------------------------------------------------
+void ParallelFor(size_t count, ParallelTaskFn task, void* context)
+{
+    const int workers = static_cast<int>(std::min<size_t>(s_threadCount, count));
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; i++) task(i, context);
+        return;
+    }
+
+    // Contiguous starting slices keep neighbouring indices on one thread
+    for (int w = 0; w < workers; w++) {
+        uint32_t begin = static_cast<uint32_t>(count * w / workers);
+        uint32_t end   = static_cast<uint32_t>(count * (w + 1) / workers);
+        s_slices[w].range.store(PackRange(begin, end), std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_task = task;
+        s_context = context;
+        s_jobWorkers = workers;
+        s_pending = workers - 1;
+        s_job++;
+    }
+    s_wake.notify_all();
+
+    RunSlices(0, workers);
+
+    std::unique_lock<std::mutex> lock(s_mutex);
+    s_done.wait(lock, [] { return s_pending == 0; });
+}
@@ -0,0 +1,278 @@
+// src/update_kernels.cpp
+//
+// Particle integration kernels. Each processes 4 (SSE2/NEON) or 8 (AVX2)
+// particles per instruction and finishes the remainder with the scalar
+// kernel. The fade curve 1 - (1 - r)^3 is evaluated as a polynomial
+// instead of powf so it vectorizes. Life and scale are loaded as 16-bit
+// fixed point, widened to float for the fade and narrowed back; the
+// faded scale is clamped to [0, MAX_SCALE_UNITS] first (a NaN to 0), so
+// every kernel stores the same unit for any input.
+
+#include "update_kernels.h"
+#include "particles.h" // PARTICLE_LIFE_UNIT
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#define MAX_SCALE_UNITS 65535.0f
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define MT_HAVE_X86_KERNELS 1
+  #include <immintrin.h>
+  #if defined(__GNUC__) || defined(__clang__)
+    #define MT_TARGET_AVX2 __attribute__((target("avx2")))
+  #else
+    #define MT_TARGET_AVX2
+  #endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+  #define MT_HAVE_NEON_KERNELS 1
+  #include <arm_neon.h>
+#endif
+
+// The step in whole life units
+static uint16_t LifeUnits(float dt)
+{
+    return static_cast<uint16_t>(std::min(std::lround(dt / PARTICLE_LIFE_UNIT), 65535L));
+}
+
+//------------------------------------------------------------------
+// Scalar kernel (reference and tail handling)
+//------------------------------------------------------------------
+static void UpdateRangeScalar(const UpdateStreams& s, const UpdateParams& params,
+                              size_t begin, size_t end)
+{
+    const float dt        = params.dt;
+    const float preDv     = params.preAccel * dt;
+    const float gravityDv = params.gravity * dt;
+    const uint16_t lifeDt = LifeUnits(dt);
+
+    for (size_t i = begin; i < end; i++) {
+        float vx = s.vx[i] * params.vxScale;
+        if (s.driftX) vx += s.driftX[i];
+        float vy = s.vy[i] * params.vyScale + preDv;
+
+        // Update position
+        s.x[i] += vx * dt;
+        s.y[i] += vy * dt;
+
+        // Apply gravity
+        s.vx[i] = vx;
+        s.vy[i] = vy + gravityDv;
+
+        // Decrease life and fade out by scaling down
+        const uint16_t life = (s.life[i] > lifeDt) ? static_cast<uint16_t>(s.life[i] - lifeDt) : 0;
+        s.life[i] = life;
+        float maxLife = params.lifeMin + s.lifeSpan[i] * params.lifeStep;
+        float ratio = life * PARTICLE_LIFE_UNIT / maxLife;
+        float u = 1.0f - ratio;
+        float scale = s.scale[i] * (1.0f - u * u * u);
+        scale = (scale > 0.f) ? std::min(scale, MAX_SCALE_UNITS) : 0.f;
+        s.scale[i] = static_cast<uint16_t>(std::lrint(scale));
+    }
+}
+
+void UpdateKernelScalar(const UpdateStreams& s, const UpdateParams& params)
+{
+    UpdateRangeScalar(s, params, 0, s.count);
+}
+
+#if defined(MT_HAVE_X86_KERNELS)
+//------------------------------------------------------------------
+// SSE2 kernel (4 lanes)
+//------------------------------------------------------------------
+static void UpdateKernelSSE2(const UpdateStreams& s, const UpdateParams& params)
+{
+    const __m128 dt        = _mm_set1_ps(params.dt);
+    const __m128 vxScale   = _mm_set1_ps(params.vxScale);
+    const __m128 vyScale   = _mm_set1_ps(params.vyScale);
+    const __m128 preDv     = _mm_set1_ps(params.preAccel * params.dt);
+    const __m128 gravityDv = _mm_set1_ps(params.gravity * params.dt);
+    const __m128 lifeMin   = _mm_set1_ps(params.lifeMin);
+    const __m128 lifeStep  = _mm_set1_ps(params.lifeStep);
+    const __m128 lifeUnit  = _mm_set1_ps(PARTICLE_LIFE_UNIT);
+    const __m128 one       = _mm_set1_ps(1.0f);
+    const __m128 maxScale  = _mm_set1_ps(MAX_SCALE_UNITS);
+    const __m128i lifeDt   = _mm_set1_epi16(static_cast<short>(LifeUnits(params.dt)));
+    const __m128i zero     = _mm_setzero_si128();
+    const __m128i bias32   = _mm_set1_epi32(32768);
+    const __m128i bias16   = _mm_set1_epi16(static_cast<short>(0x8000));
+
+    size_t i = 0;
+    for (; i + 4 <= s.count; i += 4) {
+        __m128 vx = _mm_mul_ps(_mm_loadu_ps(s.vx + i), vxScale);
+        if (s.driftX) vx = _mm_add_ps(vx, _mm_loadu_ps(s.driftX + i));
+        __m128 vy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s.vy + i), vyScale), preDv);
+
+        _mm_storeu_ps(s.x + i, _mm_add_ps(_mm_loadu_ps(s.x + i), _mm_mul_ps(vx, dt)));
+        _mm_storeu_ps(s.y + i, _mm_add_ps(_mm_loadu_ps(s.y + i), _mm_mul_ps(vy, dt)));
+        _mm_storeu_ps(s.vx + i, vx);
+        _mm_storeu_ps(s.vy + i, _mm_add_ps(vy, gravityDv));
+
+        __m128i life16 = _mm_subs_epu16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s.life + i)), lifeDt);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(s.life + i), life16);
+        int spanBytes;
+        memcpy(&spanBytes, s.lifeSpan + i, sizeof(spanBytes));
+        __m128i span = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(spanBytes), zero), zero);
+        __m128 maxLife = _mm_add_ps(lifeMin, _mm_mul_ps(_mm_cvtepi32_ps(span), lifeStep));
+        __m128 life = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(life16, zero)), lifeUnit);
+        __m128 ratio = _mm_div_ps(life, maxLife);
+        __m128 u = _mm_sub_ps(one, ratio);
+        __m128 fade = _mm_sub_ps(one, _mm_mul_ps(_mm_mul_ps(u, u), u));
+
+        __m128i scale16 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(s.scale + i));
+        __m128 scale = _mm_cvtepi32_ps(_mm_unpacklo_epi16(scale16, zero));
+        // maxps returns its second operand for a NaN
+        scale = _mm_min_ps(_mm_max_ps(_mm_mul_ps(scale, fade), _mm_setzero_ps()), maxScale);
+        __m128i scaled = _mm_cvtps_epi32(scale);
+        // SSE2 only packs to signed 16 bits: shift the range there and back
+        scale16 = _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(scaled, bias32), zero), bias16);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(s.scale + i), scale16);
+    }
+    UpdateRangeScalar(s, params, i, s.count);
+}
+
+//------------------------------------------------------------------
+// AVX2 kernel (8 lanes)
+//------------------------------------------------------------------
+MT_TARGET_AVX2
+static void UpdateKernelAVX2(const UpdateStreams& s, const UpdateParams& params)
+{
+    const __m256 dt        = _mm256_set1_ps(params.dt);
+    const __m256 vxScale   = _mm256_set1_ps(params.vxScale);
+    const __m256 vyScale   = _mm256_set1_ps(params.vyScale);
+    const __m256 preDv     = _mm256_set1_ps(params.preAccel * params.dt);
+    const __m256 gravityDv = _mm256_set1_ps(params.gravity * params.dt);
+    const __m256 lifeMin   = _mm256_set1_ps(params.lifeMin);
+    const __m256 lifeStep  = _mm256_set1_ps(params.lifeStep);
+    const __m256 lifeUnit  = _mm256_set1_ps(PARTICLE_LIFE_UNIT);
+    const __m256 one       = _mm256_set1_ps(1.0f);
+    const __m256 maxScale  = _mm256_set1_ps(MAX_SCALE_UNITS);
+    const __m128i lifeDt   = _mm_set1_epi16(static_cast<short>(LifeUnits(params.dt)));
+
+    size_t i = 0;
+    for (; i + 8 <= s.count; i += 8) {
+        __m256 vx = _mm256_mul_ps(_mm256_loadu_ps(s.vx + i), vxScale);
+        if (s.driftX) vx = _mm256_add_ps(vx, _mm256_loadu_ps(s.driftX + i));
+        __m256 vy = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(s.vy + i), vyScale), preDv);
+
+        _mm256_storeu_ps(s.x + i, _mm256_add_ps(_mm256_loadu_ps(s.x + i), _mm256_mul_ps(vx, dt)));
+        _mm256_storeu_ps(s.y + i, _mm256_add_ps(_mm256_loadu_ps(s.y + i), _mm256_mul_ps(vy, dt)));
+        _mm256_storeu_ps(s.vx + i, vx);
+        _mm256_storeu_ps(s.vy + i, _mm256_add_ps(vy, gravityDv));
+
+        __m128i life16 = _mm_subs_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s.life + i)), lifeDt);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(s.life + i), life16);
+        __m256i span = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s.lifeSpan + i)));
+        __m256 maxLife = _mm256_add_ps(lifeMin, _mm256_mul_ps(_mm256_cvtepi32_ps(span), lifeStep));
+        __m256 life = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(life16)), lifeUnit);
+        __m256 ratio = _mm256_div_ps(life, maxLife);
+        __m256 u = _mm256_sub_ps(one, ratio);
+        __m256 fade = _mm256_sub_ps(one, _mm256_mul_ps(_mm256_mul_ps(u, u), u));
+
+        __m128i scale16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s.scale + i));
+        __m256 scale = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(scale16));
+        scale = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(scale, fade), _mm256_setzero_ps()), maxScale);
+        __m256i scaled = _mm256_cvtps_epi32(scale);
+        scale16 = _mm_packus_epi32(_mm256_castsi256_si128(scaled), _mm256_extracti128_si256(scaled, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(s.scale + i), scale16);
+    }
+    UpdateRangeScalar(s, params, i, s.count);
+}
+#endif // MT_HAVE_X86_KERNELS
+
+#if defined(MT_HAVE_NEON_KERNELS)
+//------------------------------------------------------------------
+// NEON kernel (4 lanes, AArch64)
+//------------------------------------------------------------------
+static void UpdateKernelNEON(const UpdateStreams& s, const UpdateParams& params)
+{
+    const float32x4_t dt        = vdupq_n_f32(params.dt);
+    const float32x4_t vxScale   = vdupq_n_f32(params.vxScale);
+    const float32x4_t vyScale   = vdupq_n_f32(params.vyScale);
+    const float32x4_t preDv     = vdupq_n_f32(params.preAccel * params.dt);
+    const float32x4_t gravityDv = vdupq_n_f32(params.gravity * params.dt);
+    const float32x4_t lifeMin   = vdupq_n_f32(params.lifeMin);
+    const float32x4_t lifeStep  = vdupq_n_f32(params.lifeStep);
+    const float32x4_t lifeUnit  = vdupq_n_f32(PARTICLE_LIFE_UNIT);
+    const float32x4_t one       = vdupq_n_f32(1.0f);
+    const float32x4_t maxScale  = vdupq_n_f32(MAX_SCALE_UNITS);
+    const uint16x4_t  lifeDt    = vdup_n_u16(LifeUnits(params.dt));
+
+    size_t i = 0;
+    for (; i + 4 <= s.count; i += 4) {
+        float32x4_t vx = vmulq_f32(vld1q_f32(s.vx + i), vxScale);
+        if (s.driftX) vx = vaddq_f32(vx, vld1q_f32(s.driftX + i));
+        float32x4_t vy = vaddq_f32(vmulq_f32(vld1q_f32(s.vy + i), vyScale), preDv);
+
+        vst1q_f32(s.x + i, vaddq_f32(vld1q_f32(s.x + i), vmulq_f32(vx, dt)));
+        vst1q_f32(s.y + i, vaddq_f32(vld1q_f32(s.y + i), vmulq_f32(vy, dt)));
+        vst1q_f32(s.vx + i, vx);
+        vst1q_f32(s.vy + i, vaddq_f32(vy, gravityDv));
+
+        uint16x4_t life16 = vqsub_u16(vld1_u16(s.life + i), lifeDt);
+        vst1_u16(s.life + i, life16);
+        uint32_t spanBytes;
+        memcpy(&spanBytes, s.lifeSpan + i, sizeof(spanBytes));
+        uint16x4_t span16 = vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(spanBytes))));
+        float32x4_t maxLife = vaddq_f32(lifeMin, vmulq_f32(vcvtq_f32_u32(vmovl_u16(span16)), lifeStep));
+        float32x4_t life = vmulq_f32(vcvtq_f32_u32(vmovl_u16(life16)), lifeUnit);
+        float32x4_t ratio = vdivq_f32(life, maxLife);
+        float32x4_t u = vsubq_f32(one, ratio);
+        float32x4_t fade = vsubq_f32(one, vmulq_f32(vmulq_f32(u, u), u));
+
+        float32x4_t scale = vcvtq_f32_u32(vmovl_u16(vld1_u16(s.scale + i)));
+        // vmaxnmq picks the number over a NaN
+        scale = vminq_f32(vmaxnmq_f32(vmulq_f32(scale, fade), vdupq_n_f32(0.f)), maxScale);
+        vst1_u16(s.scale + i, vqmovn_u32(vcvtnq_u32_f32(scale)));
+    }
+    UpdateRangeScalar(s, params, i, s.count);
+}
+#endif // MT_HAVE_NEON_KERNELS
+
+//------------------------------------------------------------------
+// Dispatch
+//------------------------------------------------------------------
+typedef void (*UpdateKernelFn)(const UpdateStreams& s, const UpdateParams& params);
+
+static UpdateKernelFn KernelForLevel(SimdLevel level)
+{
+    switch (level) {
+#if defined(MT_HAVE_X86_KERNELS)
+        case SimdLevel::AVX2: return UpdateKernelAVX2;
+        case SimdLevel::SSE2: return UpdateKernelSSE2;
+#endif
+#if defined(MT_HAVE_NEON_KERNELS)
+        case SimdLevel::NEON: return UpdateKernelNEON;
+#endif
+        default:              return UpdateKernelScalar;
+    }
+}
+
+// Kernels missing from this build fall back to scalar.
+static SimdLevel EffectiveLevel(SimdLevel level)
+{
+    return KernelForLevel(level) == UpdateKernelScalar ? SimdLevel::SCALAR : level;
+}
+
+static SimdLevel      s_kernelLevel = EffectiveLevel(DetectSimdLevel());
+static UpdateKernelFn s_kernel      = KernelForLevel(s_kernelLevel);
+
+void RunUpdateKernel(const UpdateStreams& s, const UpdateParams& params)
+{
+    s_kernel(s, params);
+}
+
+bool SetUpdateKernelLevel(SimdLevel level)
+{
+    if (!IsSimdLevelSupported(level)) return false;
+    s_kernelLevel = EffectiveLevel(level);
+    s_kernel      = KernelForLevel(s_kernelLevel);
+    return s_kernelLevel == level;
+}
+
+SimdLevel GetUpdateKernelLevel()
+{
+    return s_kernelLevel;
+}
@@ -1,18 +1,17 @@
 // src/utils.cpp
 #include "utils.h"
-#include <cstdlib>  // for rand()
 
-COLORREF RandomHeartColor()
+Color RandomHeartColor(Rng& rng)
 {
-    int r = 200 + (rand() % 26);   // 180..255
-    int g = rand() % 121;         //   0..120
-    int b = 150 + (rand() % 106); // 100..255
+    int r = 200 + rng.NextInt(26);   // 180..255
+    int g = rng.NextInt(121);         //   0..120
+    int b = 150 + rng.NextInt(106); // 100..255
 
     // Occasionally bright red
-    if (rand() % 5 == 0) {
+    if (rng.NextInt(5) == 0) {
         r = 255;
-        g = rand() % 60;
-        b = 80 + (rand() % 40);
+        g = rng.NextInt(60);
+        b = 80 + rng.NextInt(40);
     }
-    return RGB(r, g, b);
+    return MakeRGB(r, g, b);
 }
@@ -1,6 +1,12 @@
 // src/window.cpp
+
+#ifndef _WIN32_WINNT
+  // UpdateLayeredWindowIndirect requires Windows Vista or later.
+  #define _WIN32_WINNT 0x0A00
+#endif
+
 #include "window.h"
-#include "particles.h"     // For SetActiveParticleSystem
+#include "particles.h"     // For SetFramebuffer, g_frameStats
 #include "resource.h"      // For IDI_APP (make sure this is in your include folder)
 #include <shellapi.h>      // For Shell_NotifyIcon, NOTIFYICONDATA
 #include <tchar.h>
@@ -14,9 +20,12 @@ int g_ScreenWidth     = 0;
 int g_ScreenHeight    = 0;
 int g_VirtualOffsetX  = 0;  // Left-most coordinate across all monitors
 int g_VirtualOffsetY  = 0;  // Top-most coordinate across all monitors
-void* g_pPixels       = nullptr;  // Pointer to DIB bits
+std::atomic<int> g_requestedParticleSystem(0);
+std::atomic<bool> g_fitOverlayToTrail(true);
+std::atomic<bool> g_forceField(false);
+void (*g_onMouseInput)() = nullptr;
 
-static HBITMAP g_hDib = nullptr; // Local handle for the DIB
+static HBITMAP s_hDibs[FRAME_SLOT_COUNT] = {}; // One DIB per frame slot
 
 //------------------------------------------------------------------
 // MonitorEnumProc
@@ -123,9 +132,28 @@ bool SetupWindow(int nCmdShow)
     // Add the program to the system tray.
     AddTrayIcon(g_hWnd);
 
+    // Cursor movement wakes the frame scheduler from idle.
+    RegisterMouseInput(g_hWnd);
+
     return true;
 }
 
+//------------------------------------------------------------------
+// RegisterMouseInput
+//  RIDEV_INPUTSINK delivers WM_INPUT even though the click-through
+//  overlay never has focus. Nothing polls: the UI thread sleeps in
+//  GetMessage until the mouse actually reports something.
+//------------------------------------------------------------------
+bool RegisterMouseInput(HWND hWnd)
+{
+    RAWINPUTDEVICE device = {};
+    device.usUsagePage = 0x01; // Generic desktop controls
+    device.usUsage     = 0x02; // Mouse
+    device.dwFlags     = RIDEV_INPUTSINK;
+    device.hwndTarget  = hWnd;
+    return RegisterRawInputDevices(&device, 1, sizeof(device)) != FALSE;
+}
+
 //------------------------------------------------------------------
 // AddTrayIcon
 //------------------------------------------------------------------
@@ -172,6 +200,11 @@ void ShowContextMenu(HWND hWnd, POINT pt)
         AppendMenu(hMenu, MF_STRING, ID_TRAY_PARTICLE_5, TEXT("Hearts"));
         AppendMenu(hMenu, MF_STRING, ID_TRAY_PARTICLE_6, TEXT("Sword"));
 
+        AppendMenu(hMenu, MF_SEPARATOR, 0, nullptr);
+        AppendMenu(hMenu, MF_STRING | (g_fitOverlayToTrail ? MF_CHECKED : MF_UNCHECKED),
+                   ID_TRAY_FIT_OVERLAY, TEXT("Fit Overlay to Trail"));
+        AppendMenu(hMenu, MF_STRING | (g_forceField ? MF_CHECKED : MF_UNCHECKED),
+                   ID_TRAY_FORCE_FIELD, TEXT("Wind and Turbulence"));
         AppendMenu(hMenu, MF_SEPARATOR, 0, nullptr);
         AppendMenu(hMenu, MF_STRING, ID_TRAY_EXIT, TEXT("Exit"));
 
@@ -197,15 +230,23 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
             }
             break;
 
+        case WM_INPUT:
+            if (g_onMouseInput) g_onMouseInput();
+            // DefWindowProc releases the raw input data.
+            return DefWindowProc(hWnd, msg, wParam, lParam);
+
         case WM_COMMAND:
             switch (LOWORD(wParam))
             {
-                case ID_TRAY_PARTICLE_1: SetActiveParticleSystem(1); break;
-                case ID_TRAY_PARTICLE_2: SetActiveParticleSystem(2); break;
-                case ID_TRAY_PARTICLE_3: SetActiveParticleSystem(3); break;
-                case ID_TRAY_PARTICLE_4: SetActiveParticleSystem(4); break;
-                case ID_TRAY_PARTICLE_5: SetActiveParticleSystem(5); break;
-                case ID_TRAY_PARTICLE_6: SetActiveParticleSystem(6); break;
+                // The particle core belongs to the simulation thread
+                case ID_TRAY_PARTICLE_1: g_requestedParticleSystem = 1; break;
+                case ID_TRAY_PARTICLE_2: g_requestedParticleSystem = 2; break;
+                case ID_TRAY_PARTICLE_3: g_requestedParticleSystem = 3; break;
+                case ID_TRAY_PARTICLE_4: g_requestedParticleSystem = 4; break;
+                case ID_TRAY_PARTICLE_5: g_requestedParticleSystem = 5; break;
+                case ID_TRAY_PARTICLE_6: g_requestedParticleSystem = 6; break;
+                case ID_TRAY_FIT_OVERLAY: g_fitOverlayToTrail = !g_fitOverlayToTrail; break;
+                case ID_TRAY_FORCE_FIELD: g_forceField = !g_forceField; break;
                 case ID_TRAY_EXIT:
                     RemoveTrayIcon(hWnd);
                     PostQuitMessage(0);
@@ -225,16 +266,13 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 }
 
 //------------------------------------------------------------------
-// CreateDIB
+// CreateFrameDIB
+//  The slot keeps its sequence; only its surface changes.
 //------------------------------------------------------------------
-void CreateDIB(int width, int height)
+bool CreateFrameDIB(int index, const Rect& area, FrameSlot& slot)
 {
-    // Release any existing DIB.
-    if (g_hDib) {
-        DeleteObject(g_hDib);
-        g_hDib = nullptr;
-    }
-    g_pPixels = nullptr;
+    const int width  = area.right - area.left;
+    const int height = area.bottom - area.top;
 
     BITMAPINFO bi = {};
     bi.bmiHeader.biSize        = sizeof(BITMAPINFOHEADER);
@@ -244,21 +282,60 @@ void CreateDIB(int width, int height)
     bi.bmiHeader.biBitCount    = 32;
     bi.bmiHeader.biCompression = BI_RGB;
 
+    // Release any existing DIB.
+    if (s_hDibs[index]) {
+        DeleteObject(s_hDibs[index]);
+        s_hDibs[index] = nullptr;
+    }
+
     HDC hDC = GetDC(nullptr);
-    g_hDib = CreateDIBSection(hDC, &bi, DIB_RGB_COLORS, &g_pPixels, nullptr, 0);
+    void* bits = nullptr;
+    s_hDibs[index] = CreateDIBSection(hDC, &bi, DIB_RGB_COLORS, &bits, nullptr, 0);
     ReleaseDC(nullptr, hDC);
+
+    // Fresh DIB sections are zero-filled, so there is nothing to clear yet.
+    slot.target.fb.pixels  = static_cast<uint32_t*>(bits);
+    slot.target.fb.width   = bits ? width : 0;
+    slot.target.fb.height  = bits ? height : 0;
+    slot.target.fb.originX = area.left;
+    slot.target.fb.originY = area.top;
+    ClearDirtyRegion(slot.target.drawn);
+    return s_hDibs[index] != nullptr;
+}
+
+//------------------------------------------------------------------
+// CreateFrameDIBs
+//------------------------------------------------------------------
+bool CreateFrameDIBs(const Rect& area, FrameSlot slots[FRAME_SLOT_COUNT])
+{
+    bool ok = true;
+    for (int i = 0; i < FRAME_SLOT_COUNT; i++) {
+        if (!CreateFrameDIB(i, area, slots[i])) ok = false;
+        slots[i].sequence = 0;
+    }
+
+    // The particle core learns the surface size and origin from the first slot.
+    SetFramebuffer(slots[0].target.fb);
+    return ok;
 }
 
 //------------------------------------------------------------------
 // UpdateOverlay
 //------------------------------------------------------------------
-void UpdateOverlay(HWND hWnd)
+void UpdateOverlay(HWND hWnd, int slot, const Framebuffer& fb, const DirtyRegion& dirty)
 {
-    if (!g_hDib || !g_pPixels) return;
+    g_frameStats.bytesPresented = 0;
+    HBITMAP hDib = s_hDibs[slot];
+    if (!hDib) return;
+
+    // Nothing changed since the last present: skip the compositor round trip.
+    Rect dirtyBounds = GetDirtyBounds(dirty);
+    if (IsEmptyRect(dirtyBounds)) return;
+    RECT dirtyRect = { dirtyBounds.left, dirtyBounds.top, dirtyBounds.right, dirtyBounds.bottom };
 
     HDC hScreenDC = GetDC(nullptr);
     HDC hMemDC    = CreateCompatibleDC(hScreenDC);
-    HBITMAP hOld  = (HBITMAP)SelectObject(hMemDC, g_hDib);
+    HBITMAP hOld  = (HBITMAP)SelectObject(hMemDC, hDib);
 
     BLENDFUNCTION blend = {};
     blend.BlendOp             = AC_SRC_OVER;
@@ -266,14 +343,29 @@ void UpdateOverlay(HWND hWnd)
     blend.SourceConstantAlpha = 255;
     blend.AlphaFormat         = AC_SRC_ALPHA;
 
-    // Get the current window position.
-    RECT rect;
-    GetWindowRect(g_hWnd, &rect);
-    POINT dstPos = { rect.left, rect.top };
-    SIZE  dstSize = { g_ScreenWidth, g_ScreenHeight };
+    // The window takes the surface's place and size: following the
+    // trail is a move, not a copy of the desktop.
+    POINT dstPos  = { fb.originX, fb.originY };
+    SIZE  dstSize = { fb.width, fb.height };
     POINT srcPos  = { 0, 0 };
 
-    UpdateLayeredWindow(hWnd, hScreenDC, &dstPos, &dstSize, hMemDC, &srcPos, 0, &blend, ULW_ALPHA);
+    // Only the dirty rectangle is copied from the DIB to the window surface.
+    UPDATELAYEREDWINDOWINFO info = {};
+    info.cbSize   = sizeof(UPDATELAYEREDWINDOWINFO);
+    info.hdcDst   = hScreenDC;
+    info.pptDst   = &dstPos;
+    info.psize    = &dstSize;
+    info.hdcSrc   = hMemDC;
+    info.pptSrc   = &srcPos;
+    info.crKey    = 0;
+    info.pblend   = &blend;
+    info.dwFlags  = ULW_ALPHA;
+    info.prcDirty = &dirtyRect;
+
+    if (UpdateLayeredWindowIndirect(hWnd, &info)) {
+        g_frameStats.bytesPresented =
+            static_cast<size_t>(dirtyRect.right - dirtyRect.left) * (dirtyRect.bottom - dirtyRect.top) * sizeof(unsigned int);
+    }
 
     SelectObject(hMemDC, hOld);
     DeleteDC(hMemDC);
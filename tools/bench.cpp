@@ -0,0 +1,549 @@
+// tools/bench.cpp
+//
+// Frame-cost benchmark for the particle core. For every combination of
+// effect, synthetic cursor path, particle count and canvas size it runs a
+// fixed number of frames through spawn -> update -> draw and reports
+// ns/particle per stage, frame-time percentiles, sprite cache hit rate
+// and peak RSS as JSON. Each scenario is repeated for every draw thread
+// count, reporting the draw speedup over the first count and whether
+// the final frame matches it pixel for pixel. It also times converting
+// the final live set between the compact pool entry and the Particle
+// record (ParticlePool::Get / Push), next to particle_bytes, the size of
+// an entry.
+//
+// With --forces on, every frame also builds a force field (wind,
+// turbulence and a repulsor at the cursor, force_field.h) before the
+// update; the build is timed as part of the update.
+//
+// Usage: mousetrail_bench [--frames N] [--seed N] [--out file.json]
+//                         [--simd scalar|sse2|avx2|neon]
+//                         [--policy drop|oldest|least-life]
+//                         [--forces on|off]
+//                         [--sprite-cache-kb N]
+//                         [--threads 1,2,4,8,16]
+//                         [--effects smoke,stars,fire,sparks,hearts,sword]
+//                         [--paths circle,flick,zigzag]
+//                         [--counts 1000,10000,100000]
+//                         [--canvases 1920x1080,3840x2160,7680x2160]
+//                         [--profile-csv file.csv] [--trace file.json]
+//
+// --profile-csv and --trace need a profiling build
+// (-DMOUSETRAIL_PROFILING=ON): they write the per-stage histograms and a
+// Chrome trace of every frame the benchmark runs, warm-up included.
+
+#include "particles.h"
+#include "update_kernels.h"
+#include "force_field.h"
+#include "blend_kernels.h"
+#include "rng.h"
+#include "sprite_cache.h"
+#include "thread_pool.h"
+#include "frame_profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+  #include <windows.h>
+  #include <psapi.h>
+#else
+  #include <sys/resource.h>
+#endif
+
+//------------------------------------------------------------------
+// Scenario tables
+//------------------------------------------------------------------
+struct EffectInfo {
+    const char* name;
+    int systemId;       // Id passed to SetActiveParticleSystem
+    ParticleType type;
+};
+
+static const EffectInfo EFFECTS[] = {
+    { "smoke",  1, ParticleType::SMOKE },
+    { "stars",  2, ParticleType::STARS },
+    { "fire",   3, ParticleType::FIRE },
+    { "sparks", 4, ParticleType::SPARKS },
+    { "hearts", 5, ParticleType::HEARTS },
+    { "sword",  6, ParticleType::SWORD },
+};
+
+enum class PathKind { CIRCLE, FLICK, ZIGZAG };
+
+struct PathInfo {
+    const char* name;
+    PathKind kind;
+};
+
+static const PathInfo PATHS[] = {
+    { "circle", PathKind::CIRCLE }, // Slow circles (~5 px/frame)
+    { "flick",  PathKind::FLICK },  // Fast flicks (~200 px/frame, then rest)
+    { "zigzag", PathKind::ZIGZAG }, // Horizontal zig-zag (~40 px/frame)
+};
+
+struct Canvas {
+    int width, height;
+};
+
+//------------------------------------------------------------------
+// Synthetic cursor
+//------------------------------------------------------------------
+static Point s_cursor = { 0, 0 };
+static bool s_forces = false; // --forces
+
+static bool BenchCursor(Point* pt)
+{
+    *pt = s_cursor;
+    return true;
+}
+
+static Point PathPosition(PathKind kind, int frame, const Canvas& canvas)
+{
+    const float cx = canvas.width * 0.5f;
+    const float cy = canvas.height * 0.5f;
+    Point pt = { 0, 0 };
+
+    switch (kind) {
+        case PathKind::CIRCLE: {
+            // One revolution every 4 seconds at 60 fps
+            float radius = std::min(canvas.width, canvas.height) * 0.25f;
+            float a = frame * (2.0f * 3.14159f / 240.0f);
+            pt.x = static_cast<int>(cx + radius * cosf(a));
+            pt.y = static_cast<int>(cy + radius * sinf(a));
+            break;
+        }
+        case PathKind::FLICK: {
+            // Every 12 frames, flick 600 px across in 3 frames, then rest
+            int segment = frame / 12;
+            int phase   = frame % 12;
+            float from  = (segment % 2 == 0) ? -300.f : 300.f;
+            float t     = std::min(1.0f, (phase + 1) / 3.0f);
+            pt.x = static_cast<int>(cx + from + (-2.0f * from) * t);
+            pt.y = static_cast<int>(cy + 40.0f * sinf(segment * 1.7f));
+            break;
+        }
+        case PathKind::ZIGZAG: {
+            // Triangle wave: 300 px amplitude at 40 px/frame, slow vertical drift
+            int periodX = 30;
+            int px = frame % periodX;
+            float tx = (px < periodX / 2) ? px / (periodX / 2.0f) : (periodX - px) / (periodX / 2.0f);
+            int periodY = 240;
+            int py = frame % periodY;
+            float ty = (py < periodY / 2) ? py / (periodY / 2.0f) : (periodY - py) / (periodY / 2.0f);
+            pt.x = static_cast<int>(cx - 300.0f + 600.0f * tx);
+            pt.y = static_cast<int>(cy - canvas.height * 0.2f + canvas.height * 0.4f * ty);
+            break;
+        }
+    }
+    return pt;
+}
+
+//------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------
+static size_t PeakRssKb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc = {};
+    GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+    return pmc.PeakWorkingSetSize / 1024;
+#else
+    struct rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+  #ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss) / 1024; // bytes on macOS
+  #else
+    return static_cast<size_t>(usage.ru_maxrss);        // kilobytes on Linux
+  #endif
+#endif
+}
+
+static double Percentile(std::vector<double> samples, double pct)
+{
+    if (samples.empty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    size_t idx = static_cast<size_t>(pct / 100.0 * (samples.size() - 1) + 0.5);
+    return samples[std::min(idx, samples.size() - 1)];
+}
+
+static std::vector<std::string> SplitList(const char* arg)
+{
+    std::vector<std::string> items;
+    std::string current;
+    for (const char* c = arg; ; c++) {
+        if (*c == ',' || *c == '\0') {
+            if (!current.empty()) items.push_back(current);
+            current.clear();
+            if (*c == '\0') break;
+        } else {
+            current += *c;
+        }
+    }
+    return items;
+}
+
+// FNV-1a over the pixel data
+static uint32_t Checksum(const std::vector<uint32_t>& pixels)
+{
+    uint32_t hash = 2166136261u;
+    for (uint32_t px : pixels) {
+        for (int i = 0; i < 4; i++) {
+            hash ^= (px >> (i * 8)) & 0xFF;
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+// Brings the live count up to the target by sweeping a cursor in a
+// small circle around the path position. Not timed.
+static void TopUpParticles(size_t target, Point center)
+{
+    Point resume = g_lastMousePos;
+    int guard = static_cast<int>(target) * 4 + 100;
+    float a = 0.f;
+    while (GetLiveParticleCount() < target && guard-- > 0) {
+        s_cursor.x = center.x + static_cast<int>(60.0f * cosf(a));
+        s_cursor.y = center.y + static_cast<int>(60.0f * sinf(a));
+        a += 1.0f;
+        SpawnParticlesOnMouseMove();
+    }
+    // Resume the measured path where it left off last frame
+    g_lastMousePos = resume;
+}
+
+typedef std::chrono::steady_clock Clock;
+
+static double ElapsedNs(Clock::time_point a, Clock::time_point b)
+{
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count());
+}
+
+//------------------------------------------------------------------
+// Scenario
+//------------------------------------------------------------------
+struct ScenarioResult {
+    double spawnNsPerParticle;
+    double updateNsPerParticle;
+    double drawNsPerParticle;
+    double packNsPerParticle, unpackNsPerParticle; // ParticlePool::Push / Get
+    double frameP50, frameP90, frameP99, frameMax; // milliseconds
+    double avgLive;
+    size_t evicted;
+    size_t dropped;
+    SpriteCacheStats sprites;
+    uint32_t checksum;  // Final frame
+    size_t peakRssKb;
+};
+
+#define PACK_PASSES 8 // Over the final live set
+
+static ScenarioResult RunScenario(const EffectInfo& effect, const PathInfo& path,
+                                  size_t count, const Canvas& canvas,
+                                  std::vector<uint32_t>& pixels,
+                                  int frames, unsigned seed)
+{
+    const int warmupFrames = 10;
+    const float dt = 1.0f / 60.0f;
+
+    // Budget leaves 25% headroom over the target so the measured spawns
+    // only hit the overflow policy on bursts.
+    SeedParticleRng(seed);
+    for (int t = 1; t <= PARTICLE_TYPE_COUNT; t++) {
+        SetParticleBudget(static_cast<ParticleType>(t), count + count / 4);
+    }
+    ClearParticles();
+    ClearSpriteCache();
+    std::fill(pixels.begin(), pixels.end(), 0u);
+    Framebuffer fb = {};
+    fb.pixels = pixels.data();
+    fb.width  = canvas.width;
+    fb.height = canvas.height;
+    SetFramebuffer(fb);
+    SetActiveParticleSystem(effect.systemId);
+    if (s_forces) {
+        const Rect area = { 0, 0, canvas.width, canvas.height };
+        SetForceFieldBounds(area);
+        SetWind(40.f, 0.f);
+        SetTurbulence(200.f, 150.f, 0.5f);
+    }
+
+    double spawnNs = 0, updateNs = 0, drawNs = 0;
+    double spawned = 0, updated = 0, drawn = 0;
+    std::vector<double> frameMs;
+    frameMs.reserve(frames);
+
+    for (int frame = 0; frame < warmupFrames + frames; frame++) {
+        Point pos = PathPosition(path.kind, frame, canvas);
+        TopUpParticles(count, pos);
+        s_cursor = pos;
+
+        size_t before = GetLiveParticleCount();
+        Clock::time_point t0 = Clock::now();
+        SpawnParticlesOnMouseMove();
+        Clock::time_point t1 = Clock::now();
+        size_t live = GetLiveParticleCount();
+        if (s_forces) {
+            ClearForcePoints();
+            ForcePoint repulsor = { static_cast<float>(pos.x), static_cast<float>(pos.y), -600.f, 150.f };
+            AddForcePoint(repulsor);
+            BuildForceField(frame * dt);
+        }
+        UpdateParticles(dt);
+        Clock::time_point t2 = Clock::now();
+        size_t remaining = GetLiveParticleCount();
+        DrawParticlesToDIB();
+        Clock::time_point t3 = Clock::now();
+        MT_PROFILE_COLLECT();
+
+        if (frame == warmupFrames - 1) {
+            ResetPoolStats();
+            ResetSpriteCacheStats();
+        }
+        if (frame < warmupFrames) continue;
+
+        spawnNs  += ElapsedNs(t0, t1);
+        updateNs += ElapsedNs(t1, t2);
+        drawNs   += ElapsedNs(t2, t3);
+        spawned  += static_cast<double>(live - before);
+        updated  += static_cast<double>(live);
+        drawn    += static_cast<double>(remaining);
+        frameMs.push_back(ElapsedNs(t0, t3) / 1e6);
+    }
+
+    ScenarioResult r = {};
+    r.spawnNsPerParticle  = spawned > 0 ? spawnNs / spawned : 0.0;
+    r.updateNsPerParticle = updated > 0 ? updateNs / updated : 0.0;
+    r.drawNsPerParticle   = drawn > 0 ? drawNs / drawn : 0.0;
+    r.frameP50 = Percentile(frameMs, 50);
+    r.frameP90 = Percentile(frameMs, 90);
+    r.frameP99 = Percentile(frameMs, 99);
+    r.frameMax = Percentile(frameMs, 100);
+    r.avgLive  = frames > 0 ? updated / frames : 0.0;
+    r.evicted  = GetPoolStats(effect.type).evicted;
+    r.dropped  = GetPoolStats(effect.type).dropped;
+    r.sprites  = GetSpriteCacheStats();
+    r.checksum = Checksum(pixels);
+    ClearForceField();
+
+    // Unpack the live set and pack it into a pool of the same type
+    const ParticlePool& pool = GetPool(effect.type);
+    ParticlePool scratch(effect.type, pool.Capacity());
+    std::vector<Particle> unpacked(pool.Size());
+    double packNs = 0, unpackNs = 0;
+    for (int pass = 0; pass < PACK_PASSES; pass++) {
+        scratch.Clear();
+        Clock::time_point t0 = Clock::now();
+        for (size_t i = 0; i < unpacked.size(); i++) unpacked[i] = pool.Get(i);
+        Clock::time_point t1 = Clock::now();
+        for (const Particle& p : unpacked) scratch.Push(p);
+        Clock::time_point t2 = Clock::now();
+        unpackNs += ElapsedNs(t0, t1);
+        packNs   += ElapsedNs(t1, t2);
+    }
+    const double converted = static_cast<double>(unpacked.size()) * PACK_PASSES;
+    r.packNsPerParticle   = converted > 0 ? packNs / converted : 0.0;
+    r.unpackNsPerParticle = converted > 0 ? unpackNs / converted : 0.0;
+    r.peakRssKb = PeakRssKb();
+    return r;
+}
+
+//------------------------------------------------------------------
+// main
+//------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    int frames = 60;
+    unsigned seed = 12345;
+    const char* outPath = nullptr;
+    const char* profileCsvPath = nullptr;
+    const char* tracePath = nullptr;
+    std::vector<const EffectInfo*> effects;
+    std::vector<const PathInfo*> paths;
+    std::vector<size_t> counts;
+    std::vector<Canvas> canvases;
+    std::vector<int> threadCounts;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!val) {
+            fprintf(stderr, "missing value for %s\n", arg);
+            return 1;
+        }
+        i++;
+
+        if (strcmp(arg, "--frames") == 0) {
+            frames = atoi(val);
+        } else if (strcmp(arg, "--seed") == 0) {
+            seed = static_cast<unsigned>(strtoul(val, nullptr, 10));
+        } else if (strcmp(arg, "--out") == 0) {
+            outPath = val;
+        } else if (strcmp(arg, "--profile-csv") == 0) {
+            profileCsvPath = val;
+        } else if (strcmp(arg, "--trace") == 0) {
+            tracePath = val;
+        } else if (strcmp(arg, "--policy") == 0) {
+            if (strcmp(val, "drop") == 0)            SetOverflowPolicy(OverflowPolicy::DROP_NEW);
+            else if (strcmp(val, "oldest") == 0)     SetOverflowPolicy(OverflowPolicy::EVICT_OLDEST);
+            else if (strcmp(val, "least-life") == 0) SetOverflowPolicy(OverflowPolicy::EVICT_LEAST_LIFE);
+            else { fprintf(stderr, "unknown policy '%s'\n", val); return 1; }
+        } else if (strcmp(arg, "--forces") == 0) {
+            if (strcmp(val, "on") == 0)       s_forces = true;
+            else if (strcmp(val, "off") == 0) s_forces = false;
+            else { fprintf(stderr, "unknown --forces value '%s'\n", val); return 1; }
+        } else if (strcmp(arg, "--sprite-cache-kb") == 0) {
+            SetSpriteCacheBudget(static_cast<size_t>(strtoul(val, nullptr, 10)) * 1024);
+        } else if (strcmp(arg, "--simd") == 0) {
+            bool known = false;
+            for (SimdLevel level : { SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON }) {
+                if (strcmp(val, SimdLevelName(level)) != 0) continue;
+                known = true;
+                if (!SetUpdateKernelLevel(level)) {
+                    fprintf(stderr, "SIMD level '%s' not supported on this machine\n", val);
+                    return 1;
+                }
+                SetBlendKernelLevel(level); // Falls back to scalar where there is no blend kernel
+                SetForceKernelLevel(level);
+            }
+            if (!known) { fprintf(stderr, "unknown SIMD level '%s'\n", val); return 1; }
+        } else if (strcmp(arg, "--effects") == 0) {
+            for (const std::string& name : SplitList(val)) {
+                const EffectInfo* found = nullptr;
+                for (const EffectInfo& e : EFFECTS)
+                    if (name == e.name) found = &e;
+                if (!found) { fprintf(stderr, "unknown effect '%s'\n", name.c_str()); return 1; }
+                effects.push_back(found);
+            }
+        } else if (strcmp(arg, "--paths") == 0) {
+            for (const std::string& name : SplitList(val)) {
+                const PathInfo* found = nullptr;
+                for (const PathInfo& p : PATHS)
+                    if (name == p.name) found = &p;
+                if (!found) { fprintf(stderr, "unknown path '%s'\n", name.c_str()); return 1; }
+                paths.push_back(found);
+            }
+        } else if (strcmp(arg, "--counts") == 0) {
+            for (const std::string& c : SplitList(val))
+                counts.push_back(static_cast<size_t>(strtoul(c.c_str(), nullptr, 10)));
+        } else if (strcmp(arg, "--threads") == 0) {
+            for (const std::string& t : SplitList(val)) {
+                int n = atoi(t.c_str());
+                if (n <= 0 || n > MAX_WORKER_THREADS) {
+                    fprintf(stderr, "bad thread count '%s'\n", t.c_str());
+                    return 1;
+                }
+                threadCounts.push_back(n);
+            }
+        } else if (strcmp(arg, "--canvases") == 0) {
+            for (const std::string& c : SplitList(val)) {
+                Canvas canvas = {};
+                if (sscanf(c.c_str(), "%dx%d", &canvas.width, &canvas.height) != 2 ||
+                    canvas.width <= 0 || canvas.height <= 0) {
+                    fprintf(stderr, "bad canvas '%s'\n", c.c_str());
+                    return 1;
+                }
+                canvases.push_back(canvas);
+            }
+        } else {
+            fprintf(stderr, "unknown option %s\n", arg);
+            return 1;
+        }
+    }
+
+    if (effects.empty())
+        for (const EffectInfo& e : EFFECTS) effects.push_back(&e);
+    if (paths.empty())
+        for (const PathInfo& p : PATHS) paths.push_back(&p);
+    if (counts.empty())
+        counts = { 1000, 10000, 100000 };
+    if (canvases.empty())
+        canvases = { { 1920, 1080 }, { 3840, 2160 }, { 7680, 2160 } };
+    if (threadCounts.empty()) {
+        // Single-threaded baseline plus every hardware thread
+        threadCounts.push_back(1);
+        int hardware = static_cast<int>(std::thread::hardware_concurrency());
+        if (hardware > 1) threadCounts.push_back(std::min(hardware, MAX_WORKER_THREADS));
+    }
+    if (frames <= 0) {
+        fprintf(stderr, "--frames must be positive\n");
+        return 1;
+    }
+
+    if ((profileCsvPath || tracePath) && !MT_ENABLE_PROFILING) {
+        fprintf(stderr, "--profile-csv and --trace need a build with MOUSETRAIL_PROFILING=ON\n");
+        return 1;
+    }
+    SetProfileTraceCapture(tracePath != nullptr);
+
+    SetCursorSource(BenchCursor);
+
+    FILE* out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "cannot open %s\n", outPath);
+        return 1;
+    }
+
+    fprintf(out, "{\n  \"frames_per_scenario\": %d,\n  \"seed\": %u,\n  \"update_kernel\": \"%s\",\n  \"blend_kernel\": \"%s\",\n  \"force_kernel\": \"%s\",\n  \"force_field\": %s,\n  \"particle_bytes\": %zu,\n  \"results\": [",
+            frames, seed, SimdLevelName(GetUpdateKernelLevel()), SimdLevelName(GetBlendKernelLevel()),
+            SimdLevelName(GetForceKernelLevel()), s_forces ? "true" : "false", ParticlePool::ENTRY_BYTES);
+    bool first = true;
+    for (const Canvas& canvas : canvases) {
+        std::vector<uint32_t> pixels(static_cast<size_t>(canvas.width) * canvas.height, 0u);
+        for (const EffectInfo* effect : effects) {
+            for (const PathInfo* path : paths) {
+                for (size_t count : counts) {
+                  ScenarioResult baseline = {};
+                  for (size_t t = 0; t < threadCounts.size(); t++) {
+                    SetDrawThreadCount(threadCounts[t]);
+                    ScenarioResult r = RunScenario(*effect, *path, count, canvas, pixels, frames, seed);
+                    if (t == 0) baseline = r;
+                    double speedup = r.drawNsPerParticle > 0 ? baseline.drawNsPerParticle / r.drawNsPerParticle : 0.0;
+                    fprintf(out, "%s\n    {\"effect\": \"%s\", \"path\": \"%s\", \"particles\": %zu, "
+                                 "\"canvas\": \"%dx%d\", \"threads\": %d, \"avg_live\": %.1f, "
+                                 "\"spawn_ns_per_particle\": %.2f, \"update_ns_per_particle\": %.2f, "
+                                 "\"draw_ns_per_particle\": %.2f, \"draw_speedup\": %.2f, \"pixels_match\": %s, "
+                                 "\"pack_ns_per_particle\": %.2f, \"unpack_ns_per_particle\": %.2f, "
+                                 "\"frame_ms\": {\"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f}, "
+                                 "\"evicted\": %zu, \"dropped\": %zu, "
+                                 "\"sprite_cache\": {\"hits\": %zu, \"misses\": %zu, \"evictions\": %zu, \"kb\": %zu}, "
+                                 "\"peak_rss_kb\": %zu}",
+                            first ? "" : ",", effect->name, path->name, count,
+                            canvas.width, canvas.height, threadCounts[t], r.avgLive,
+                            r.spawnNsPerParticle, r.updateNsPerParticle, r.drawNsPerParticle,
+                            speedup, r.checksum == baseline.checksum ? "true" : "false",
+                            r.packNsPerParticle, r.unpackNsPerParticle,
+                            r.frameP50, r.frameP90, r.frameP99, r.frameMax,
+                            r.evicted, r.dropped,
+                            r.sprites.hits, r.sprites.misses, r.sprites.evictions, r.sprites.bytes / 1024,
+                            r.peakRssKb);
+                    fflush(out);
+                    first = false;
+                  }
+                }
+            }
+        }
+    }
+    fprintf(out, "\n  ],\n  \"peak_rss_kb\": %zu\n}\n", PeakRssKb());
+
+    if (out != stdout) fclose(out);
+
+    if (profileCsvPath && !WriteProfileCsv(profileCsvPath)) {
+        fprintf(stderr, "cannot write %s\n", profileCsvPath);
+        return 1;
+    }
+    if (tracePath && !WriteChromeTrace(tracePath)) {
+        fprintf(stderr, "cannot write %s\n", tracePath);
+        return 1;
+    }
+    if (GetProfileEventsLost() > 0) {
+        fprintf(stderr, "profiler: %llu events lost\n", static_cast<unsigned long long>(GetProfileEventsLost()));
+    }
+    return 0;
+}
@@ -0,0 +1,1921 @@
+// tools/headless.cpp
+//
+// Headless front end for the particle core: moves a synthetic cursor in
+// a circle, runs spawn -> update -> draw into an in-memory framebuffer,
+// and prints a checksum of the final frame.
+//
+// With a present rate, frames instead go through the frame pipeline:
+// this thread simulates at the fixed step and draws interpolated frames
+// at that rate into a triple buffer, while a present thread takes the
+// newest one each time and checks that frames arrive in order and are
+// never modified while it holds them. Exits with 2 if either fails.
+//
+// --idle runs the frame scheduler on a fake clock instead: the cursor
+// circles, stops, and once the scheduler has gone idle jumps once. It
+// reports how long the scheduler took to go idle after the last
+// particle expired and to resume after the jump, and exits with 2 if
+// either exceeds its bound.
+//
+// --input spawns a fast circular gesture reported at 1 kHz twice at the
+// given frame rate: sampling the cursor once per frame, and walking the
+// timestamped event queue. It reports how far spawn points stray from
+// the circle and exits with 2 if the queued trail strays more than
+// INPUT_MAX_DEVIATION pixels.
+//
+// --surface draws into triple-buffered surfaces placed the way the
+// Windows front end places them, either covering the whole width x
+// height desktop or fitted to the trail, and reports surface memory,
+// bytes presented per frame and peak working set; run it once per mode
+// to compare. Exits with 2 if the final frame differs from drawing
+// into one desktop-sized framebuffer.
+//
+// --governor feeds the frame governor made-up frame times against a
+// budget of the given milliseconds of work per frame: a sustained
+// overload, then headroom. Exits with 2 unless detail drops every
+// GOVERNOR_CUT_INTERVAL frames down to GOVERNOR_MIN_DETAIL and no lower,
+// then climbs back to full in GOVERNOR_RESTORE_STEP steps. It then runs
+// a load phase (the cursor circling eight times as fast) and lets the
+// trail fade, once at full detail and once governed, and reports frame
+// times, budget misses and detail levels; that part depends on this
+// machine's speed and only reports.
+//
+// --raster rasterizes random triangles (some pixel-aligned, some clipped)
+// and compares every pixel against a brute-force top-left-rule test, and
+// checks that two triangles sharing an edge draw each pixel along it
+// exactly once and that zero-area triangles draw nothing. Random line
+// segments, some reaching far outside the clip, are compared the same
+// way, drawn in both directions. Exits with 2 on any difference.
+//
+// --record writes a session (session_record.h) of the --input gesture
+// at 1 kHz, drawn at RECORD_FPS with interpolation, switching to the
+// next effect halfway and running at half detail for a stretch before
+// that. It prints the file size and the same final checksum and run
+// hash mousetrail_replay prints for the file.
+//
+// --emitters drives the given number of emitters (emitters.h), each
+// circling its own spot at 1 kHz with two effects, replacing a third of
+// them halfway. It reports the time SpawnEmitters takes and how far new
+// particles stray from their emitter's circle, and exits with 2 if they
+// stray more than INPUT_MAX_DEVIATION pixels, a destroyed emitter's id
+// is still accepted, or a second run with every draw thread differs.
+//
+// --dirty draws the same trail (a fixed-size circle, then standing
+// still until every particle has expired) into a 1920x1080 and a
+// 7680x2160 framebuffer and reports the bytes cleared and presented
+// (bounds of g_dirtyRegion) per frame on each. Exits with 2 if either
+// grows with the canvas instead of the trail, or if any pixel is left
+// set once the trail is gone.
+//
+// --profiler checks the frame profiler (frame_profiler.h) without the
+// MT_PROFILE_* macros, so in any build: histogram percentiles against
+// the exact ones of random samples (within a bucket, ~6%), four threads
+// recording spans and counters while this one collects (every event
+// either collected whole or counted lost), and the CSV and trace
+// exports (one row per stage and counter, one event per captured
+// span). Exits with 2 on any failure.
+//
+// --kernels runs every update kernel this machine supports (SSE2, AVX2,
+// NEON) against the scalar one on random streams: lengths that are not
+// multiples of the vector width, steps that run lives out, and fades
+// that overflow the scale's range or divide by a zero life. Positions
+// and velocities must match exactly and life and scale within one unit;
+// exits with 2 otherwise.
+//
+// --blend runs every blend kernel this machine supports (SSE2, AVX2)
+// against the scalar one on random premultiplied sources, random
+// destinations, random coverage (with empty runs) and span lengths
+// 0-37 at every alignment, and reports each kernel's time per pixel for
+// solid spans and coverage spans. Results must match bit for bit; exits
+// with 2 otherwise.
+//
+// --forces builds a force field (force_field.h) of wind, turbulence and
+// the given number of attractors/repulsors over the surface every frame
+// and samples it at random positions, some outside the surface, with
+// every SIMD kernel this machine runs. It reports the build time and the
+// sampling time per particle, and exits with 2 if a kernel differs from
+// the scalar one in any bit, the turbulence on its own is not
+// divergence-free, or a smoke trail under a wind does not drift with it.
+//
+// Usage: mousetrail_headless [effect 1-6] [frames] [width] [height] [draw threads]
+//                            [present Hz]
+//        mousetrail_headless --idle [effect 1-6] [move seconds]
+//        mousetrail_headless --input [effect 1-6, not 5] [fps]
+//        mousetrail_headless --surface fit|desktop [effect 1-6] [frames] [width] [height]
+//        mousetrail_headless --governor [effect 1-6] [budget ms] [frames]
+//        mousetrail_headless --raster [cases]
+//        mousetrail_headless --record <file> [effect 1-6] [frames]
+//        mousetrail_headless --emitters [count] [frames]
+//        mousetrail_headless --dirty [effect 1-6, 0 = all]
+//        mousetrail_headless --profiler [events per thread]
+//        mousetrail_headless --kernels [cases]
+//        mousetrail_headless --blend [cases]
+//        mousetrail_headless --forces [points] [frames]
+
+#include "particles.h"
+#include "emitters.h"
+#include "force_field.h"
+#include "frame_pipeline.h"
+#include "frame_scheduler.h"
+#include "frame_governor.h"
+#include "frame_profiler.h"
+#include "blend_kernels.h"
+#include "overlay_surface.h"
+#include "raster.h"
+#include "rng.h"
+#include "session_record.h"
+#include "sprite_cache.h"
+#include "update_kernels.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cinttypes>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+  #include <windows.h>
+  #include <psapi.h>
+#else
+  #include <sys/resource.h>
+#endif
+
+static float s_time   = 0.f; // Simulated seconds
+static float s_speed  = 1.f; // Revolutions per 2 seconds
+static float s_stopAt = 1e30f; // Cursor stands still from here on
+static int   s_shiftX = 0;     // Horizontal jump applied to the cursor
+static int   s_width  = 1920;
+static int   s_height = 1080;
+
+// Circle around the middle of the surface, one revolution every 2 seconds.
+static bool SyntheticCursor(Point* pt)
+{
+    float t = std::min(s_time, s_stopAt) * s_speed;
+    float radius = s_height * 0.3f;
+    pt->x = static_cast<int>(s_width * 0.5f + radius * cosf(t * 3.14159f)) + s_shiftX;
+    pt->y = static_cast<int>(s_height * 0.5f + radius * sinf(t * 3.14159f));
+    return true;
+}
+
+// Whole decimal integer, nothing else: "--help" or "3x" is not an effect
+static bool ParseInt(const char* text, int* value)
+{
+    char* end = nullptr;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < INT_MIN || parsed > INT_MAX) return false;
+    *value = static_cast<int>(parsed);
+    return true;
+}
+
+static bool ParseDouble(const char* text, double* value)
+{
+    char* end = nullptr;
+    errno = 0;
+    double parsed = strtod(text, &end);
+    if (end == text || *end != '\0' || errno == ERANGE || !std::isfinite(parsed)) return false;
+    *value = parsed;
+    return true;
+}
+
+// FNV-1a over the pixel data
+static uint32_t Checksum(const std::vector<uint32_t>& pixels)
+{
+    uint32_t hash = 2166136261u;
+    for (uint32_t px : pixels) {
+        for (int i = 0; i < 4; i++) {
+            hash ^= (px >> (i * 8)) & 0xFF;
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+static size_t PeakRssKb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc = {};
+    GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+    return pmc.PeakWorkingSetSize / 1024;
+#else
+    struct rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+  #ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss) / 1024; // bytes on macOS
+  #else
+    return static_cast<size_t>(usage.ru_maxrss);        // kilobytes on Linux
+  #endif
+#endif
+}
+
+//------------------------------------------------------------------
+// Pipelined mode
+//------------------------------------------------------------------
+static FrameSlot s_slots[FRAME_SLOT_COUNT];
+static std::vector<uint32_t> s_slotPixels[FRAME_SLOT_COUNT];
+static uint32_t s_slotHash[FRAME_SLOT_COUNT]; // Hash at publish time
+static FrameTripleBuffer s_frames;
+static std::atomic<uint64_t> s_finalSequence(0); // Set after the last Publish
+
+struct PresentReport {
+    int presented;
+    int outOfOrder; // Sequence not above the previous one
+    int torn;       // Pixels differ from what was published
+};
+
+// FNV-1a over whole pixels: cheaper than Checksum, enough to spot changes
+static uint32_t HashPixels(const std::vector<uint32_t>& pixels)
+{
+    uint32_t hash = 2166136261u;
+    for (uint32_t px : pixels) {
+        hash ^= px;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void PresentThread(PresentReport* report)
+{
+    uint64_t shown = 0;
+    for (;;) {
+        if (!s_frames.AcquireLatest()) {
+            if (shown != 0 && shown == s_finalSequence.load(std::memory_order_acquire)) break;
+            std::this_thread::yield();
+            continue;
+        }
+        const int front = s_frames.FrontSlot();
+        const uint64_t sequence = s_slots[front].sequence;
+        if (sequence <= shown) report->outOfOrder++;
+        if (HashPixels(s_slotPixels[front]) != s_slotHash[front]) report->torn++;
+        shown = sequence;
+        report->presented++;
+    }
+}
+
+static int RunPipelined(int frames, float presentHz, uint32_t* finalChecksum)
+{
+    for (int i = 0; i < FRAME_SLOT_COUNT; i++) {
+        s_slotPixels[i].assign(static_cast<size_t>(s_width) * s_height, 0);
+        s_slots[i].target.fb.pixels = s_slotPixels[i].data();
+        s_slots[i].target.fb.width  = s_width;
+        s_slots[i].target.fb.height = s_height;
+        ClearDirtyRegion(s_slots[i].target.drawn);
+        s_slots[i].sequence = 0;
+    }
+    s_frames.Reset();
+
+    PresentReport report = {};
+    std::thread present(PresentThread, &report);
+
+    FixedTimestep timestep;
+    for (int f = 1; f <= frames; f++) {
+        for (int steps = timestep.Advance(1.0f / presentHz); steps > 0; steps--) {
+            s_time += timestep.step;
+            SpawnParticlesOnMouseMove();
+            UpdateParticles(timestep.step);
+        }
+
+        const int back = s_frames.BackSlot();
+        DrawParticlesToTarget(s_slots[back].target, timestep.Alpha());
+        s_slots[back].sequence = f;
+        s_slotHash[back] = HashPixels(s_slotPixels[back]);
+        s_frames.Publish();
+    }
+    s_finalSequence.store(frames, std::memory_order_release);
+    present.join();
+
+    // The present thread finished on the last frame, which it still holds
+    *finalChecksum = Checksum(s_slotPixels[s_frames.FrontSlot()]);
+    printf("presented=%d skipped=%d out_of_order=%d torn=%d\n",
+           report.presented, frames - report.presented, report.outOfOrder, report.torn);
+    return (report.outOfOrder || report.torn) ? 2 : 0;
+}
+
+//------------------------------------------------------------------
+// Idle check
+//  The fake clock only moves when the scheduler sleeps. Waiting for a
+//  wake-up stands for the user touching the mouse half a second later,
+//  once; the second wait ends the run.
+//------------------------------------------------------------------
+#define IDLE_FRAME_INTERVAL (1.0 / 60.0)
+
+struct FakeClock {
+    double time;
+    bool   pending;    // Wake() called since the last waitForWake
+    int    inputsLeft; // Cursor jumps still to come
+    double inputTime;  // When the last one happened
+    bool   finished;   // Waited with no input left
+    FrameScheduler* scheduler;
+};
+
+static double FakeNow(void* context)
+{
+    return static_cast<FakeClock*>(context)->time;
+}
+
+static void FakeSleepUntil(void* context, double time)
+{
+    FakeClock* fake = static_cast<FakeClock*>(context);
+    fake->time = std::max(fake->time, time);
+}
+
+static void FakeWaitForWake(void* context)
+{
+    FakeClock* fake = static_cast<FakeClock*>(context);
+    if (!fake->pending) {
+        if (fake->inputsLeft > 0) {
+            fake->inputsLeft--;
+            fake->time += 0.5;
+            fake->inputTime = fake->time;
+            s_shiftX += 150;
+            fake->scheduler->Wake(); // Sets pending through FakeWake
+        } else {
+            fake->finished = true;
+        }
+    }
+    fake->pending = false;
+}
+
+static void FakeWake(void* context)
+{
+    static_cast<FakeClock*>(context)->pending = true;
+}
+
+static int RunIdleCheck(float moveSeconds)
+{
+    FakeClock fake = {};
+    fake.inputsLeft = 1;
+    SchedulerClock clock;
+    clock.now         = FakeNow;
+    clock.sleepUntil  = FakeSleepUntil;
+    clock.waitForWake = FakeWaitForWake;
+    clock.wake        = FakeWake;
+    clock.context     = &fake;
+    FrameScheduler scheduler(clock, IDLE_FRAME_INTERVAL);
+    fake.scheduler = &scheduler;
+
+    std::vector<uint32_t> pixels(static_cast<size_t>(s_width) * s_height, 0);
+    FrameTarget target = {};
+    target.fb.pixels = pixels.data();
+    target.fb.width  = s_width;
+    target.fb.height = s_height;
+
+    s_stopAt = moveSeconds;
+    FixedTimestep timestep;
+    uint64_t sequence = 0;
+    double last = 0.0;
+    double lastExpiry = -1.0;  // Frame in which the trail died out
+    double idleEntry = -1.0;   // First idle entry after that
+    double wakeLatency = -1.0;
+    bool wokeWithParticles = false;
+
+    for (;;) {
+        bool resumed = scheduler.WaitForNextFrame();
+        if (fake.finished) break;
+        if (resumed) {
+            if (idleEntry < 0.0) idleEntry = scheduler.GetStats().idleSince;
+            wakeLatency = fake.time - fake.inputTime;
+            last = fake.time;
+            timestep.accumulator = timestep.step;
+        }
+
+        const bool hadParticles = GetLiveParticleCount() > 0;
+        for (int steps = timestep.Advance(static_cast<float>(fake.time - last)); steps > 0; steps--) {
+            s_time += timestep.step;
+            SpawnParticlesOnMouseMove();
+            UpdateParticles(timestep.step);
+        }
+        last = fake.time;
+        if (resumed) wokeWithParticles = GetLiveParticleCount() > 0;
+        if (hadParticles && GetLiveParticleCount() == 0 && lastExpiry < 0.0) lastExpiry = fake.time;
+
+        // A moving mouse keeps reporting input
+        if (s_time < s_stopAt) scheduler.Wake();
+
+        DrawParticlesToTarget(target, timestep.Alpha());
+        sequence++;
+        scheduler.FrameProduced(sequence, GetLiveParticleCount() == 0 && target.drawn.count == 0);
+        scheduler.FramePresented(sequence);
+    }
+
+    const SchedulerStats stats = scheduler.GetStats();
+    const double idleEntryMs = (idleEntry - lastExpiry) * 1000.0;
+    const double wakeMs = wakeLatency * 1000.0;
+    printf("frames=%llu idle_entries=%llu wake_ups=%llu\n",
+           static_cast<unsigned long long>(sequence),
+           static_cast<unsigned long long>(stats.idleEntries),
+           static_cast<unsigned long long>(stats.wakeUps));
+    printf("still_to_idle_ms=%.1f idle_entry_ms=%.1f wake_latency_ms=%.1f woke_with_particles=%d\n",
+           (idleEntry - moveSeconds) * 1000.0, idleEntryMs, wakeMs, wokeWithParticles ? 1 : 0);
+
+    // Idle within two frames of the trail dying out; the first frame
+    // after the input is produced without waiting for the next tick.
+    const bool ok = lastExpiry >= 0.0 && idleEntry >= lastExpiry &&
+                    idleEntryMs <= 2000.0 * IDLE_FRAME_INTERVAL &&
+                    wakeLatency >= 0.0 && wakeMs < 1000.0 * IDLE_FRAME_INTERVAL &&
+                    wokeWithParticles && stats.idleEntries == 2;
+    return ok ? 0 : 2;
+}
+
+//------------------------------------------------------------------
+// Input check
+//  Emission points are recovered from fresh particles by undoing the
+//  spawn-time aging (age = maxLife - life before their first update).
+//------------------------------------------------------------------
+#define INPUT_EVENT_HZ         1000
+#define INPUT_SECONDS          1.0
+#define INPUT_RADIUS           150.f
+#define INPUT_TURNS_PER_SECOND 3.f
+#define INPUT_MAX_DEVIATION    1.5f // Pixels
+
+static CursorEventQueue s_inputQueue;
+
+// Where the gesture is at "time", rounded to whole pixels like a real cursor
+static CursorEvent GestureAt(double time)
+{
+    const double turn = 2.0 * 3.14159265358979 * INPUT_TURNS_PER_SECOND * time;
+    CursorEvent e;
+    e.time = time;
+    e.x = std::round(s_width * 0.5f + INPUT_RADIUS * static_cast<float>(cos(turn)));
+    e.y = std::round(s_height * 0.5f + INPUT_RADIUS * static_cast<float>(sin(turn)));
+    return e;
+}
+
+static bool GestureCursor(Point* pt)
+{
+    CursorEvent e = GestureAt(s_time);
+    pt->x = static_cast<int>(e.x);
+    pt->y = static_cast<int>(e.y);
+    return true;
+}
+
+struct TrailReport {
+    size_t spawned;
+    double meanDeviation;
+    float  maxDeviation;
+};
+
+static TrailReport RunTrail(bool queued, float fps)
+{
+    ClearParticles();
+    s_inputQueue.Clear();
+    SetCursorEventQueue(queued ? &s_inputQueue : nullptr);
+    SetCursorSource(GestureCursor);
+    const ParticlePool& pool = GetPool(g_activeParticleSystem);
+
+    TrailReport report = {};
+    FixedTimestep timestep;
+    int nextEvent = 0;
+    double now = 0.0;
+    for (int frame = 1; now < INPUT_SECONDS; frame++) {
+        now = frame / static_cast<double>(fps);
+        s_time = static_cast<float>(now);
+
+        // What the input thread queued since the last frame
+        for (; nextEvent <= now * INPUT_EVENT_HZ; nextEvent++) {
+            s_inputQueue.Push(GestureAt(nextEvent / static_cast<double>(INPUT_EVENT_HZ)));
+        }
+
+        const int steps = timestep.Advance(1.0f / fps);
+        const double simTime = now - timestep.accumulator;
+        for (int i = steps; i > 0; i--) {
+            const size_t before = pool.Size();
+            if (queued) {
+                SpawnParticlesUntil(simTime - (i - 1) * static_cast<double>(timestep.step));
+            } else {
+                SpawnParticlesOnMouseMove();
+            }
+            for (size_t k = before; k < pool.Size(); k++) {
+                float age = pool.MaxLife(k) - pool.Life(k);
+                float dx = pool.x[k] - pool.vx[k] * age - s_width * 0.5f;
+                float dy = pool.y[k] - pool.vy[k] * age - s_height * 0.5f;
+                float deviation = fabsf(std::sqrt(dx * dx + dy * dy) - INPUT_RADIUS);
+                report.meanDeviation += deviation;
+                report.maxDeviation = std::max(report.maxDeviation, deviation);
+                report.spawned++;
+            }
+            UpdateParticles(timestep.step);
+        }
+    }
+    if (report.spawned) report.meanDeviation /= report.spawned;
+    SetCursorEventQueue(nullptr);
+    return report;
+}
+
+static int RunInputCheck(float fps)
+{
+    TrailReport sampled = RunTrail(false, fps);
+    TrailReport queued  = RunTrail(true, fps);
+    printf("sampled: spawned=%zu mean_deviation=%.2f max_deviation=%.2f\n",
+           sampled.spawned, sampled.meanDeviation, sampled.maxDeviation);
+    printf("queued:  spawned=%zu mean_deviation=%.2f max_deviation=%.2f dropped=%llu\n",
+           queued.spawned, queued.meanDeviation, queued.maxDeviation,
+           static_cast<unsigned long long>(s_inputQueue.Dropped()));
+    return (queued.spawned > 0 && queued.maxDeviation <= INPUT_MAX_DEVIATION) ? 0 : 2;
+}
+
+//------------------------------------------------------------------
+// Surface check
+//  Slots are used round-robin, as with a present thread that keeps up.
+//  Presented bytes follow the Windows present thread: the bounds of the
+//  dirty region, or the whole surface after it changed size.
+//------------------------------------------------------------------
+static uint32_t RenderReference(int frames)
+{
+    std::vector<uint32_t> pixels(static_cast<size_t>(s_width) * s_height, 0);
+    Framebuffer fb = {};
+    fb.pixels = pixels.data();
+    fb.width  = s_width;
+    fb.height = s_height;
+    SetFramebuffer(fb);
+    for (int frame = 0; frame < frames; frame++) {
+        s_time = frame / 60.0f;
+        SpawnParticlesOnMouseMove();
+        UpdateParticles(1.0f / 60.0f);
+        DrawParticlesToDIB();
+    }
+    return Checksum(pixels);
+}
+
+static int RunSurfaceCheck(bool fit, int frames)
+{
+    OverlaySurface surface(fit);
+    surface.Reset(Rect{ 0, 0, s_width, s_height });
+
+    const Rect initial = surface.Current();
+    for (int i = 0; i < FRAME_SLOT_COUNT; i++) {
+        FrameTarget& target = s_slots[i].target;
+        s_slotPixels[i].assign(static_cast<size_t>(initial.right - initial.left) * (initial.bottom - initial.top), 0);
+        target.fb.pixels  = s_slotPixels[i].data();
+        target.fb.width   = initial.right - initial.left;
+        target.fb.height  = initial.bottom - initial.top;
+        target.fb.originX = initial.left;
+        target.fb.originY = initial.top;
+        ClearDirtyRegion(target.drawn);
+    }
+
+    Framebuffer shown = s_slots[0].target.fb;
+    DirtyRegion onScreen;
+    ClearDirtyRegion(onScreen);
+    size_t peakSurfaceBytes = 0;
+    double presentedBytes = 0.0;
+    int last = 0;
+    for (int frame = 0; frame < frames; frame++) {
+        s_time = frame / 60.0f;
+        SpawnParticlesOnMouseMove();
+        UpdateParticles(1.0f / 60.0f);
+
+        last = frame % FRAME_SLOT_COUNT;
+        FrameTarget& target = s_slots[last].target;
+        const Rect area = surface.Place(GetParticleBounds());
+        const int width  = area.right - area.left;
+        const int height = area.bottom - area.top;
+        if (target.fb.width != width || target.fb.height != height) {
+            // A new, zero-filled surface (and the old memory released)
+            std::vector<uint32_t>(static_cast<size_t>(width) * height, 0).swap(s_slotPixels[last]);
+            target.fb.pixels = s_slotPixels[last].data();
+            target.fb.width  = width;
+            target.fb.height = height;
+            ClearDirtyRegion(target.drawn);
+        }
+        target.fb.originX = area.left;
+        target.fb.originY = area.top;
+        DrawParticlesToTarget(target, 1.0f);
+
+        size_t surfaceBytes = 0;
+        for (int i = 0; i < FRAME_SLOT_COUNT; i++) surfaceBytes += s_slotPixels[i].size() * sizeof(uint32_t);
+        peakSurfaceBytes = std::max(peakSurfaceBytes, surfaceBytes);
+
+        const Framebuffer& fb = target.fb;
+        if (fb.width != shown.width || fb.height != shown.height) {
+            presentedBytes += static_cast<double>(fb.width) * fb.height * sizeof(uint32_t);
+        } else {
+            DirtyRegion dirty = onScreen;
+            AddDirtyRegion(dirty, target.drawn);
+            const Rect bounds = GetDirtyBounds(dirty); // UpdateOverlay copies the bounding rectangle
+            if (!IsEmptyRect(bounds)) {
+                presentedBytes += static_cast<double>(bounds.right - bounds.left) * (bounds.bottom - bounds.top) * sizeof(uint32_t);
+            }
+        }
+        onScreen = target.drawn;
+        shown = fb;
+    }
+    const size_t peakRssKb = PeakRssKb();
+
+    // The last frame, put back where it was on the desktop
+    const Framebuffer& fb = s_slots[last].target.fb;
+    std::vector<uint32_t> desktop(static_cast<size_t>(s_width) * s_height, 0);
+    for (int y = 0; y < fb.height; y++) {
+        std::copy(fb.pixels + static_cast<size_t>(y) * fb.width, fb.pixels + static_cast<size_t>(y + 1) * fb.width,
+                  desktop.begin() + static_cast<size_t>(fb.originY + y) * s_width + fb.originX);
+    }
+    const uint32_t checksum = Checksum(desktop);
+
+    ClearParticles();
+    SeedParticleRng(1);
+    const uint32_t reference = RenderReference(frames);
+
+    const SurfaceStats stats = surface.stats;
+    printf("surface=%s resizes=%llu moves=%llu\n", fit ? "fit" : "desktop",
+           static_cast<unsigned long long>(stats.resizes), static_cast<unsigned long long>(stats.moves));
+    printf("surface_kb_peak=%zu presented_kb_per_frame=%.1f peak_rss_kb=%zu\n",
+           peakSurfaceBytes / 1024, presentedBytes / frames / 1024.0, peakRssKb);
+    printf("checksum=%08x reference=%08x\n", checksum, reference);
+    return checksum == reference ? 0 : 2;
+}
+
+//------------------------------------------------------------------
+// Governor check
+//------------------------------------------------------------------
+#define GOVERNOR_LOAD_SPEED   8.f // Cursor speed-up during the load phase
+#define GOVERNOR_CHECK_FRAMES 300 // Per phase of the synthetic check
+
+struct GovernorRun {
+    double p50Ms, p90Ms;  // Load phase
+    uint64_t loadMisses;  // Load-phase frames over the budget
+    GovernorStats stats;  // Whole run (governed only)
+};
+
+static double PercentileMs(std::vector<double> ms, double pct)
+{
+    if (ms.empty()) return 0.0;
+    std::sort(ms.begin(), ms.end());
+    size_t i = static_cast<size_t>(pct / 100.0 * (ms.size() - 1) + 0.5);
+    return ms[i];
+}
+
+static GovernorRun RunGoverned(bool governed, double budgetSeconds, int frames)
+{
+    std::vector<uint32_t> pixels(static_cast<size_t>(s_width) * s_height, 0);
+    Framebuffer fb = {};
+    fb.pixels = pixels.data();
+    fb.width  = s_width;
+    fb.height = s_height;
+    SeedParticleRng(1);
+    ClearParticles();
+    SetFramebuffer(fb);
+    SetDetailLevel(1.0f);
+
+    FrameGovernor governor(budgetSeconds);
+    GovernorRun run = {};
+    std::vector<double> loadMs;
+    const int loadFrames = frames / 2;
+    s_speed  = GOVERNOR_LOAD_SPEED;
+    s_stopAt = loadFrames / 60.0f;
+    for (int frame = 0; frame < frames; frame++) {
+        s_time = frame / 60.0f;
+        auto start = std::chrono::steady_clock::now();
+        SpawnParticlesOnMouseMove();
+        UpdateParticles(1.0f / 60.0f);
+        DrawParticlesToDIB();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (frame < loadFrames) {
+            loadMs.push_back(seconds * 1000.0);
+            if (seconds > budgetSeconds) run.loadMisses++;
+        }
+        if (governed) SetDetailLevel(governor.FrameMeasured(seconds));
+    }
+    s_speed  = 1.f;
+    s_stopAt = 1e30f;
+
+    run.p50Ms = PercentileMs(loadMs, 50);
+    run.p90Ms = PercentileMs(loadMs, 90);
+    run.stats = governor.stats;
+    SetDetailLevel(1.0f);
+    return run;
+}
+
+//------------------------------------------------------------------
+// CheckGovernorSteps
+//  Made-up frame times, so the outcome does not depend on this
+//  machine: four budgets of work per frame, then a tenth of one.
+//------------------------------------------------------------------
+static bool CheckGovernorSteps(double budgetSeconds)
+{
+    FrameGovernor governor(budgetSeconds);
+    float detail = governor.Detail();
+    int lastCut = -1, badGaps = 0, badCuts = 0;
+    for (int frame = 0; frame < GOVERNOR_CHECK_FRAMES; frame++) {
+        const float next = governor.FrameMeasured(budgetSeconds * 4.0);
+        if (next > detail || next < GOVERNOR_MIN_DETAIL) badCuts++;
+        if (next < detail) {
+            if (lastCut >= 0 && frame - lastCut != GOVERNOR_CUT_INTERVAL) badGaps++;
+            lastCut = frame;
+        }
+        detail = next;
+    }
+    const uint64_t cuts = governor.stats.cuts;
+    const float floor = detail;
+
+    // Nothing while the average is still above the headroom, then one
+    // step a frame until full
+    int restoreFrames = 0, badSteps = 0;
+    bool restoring = false;
+    while (detail < 1.0f && restoreFrames < GOVERNOR_CHECK_FRAMES) {
+        const float next = governor.FrameMeasured(budgetSeconds * 0.1);
+        const float step = next - detail;
+        if (step != 0.f) restoring = true;
+        const bool whole = std::fabs(step - GOVERNOR_RESTORE_STEP) < 1e-5f;
+        if (restoring && !whole && !(next == 1.0f && step > 0.f && step < GOVERNOR_RESTORE_STEP)) badSteps++;
+        detail = next;
+        restoreFrames++;
+    }
+
+    printf("synthetic: cuts=%llu bad_gaps=%d bad_cuts=%d floor=%.2f restore_frames=%d bad_steps=%d final=%.2f\n",
+           static_cast<unsigned long long>(cuts), badGaps, badCuts, floor, restoreFrames, badSteps, detail);
+    return cuts >= 2 && badGaps == 0 && badCuts == 0 && floor == GOVERNOR_MIN_DETAIL &&
+           badSteps == 0 && detail == 1.0f && governor.stats.cuts == cuts;
+}
+
+static int RunGovernorCheck(double budgetSeconds, int frames)
+{
+    const bool stepsOk = CheckGovernorSteps(budgetSeconds);
+
+    const int loadFrames = frames / 2;
+    GovernorRun full = RunGoverned(false, budgetSeconds, frames);
+    GovernorRun governed = RunGoverned(true, budgetSeconds, frames);
+    printf("full:     load_p50_ms=%.3f load_p90_ms=%.3f load_misses=%llu/%d\n",
+           full.p50Ms, full.p90Ms, static_cast<unsigned long long>(full.loadMisses), loadFrames);
+    printf("governed: load_p50_ms=%.3f load_p90_ms=%.3f load_misses=%llu/%d\n",
+           governed.p50Ms, governed.p90Ms, static_cast<unsigned long long>(governed.loadMisses), loadFrames);
+    printf("detail: min=%.2f final=%.2f cuts=%llu misses=%llu\n",
+           governed.stats.minDetail, governed.stats.detail,
+           static_cast<unsigned long long>(governed.stats.cuts),
+           static_cast<unsigned long long>(governed.stats.budgetMisses));
+
+    return stepsOk ? 0 : 2;
+}
+
+//------------------------------------------------------------------
+// Recording
+//  Event times are made the way InputTimestamp makes them, whole
+//  nanoseconds of the steady clock, as a real input thread's would be.
+//------------------------------------------------------------------
+#define RECORD_FPS 50.f // Against the 60 Hz step, so alphas vary
+
+static int RunRecording(const char* path, int effect, int frames)
+{
+    std::vector<uint32_t> pixels(static_cast<size_t>(s_width) * s_height, 0);
+    FrameTarget target = {};
+    target.fb.pixels = pixels.data();
+    target.fb.width  = s_width;
+    target.fb.height = s_height;
+    ClearDirtyRegion(target.drawn);
+
+    s_inputQueue.Clear();
+    SetCursorEventQueue(&s_inputQueue);
+    SetActiveParticleSystem(effect);
+    const int64_t startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    const double start = startNs / 1e9;
+    if (!StartSessionRecording(path, Rect{ 0, 0, s_width, s_height }, 1)) {
+        fprintf(stderr, "cannot write %s\n", path);
+        SetCursorEventQueue(nullptr);
+        return 1;
+    }
+
+    FixedTimestep timestep;
+    int nextEvent = 0;
+    uint64_t checksum = 0;
+    uint64_t runHash = 0xCBF29CE484222325ull;
+    for (int frame = 1; frame <= frames; frame++) {
+        const double now = frame / static_cast<double>(RECORD_FPS);
+        for (; nextEvent <= now * INPUT_EVENT_HZ; nextEvent++) {
+            CursorEvent e = GestureAt(nextEvent / static_cast<double>(INPUT_EVENT_HZ));
+            e.time = (startNs + nextEvent * (1000000000LL / INPUT_EVENT_HZ)) / 1e9;
+            s_inputQueue.Push(e);
+        }
+        if (frame == frames / 4) SetDetailLevel(0.5f);
+        if (frame == frames * 3 / 8) SetDetailLevel(1.0f);
+        if (frame == frames / 2) SetActiveParticleSystem(effect % PARTICLE_TYPE_COUNT + 1);
+
+        const int steps = timestep.Advance(1.0f / RECORD_FPS);
+        const double simTime = start + now - timestep.accumulator;
+        for (int i = steps; i > 0; i--) {
+            SpawnParticlesUntil(simTime - (i - 1) * static_cast<double>(timestep.step));
+            UpdateParticles(timestep.step);
+        }
+        DrawParticlesToTarget(target, timestep.Alpha());
+        checksum = FrameChecksum(target);
+        runHash = (runHash ^ checksum) * 0x100000001B3ull;
+    }
+    const bool written = StopSessionRecording();
+    SetCursorEventQueue(nullptr);
+
+    SessionReader reader;
+    if (!written || !reader.Open(path)) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return 1;
+    }
+    printf("session=%s bytes=%zu frames=%d cursor_events=%d bytes_per_event=%.2f\n",
+           path, reader.Size(), frames, nextEvent, reader.Size() / static_cast<double>(std::max(nextEvent, 1)));
+    printf("checksum=%016" PRIx64 " run_hash=%016" PRIx64 "\n", checksum, runHash);
+    return 0;
+}
+
+//------------------------------------------------------------------
+// Emitter check
+//  Emitter k circles the middle of cell k of a grid over the surface,
+//  reported at 1 kHz, and trails two effects; a third of the emitters
+//  are replaced halfway through. Pools are sized so nothing is evicted
+//  and every new particle can be traced back to its circle.
+//------------------------------------------------------------------
+#define EMITTER_REVOLUTION_SECONDS 0.5
+
+struct EmitterRun {
+    uint64_t spawned;
+    double spawnSeconds;
+    float maxDeviation;
+    bool staleIdRejected;
+    uint32_t checksum;
+};
+
+static EmitterRun RunEmitters(int count, int frames, int threads)
+{
+    std::vector<uint32_t> pixels(static_cast<size_t>(s_width) * s_height, 0);
+    Framebuffer fb = {};
+    fb.pixels = pixels.data();
+    fb.width  = s_width;
+    fb.height = s_height;
+    SeedParticleRng(1);
+    SetDrawThreadCount(threads);
+    for (int t = 1; t <= PARTICLE_TYPE_COUNT; t++) {
+        SetParticleBudget(static_cast<ParticleType>(t), static_cast<size_t>(count) * 64);
+    }
+    ClearParticles();
+    SetFramebuffer(fb);
+
+    const int cols = std::max(1, static_cast<int>(std::ceil(std::sqrt(count * s_width / static_cast<double>(s_height)))));
+    const int rows = (count + cols - 1) / cols;
+    const float cellW = s_width / static_cast<float>(cols);
+    const float cellH = s_height / static_cast<float>(rows);
+    const float radius = std::min(cellW, cellH) * 0.3f;
+
+    std::vector<EmitterId> ids(count);
+    for (int k = 0; k < count; k++) {
+        const uint32_t effects = EffectBit(static_cast<ParticleType>(k % PARTICLE_TYPE_COUNT + 1)) |
+                                 EffectBit(static_cast<ParticleType>((k + 2) % PARTICLE_TYPE_COUNT + 1));
+        ids[k] = CreateEmitter(effects, k);
+    }
+
+    EmitterRun run = {};
+    run.staleIdRejected = true;
+    ResetPoolStats();
+    int nextEvent = 0;
+    for (int frame = 1; frame <= frames; frame++) {
+        const double now = frame / 60.0;
+        if (frame == frames / 2) {
+            for (int k = 0; k < count; k += 3) {
+                const EmitterId stale = ids[k];
+                DestroyEmitter(stale);
+                ids[k] = CreateEmitter(ALL_EFFECT_BITS & ~EffectBit(ParticleType::HEARTS), count + k);
+                run.staleIdRejected = run.staleIdRejected && !MoveEmitter(stale, 0.f, 0.f, now);
+            }
+        }
+        for (; nextEvent <= now * INPUT_EVENT_HZ; nextEvent++) {
+            const double time = nextEvent / static_cast<double>(INPUT_EVENT_HZ);
+            for (int k = 0; k < count; k++) {
+                const double turn = 2.0 * 3.14159265358979 * (time / EMITTER_REVOLUTION_SECONDS + k / 7.0);
+                MoveEmitter(ids[k], cellW * (k % cols + 0.5f) + radius * static_cast<float>(cos(turn)),
+                            cellH * (k / cols + 0.5f) + radius * static_cast<float>(sin(turn)), time);
+            }
+        }
+
+        size_t before[PARTICLE_TYPE_COUNT];
+        for (int k = 0; k < PARTICLE_TYPE_COUNT; k++) before[k] = g_pools[k].Size();
+        auto start = std::chrono::steady_clock::now();
+        SpawnEmitters(now);
+        run.spawnSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Back to where each new trail particle was emitted (hearts are
+        // jittered on purpose)
+        for (const ParticlePool& pool : g_pools) {
+            if (pool.type == ParticleType::HEARTS) continue;
+            for (size_t i = before[PoolIndex(pool.type)]; i < pool.Size(); i++) {
+                const float age = pool.MaxLife(i) - pool.Life(i);
+                const float x = pool.x[i] - pool.vx[i] * age;
+                const float y = pool.y[i] - pool.vy[i] * age;
+                const int col = std::min(cols - 1, static_cast<int>(x / cellW));
+                const int row = std::min(rows - 1, static_cast<int>(y / cellH));
+                const float dx = x - cellW * (col + 0.5f);
+                const float dy = y - cellH * (row + 0.5f);
+                run.maxDeviation = std::max(run.maxDeviation, fabsf(std::sqrt(dx * dx + dy * dy) - radius));
+            }
+        }
+        UpdateParticles(1.0f / 60.0f);
+        DrawParticlesToDIB();
+    }
+
+    for (const ParticlePool& pool : g_pools) run.spawned += pool.stats.spawned;
+    run.checksum = Checksum(pixels);
+    DestroyAllEmitters();
+    for (int t = 1; t <= PARTICLE_TYPE_COUNT; t++) {
+        SetParticleBudget(static_cast<ParticleType>(t), MAX_PARTICLES);
+    }
+    return run;
+}
+
+static int RunEmitterCheck(int count, int frames)
+{
+    EmitterRun run = RunEmitters(count, frames, 1);
+    EmitterRun again = RunEmitters(count, frames, 0);
+    printf("spawned=%llu spawn_us_per_frame=%.1f spawn_ns_per_particle=%.1f max_deviation=%.2f\n",
+           static_cast<unsigned long long>(run.spawned), run.spawnSeconds * 1e6 / frames,
+           run.spawned ? run.spawnSeconds * 1e9 / run.spawned : 0.0, run.maxDeviation);
+    printf("checksum=%08x repeat=%08x stale_id_rejected=%d\n", run.checksum, again.checksum, run.staleIdRejected ? 1 : 0);
+
+    const bool ok = run.spawned > 0 && run.maxDeviation <= INPUT_MAX_DEVIATION &&
+                    run.staleIdRejected && again.checksum == run.checksum;
+    return ok ? 0 : 2;
+}
+
+//------------------------------------------------------------------
+// Dirty-region check
+//  The trail does not depend on the canvas: a circle of DIRTY_RADIUS
+//  around a fixed point, inside the smaller canvas.
+//------------------------------------------------------------------
+#define DIRTY_MOVE_FRAMES  240
+#define DIRTY_MAX_FRAMES   (DIRTY_MOVE_FRAMES + 600) // Lives are at most 2 s
+#define DIRTY_RADIUS       150
+#define DIRTY_MAX_GROWTH   1.01 // Large canvas over small, bytes per frame
+
+static bool FixedCircleCursor(Point* pt)
+{
+    float t = std::min(s_time, s_stopAt);
+    pt->x = 600 + static_cast<int>(DIRTY_RADIUS * cosf(t * 3.14159f));
+    pt->y = 400 + static_cast<int>(DIRTY_RADIUS * sinf(t * 3.14159f));
+    return true;
+}
+
+struct DirtyRun {
+    double clearedPerFrame;   // Bytes, averaged over every frame drawn
+    double presentedPerFrame;
+    size_t stalePixels;       // Nonzero once every particle has expired
+    int frames;
+};
+
+static DirtyRun RunDirtyTrail(int effect, int width, int height)
+{
+    std::vector<uint32_t> pixels(static_cast<size_t>(width) * height, 0);
+    Framebuffer fb = {};
+    fb.pixels = pixels.data();
+    fb.width  = width;
+    fb.height = height;
+    SeedParticleRng(1);
+    ClearParticles();
+    SetFramebuffer(fb);
+    SetCursorSource(FixedCircleCursor);
+    SetActiveParticleSystem(effect);
+    s_stopAt = (DIRTY_MOVE_FRAMES - 1) / 60.0f;
+
+    DirtyRun run = {};
+    double cleared = 0.0, presented = 0.0;
+    int idleFrames = 0;
+    for (int frame = 0; frame < DIRTY_MAX_FRAMES && idleFrames < 2; frame++) {
+        s_time = frame / 60.0f;
+        SpawnParticlesOnMouseMove();
+        UpdateParticles(1.0f / 60.0f);
+        DrawParticlesToDIB();
+
+        const Rect bounds = GetDirtyBounds(g_dirtyRegion);
+        cleared += static_cast<double>(g_frameStats.bytesCleared);
+        if (!IsEmptyRect(bounds)) {
+            presented += static_cast<double>(bounds.right - bounds.left) * (bounds.bottom - bounds.top) * sizeof(uint32_t);
+        }
+        run.frames++;
+        // Two frames past the last particle: the first clears its pixels
+        if (frame >= DIRTY_MOVE_FRAMES && GetLiveParticleCount() == 0) idleFrames++;
+    }
+    s_stopAt = 1e30f;
+    run.clearedPerFrame = cleared / run.frames;
+    run.presentedPerFrame = presented / run.frames;
+    for (uint32_t px : pixels) run.stalePixels += (px != 0) ? 1 : 0;
+    return run;
+}
+
+static int RunDirtyCheck(int effect)
+{
+    int failures = 0;
+    for (int e = (effect ? effect : 1); e <= (effect ? effect : 6); e++) {
+        const DirtyRun small = RunDirtyTrail(e, 1920, 1080);
+        const DirtyRun large = RunDirtyTrail(e, 7680, 2160);
+        const double clearedGrowth = large.clearedPerFrame / std::max(small.clearedPerFrame, 1.0);
+        const double presentedGrowth = large.presentedPerFrame / std::max(small.presentedPerFrame, 1.0);
+        const bool ok = small.clearedPerFrame > 0.0 && clearedGrowth <= DIRTY_MAX_GROWTH &&
+                        presentedGrowth <= DIRTY_MAX_GROWTH && small.stalePixels == 0 && large.stalePixels == 0;
+        printf("effect=%d frames=%d cleared_per_frame=%.0f/%.0f presented_per_frame=%.0f/%.0f stale_pixels=%zu/%zu%s\n",
+               e, small.frames, small.clearedPerFrame, large.clearedPerFrame, small.presentedPerFrame,
+               large.presentedPerFrame, small.stalePixels, large.stalePixels, ok ? "" : " FAIL");
+        if (!ok) failures++;
+    }
+    return failures == 0 ? 0 : 2;
+}
+
+//------------------------------------------------------------------
+// Profiler check
+//  Producer t records spans of stage SPAWN + t lasting t * 1000 + (i %
+//  1000) ns and counter t with value t * 1000 + (i % 1000), so an event
+//  torn between two producers lands outside its histogram's range.
+//------------------------------------------------------------------
+#define PROFILER_THREADS 4
+#define PROFILER_FILE_CSV   "mousetrail_profile_check.csv"
+#define PROFILER_FILE_TRACE "mousetrail_profile_check.json"
+
+// Percentile() over random samples: never above the exact percentile
+// and less than a bucket (1/16) below it. *worst is the largest error
+// relative to the exact value.
+static bool CheckHistogramPercentiles(Rng& rng, double* worst)
+{
+    ProfileHistogram h;
+    h.Reset();
+    std::vector<uint64_t> samples(100000);
+    for (uint64_t& v : samples) {
+        // Log-uniform over 1 ns .. ~17 s
+        v = static_cast<uint64_t>(std::exp(rng.Range(0.f, 24.f)));
+        h.Record(v);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    bool ok = h.min == samples.front() && h.max == samples.back();
+    *worst = 0.0;
+    for (double pct : { 1.0, 25.0, 50.0, 90.0, 99.0, 99.9, 100.0 }) {
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(pct / 100.0 * samples.size() + 0.5));
+        const uint64_t exact = samples[rank - 1];
+        const uint64_t reported = h.Percentile(pct);
+        ok = ok && reported <= exact;
+        *worst = std::max(*worst, (static_cast<double>(exact) - static_cast<double>(reported)) / exact);
+    }
+    return ok && *worst < 1.0 / (1 << PROFILE_HISTOGRAM_SUB_BITS);
+}
+
+static void ProduceProfileEvents(int t, int events)
+{
+    const ProfileStage stage = static_cast<ProfileStage>(static_cast<int>(ProfileStage::SPAWN) + t);
+    const ProfileCounter counter = static_cast<ProfileCounter>(t);
+    for (int i = 0; i < events; i++) {
+        const uint64_t value = static_cast<uint64_t>(t) * 1000 + i % 1000;
+        RecordProfileSpan(stage, 1000000, 1000000 + value);
+        RecordProfileCounter(counter, value);
+    }
+}
+
+static size_t CountLines(const char* path, const char* containing)
+{
+    FILE* in = fopen(path, "r");
+    if (!in) return 0;
+    size_t lines = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), in)) lines += strstr(line, containing) ? 1 : 0;
+    fclose(in);
+    return lines;
+}
+
+static int RunProfilerCheck(int events)
+{
+    Rng rng(17);
+    double percentileError = 0.0;
+    const bool histogramOk = CheckHistogramPercentiles(rng, &percentileError);
+
+    // Producers against a collecting consumer
+    ResetProfile();
+    SetProfileTraceCapture(false);
+    std::atomic<int> running(PROFILER_THREADS);
+    std::vector<std::thread> producers;
+    for (int t = 0; t < PROFILER_THREADS; t++) {
+        producers.emplace_back([t, events, &running]() {
+            ProduceProfileEvents(t, events);
+            running.fetch_sub(1);
+        });
+    }
+    while (running.load() > 0) CollectProfile();
+    for (std::thread& p : producers) p.join();
+    CollectProfile();
+
+    uint64_t collected = 0;
+    bool inRange = true;
+    for (int t = 0; t < PROFILER_THREADS; t++) {
+        const ProfileHistogram& spans = GetStageHistogram(static_cast<ProfileStage>(static_cast<int>(ProfileStage::SPAWN) + t));
+        const ProfileHistogram& values = GetCounterHistogram(static_cast<ProfileCounter>(t));
+        for (const ProfileHistogram* h : { &spans, &values }) {
+            collected += h->total;
+            if (h->total && (h->min < static_cast<uint64_t>(t) * 1000 || h->max >= static_cast<uint64_t>(t + 1) * 1000)) {
+                inRange = false;
+            }
+        }
+    }
+    const uint64_t produced = static_cast<uint64_t>(PROFILER_THREADS) * events * 2;
+    const uint64_t lost = GetProfileEventsLost();
+    const bool ringOk = inRange && collected + lost == produced && collected > 0;
+
+    // Exports: a few frames' worth of captured spans
+    ResetProfile();
+    SetProfileTraceCapture(true);
+    for (int i = 0; i < 100; i++) RecordProfileSpan(ProfileStage::DRAW, 0, 1000 + i);
+    RecordProfileCounter(ProfileCounter::LIVE_PARTICLES, 42);
+    CollectProfile();
+    SetProfileTraceCapture(false);
+    const bool written = WriteProfileCsv(PROFILER_FILE_CSV) && WriteChromeTrace(PROFILER_FILE_TRACE);
+    const size_t csvRows = CountLines(PROFILER_FILE_CSV, ",");
+    const size_t traceSpans = CountLines(PROFILER_FILE_TRACE, "\"ph\": \"X\"");
+    const size_t traceCounters = CountLines(PROFILER_FILE_TRACE, "\"ph\": \"C\"");
+    remove(PROFILER_FILE_CSV);
+    remove(PROFILER_FILE_TRACE);
+    ResetProfile();
+    const size_t expectedRows = 1 + static_cast<size_t>(ProfileStage::COUNT) + static_cast<size_t>(ProfileCounter::COUNT);
+    const bool exportOk = written && csvRows == expectedRows && traceSpans == 100 && traceCounters == 1;
+
+    printf("percentile_error=%.4f produced=%llu collected=%llu lost=%llu in_range=%d\n", percentileError,
+           static_cast<unsigned long long>(produced), static_cast<unsigned long long>(collected),
+           static_cast<unsigned long long>(lost), inRange ? 1 : 0);
+    printf("csv_rows=%zu trace_spans=%zu trace_counters=%zu\n", csvRows, traceSpans, traceCounters);
+    return (histogramOk && ringOk && exportOk) ? 0 : 2;
+}
+
+//------------------------------------------------------------------
+// Update kernel check
+//------------------------------------------------------------------
+struct KernelStreams {
+    std::vector<float> x, y, vx, vy, driftX;
+    std::vector<uint16_t> life, scale;
+    std::vector<uint8_t> lifeSpan;
+
+    UpdateStreams View(bool drift)
+    {
+        UpdateStreams s;
+        s.x = x.data();
+        s.y = y.data();
+        s.vx = vx.data();
+        s.vy = vy.data();
+        s.life = life.data();
+        s.scale = scale.data();
+        s.lifeSpan = lifeSpan.data();
+        s.driftX = drift ? driftX.data() : nullptr;
+        s.count = x.size();
+        return s;
+    }
+};
+
+static void RandomKernelStreams(KernelStreams& k, size_t count, Rng& rng)
+{
+    k.x.resize(count);
+    k.y.resize(count);
+    k.vx.resize(count);
+    k.vy.resize(count);
+    k.driftX.resize(count);
+    k.life.resize(count);
+    k.scale.resize(count);
+    k.lifeSpan.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        k.x[i] = rng.Range(-2000.f, 4000.f);
+        k.y[i] = rng.Range(-2000.f, 4000.f);
+        k.vx[i] = rng.Range(-500.f, 500.f);
+        k.vy[i] = rng.Range(-500.f, 500.f);
+        k.driftX[i] = rng.Range(-0.1f, 0.1f);
+        // A quarter about to run out, so the subtraction saturates
+        k.life[i] = static_cast<uint16_t>((i & 3) == 0 ? rng.NextInt(600) : rng.NextInt(65536));
+        k.scale[i] = static_cast<uint16_t>(rng.NextInt(65536));
+        k.lifeSpan[i] = static_cast<uint8_t>(rng.NextInt(256));
+    }
+}
+
+static UpdateParams RandomKernelParams(int c, Rng& rng)
+{
+    UpdateParams p;
+    p.dt       = rng.Range(0.001f, 0.05f);
+    p.vxScale  = rng.Range(0.9f, 1.1f);
+    p.vyScale  = rng.Range(0.9f, 1.1f);
+    p.preAccel = rng.Range(-10.f, 10.f);
+    p.gravity  = rng.Range(-50.f, 50.f);
+    p.lifeMin  = rng.Range(0.05f, 1.f);
+    p.lifeStep = rng.Range(0.f, 0.005f);
+    switch (c % 8) {
+    case 5: p.dt = rng.Range(1.f, 3.f); break;                  // Every life runs out
+    case 6: p.lifeMin = 1e-4f; p.lifeStep = 1e-6f; break;      // Lives past maxLife: fades far above 1
+    case 7: p.lifeMin = 0.f; p.lifeStep = 0.f; break;          // 0 / 0 fades
+    default: break;
+    }
+    return p;
+}
+
+// Largest difference of two fixed-point streams, in units
+static int MaxUnitDifference(const std::vector<uint16_t>& a, const std::vector<uint16_t>& b)
+{
+    int worst = 0;
+    for (size_t i = 0; i < a.size(); i++) worst = std::max(worst, abs(a[i] - b[i]));
+    return worst;
+}
+
+static bool SameFloats(const std::vector<float>& a, const std::vector<float>& b)
+{
+    return a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+static int RunKernelCheck(int cases)
+{
+    Rng rng(5);
+    KernelStreams input, expected, actual;
+    const SimdLevel defaultLevel = GetUpdateKernelLevel();
+    const SimdLevel levels[] = { SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON };
+    int checked[4] = {}, mismatches[4] = {}, worstLife[4] = {}, worstScale[4] = {};
+
+    for (int c = 0; c < cases; c++) {
+        // Mostly short, odd lengths (0 included) for the tails; some long
+        const size_t count = (c % 10 == 9) ? 1000 + rng.NextInt(100) : rng.NextInt(67);
+        RandomKernelStreams(input, count, rng);
+        const UpdateParams params = RandomKernelParams(c, rng);
+        const bool drift = (c & 1) != 0;
+
+        expected = input;
+        UpdateKernelScalar(expected.View(drift), params);
+        for (SimdLevel level : levels) {
+            if (!SetUpdateKernelLevel(level)) continue;
+            const int l = static_cast<int>(level);
+            actual = input;
+            RunUpdateKernel(actual.View(drift), params);
+            const int lifeDiff = MaxUnitDifference(actual.life, expected.life);
+            const int scaleDiff = MaxUnitDifference(actual.scale, expected.scale);
+            worstLife[l] = std::max(worstLife[l], lifeDiff);
+            worstScale[l] = std::max(worstScale[l], scaleDiff);
+            checked[l]++;
+            if (!SameFloats(actual.x, expected.x) || !SameFloats(actual.y, expected.y) ||
+                !SameFloats(actual.vx, expected.vx) || !SameFloats(actual.vy, expected.vy) ||
+                lifeDiff > 1 || scaleDiff > 1) {
+                if (mismatches[l] == 0) {
+                    fprintf(stderr, "kernel %s differs from scalar in case %d (%zu particles)\n",
+                            SimdLevelName(level), c, count);
+                }
+                mismatches[l]++;
+            }
+        }
+    }
+    SetUpdateKernelLevel(defaultLevel);
+
+    int total = 0;
+    for (SimdLevel level : levels) {
+        const int l = static_cast<int>(level);
+        if (checked[l] == 0) continue;
+        printf("kernel=%s cases=%d mismatches=%d max_life_units=%d max_scale_units=%d\n",
+               SimdLevelName(level), checked[l], mismatches[l], worstLife[l], worstScale[l]);
+        total += mismatches[l];
+    }
+    return total == 0 ? 0 : 2;
+}
+
+//------------------------------------------------------------------
+// Blend kernel check
+//------------------------------------------------------------------
+#define BLEND_MAX_SPAN   37
+#define BLEND_TIME_SPANS 200000 // Per kernel and level
+
+// Spans of "length" at "offset" into each buffer, blended with the current
+// kernel; false if any pixel differs from the scalar kernel's
+static bool CheckBlendSpan(const std::vector<uint32_t>& dst, const std::vector<uint8_t>& coverage,
+                           int offset, int length, uint32_t src, bool solid,
+                           std::vector<uint32_t>& expected, std::vector<uint32_t>& actual)
+{
+    const SimdLevel level = GetBlendKernelLevel();
+    expected = dst;
+    actual = dst;
+    SetBlendKernelLevel(SimdLevel::SCALAR);
+    if (solid) BlendSpanSolid(expected.data() + offset, length, src);
+    else       BlendSpanCoverage(expected.data() + offset, coverage.data() + offset, length, src);
+    SetBlendKernelLevel(level);
+    if (solid) BlendSpanSolid(actual.data() + offset, length, src);
+    else       BlendSpanCoverage(actual.data() + offset, coverage.data() + offset, length, src);
+    return expected == actual;
+}
+
+// Nanoseconds per pixel over spans of every length 1-BLEND_MAX_SPAN
+static double TimeBlend(bool solid, std::vector<uint32_t>& dst, const std::vector<uint8_t>& coverage, uint32_t src)
+{
+    auto start = std::chrono::steady_clock::now();
+    uint64_t pixels = 0;
+    for (int n = 0; n < BLEND_TIME_SPANS; n++) {
+        const int length = n % BLEND_MAX_SPAN + 1;
+        const int offset = n & 7;
+        if (solid) BlendSpanSolid(dst.data() + offset, length, src);
+        else       BlendSpanCoverage(dst.data() + offset, coverage.data() + offset, length, src);
+        pixels += length;
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / pixels;
+}
+
+static int RunBlendCheck(int cases)
+{
+    Rng rng(13);
+    const size_t size = BLEND_MAX_SPAN + 8;
+    std::vector<uint32_t> dst(size), expected, actual;
+    std::vector<uint8_t> coverage(size);
+    const SimdLevel defaultLevel = GetBlendKernelLevel();
+    const SimdLevel levels[] = { SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON };
+    int mismatches[4] = {};
+    double solidNs[4] = {}, coverageNs[4] = {};
+    bool ran[4] = {};
+
+    for (SimdLevel level : levels) {
+        // Levels without a blend kernel fall back to scalar: nothing to compare
+        if (!SetBlendKernelLevel(level)) continue;
+        const int l = static_cast<int>(level);
+        ran[l] = true;
+        Rng caseRng(13);
+        for (int c = 0; c < cases && level != SimdLevel::SCALAR; c++) {
+            for (size_t i = 0; i < size; i++) {
+                dst[i] = caseRng.NextU32();
+                // Runs of empty coverage, which the kernels skip
+                coverage[i] = ((i / 8 + c) % 3 == 0) ? 0 : static_cast<uint8_t>(caseRng.NextInt(256));
+            }
+            const uint32_t src = PremultiplyARGB(caseRng.NextU32());
+            const int length = c % (BLEND_MAX_SPAN + 1);
+            const int offset = (c / (BLEND_MAX_SPAN + 1)) % 8;
+            for (int solid = 0; solid < 2; solid++) {
+                if (!CheckBlendSpan(dst, coverage, offset, length, src, solid != 0, expected, actual)) {
+                    if (mismatches[l] == 0) {
+                        fprintf(stderr, "kernel %s %s differs from scalar in case %d (%d px)\n",
+                                SimdLevelName(level), solid ? "solid" : "coverage", c, length);
+                    }
+                    mismatches[l]++;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < size; i++) {
+            dst[i] = rng.NextU32();
+            coverage[i] = static_cast<uint8_t>(rng.NextInt(256));
+        }
+        const uint32_t src = PremultiplyARGB(0x80FF8040u);
+        solidNs[l] = TimeBlend(true, dst, coverage, src);
+        coverageNs[l] = TimeBlend(false, dst, coverage, src);
+    }
+    SetBlendKernelLevel(defaultLevel);
+
+    int total = 0;
+    for (SimdLevel level : levels) {
+        const int l = static_cast<int>(level);
+        if (!ran[l]) continue;
+        printf("kernel=%s mismatches=%d solid_ns_per_pixel=%.3f coverage_ns_per_pixel=%.3f%s\n",
+               SimdLevelName(level), mismatches[l], solidNs[l], coverageNs[l],
+               level == defaultLevel ? " (default)" : "");
+        total += mismatches[l];
+    }
+    return total == 0 ? 0 : 2;
+}
+
+//------------------------------------------------------------------
+// Force field check
+//------------------------------------------------------------------
+#define FORCE_CHECK_SAMPLES 65536
+#define FORCE_MAX_DIVERGENCE 1e-4f // Relative to the mean acceleration
+
+// Wind, turbulence and "points" random attractors/repulsors over the surface
+static void SetForceSources(int points, Rng& rng)
+{
+    const Rect area = { 0, 0, s_width, s_height };
+    SetForceFieldBounds(area);
+    SetWind(30.f, -10.f);
+    SetTurbulence(200.f, 150.f, 0.5f);
+    ClearForcePoints();
+    for (int k = 0; k < points; k++) {
+        ForcePoint p;
+        p.x = rng.Range(0.f, static_cast<float>(s_width));
+        p.y = rng.Range(0.f, static_cast<float>(s_height));
+        p.strength = rng.Range(-400.f, 400.f);
+        p.radius = rng.Range(50.f, 300.f);
+        AddForcePoint(p);
+    }
+}
+
+// Mean x of the live smoke after a circling trail, with or without wind
+static float SmokeDrift(bool wind)
+{
+    ClearForceField();
+    if (wind) {
+        const Rect area = { 0, 0, s_width, s_height };
+        SetForceFieldBounds(area);
+        SetWind(1000.f, 0.f); // About 30 px over a smoke puff's life
+    }
+    BuildForceField(0.0);
+    SeedParticleRng(1);
+    ClearParticles();
+    SetCursorSource(SyntheticCursor);
+    SetActiveParticleSystem(1); // Smoke
+    for (int frame = 0; frame < 120; frame++) {
+        s_time = frame / 60.0f;
+        SpawnParticlesOnMouseMove();
+        UpdateParticles(1.0f / 60.0f);
+    }
+    const ParticlePool& pool = GetPool(ParticleType::SMOKE);
+    double sum = 0.0;
+    for (size_t i = 0; i < pool.Size(); i++) sum += pool.x[i];
+    const float mean = pool.Size() ? static_cast<float>(sum / pool.Size()) : 0.f;
+    ClearParticles();
+    ClearForceField();
+    return mean;
+}
+
+// Largest divergence of the turbulence between interior nodes, over its
+// mean acceleration
+static float TurbulenceDivergence()
+{
+    ClearForceField();
+    const Rect area = { 0, 0, s_width, s_height };
+    SetForceFieldBounds(area);
+    SetTurbulence(200.f, 150.f, 0.5f);
+    BuildForceField(1.0);
+
+    const int cols = s_width / FORCE_CELL_PX, rows = s_height / FORCE_CELL_PX;
+    std::vector<float> ax(static_cast<size_t>(cols) * rows), ay(ax.size());
+    double magnitude = 0.0;
+    for (int j = 0; j < rows; j++) {
+        for (int i = 0; i < cols; i++) {
+            const size_t k = static_cast<size_t>(j) * cols + i;
+            SampleForceField(static_cast<float>(i * FORCE_CELL_PX), static_cast<float>(j * FORCE_CELL_PX), &ax[k], &ay[k]);
+            magnitude += std::sqrt(ax[k] * ax[k] + ay[k] * ay[k]);
+        }
+    }
+    magnitude /= ax.size();
+
+    float worst = 0.f;
+    for (int j = 2; j < rows - 2; j++) {
+        for (int i = 2; i < cols - 2; i++) {
+            const size_t k = static_cast<size_t>(j) * cols + i;
+            const float div = (ax[k + 1] - ax[k - 1]) + (ay[k + cols] - ay[k - cols]);
+            worst = std::max(worst, fabsf(div));
+        }
+    }
+    ClearForceField();
+    return magnitude > 0.0 ? static_cast<float>(worst / magnitude) : 1.f;
+}
+
+static int RunForceCheck(int points, int frames)
+{
+    Rng rng(11);
+    std::vector<float> x(FORCE_CHECK_SAMPLES), y(FORCE_CHECK_SAMPLES);
+    for (size_t i = 0; i < x.size(); i++) {
+        // A tenth of the surface beyond every edge
+        x[i] = rng.Range(-0.1f * s_width, 1.1f * s_width);
+        y[i] = rng.Range(-0.1f * s_height, 1.1f * s_height);
+    }
+    std::vector<float> vxRef(x.size()), vyRef(x.size()), vx(x.size()), vy(x.size());
+
+    const SimdLevel defaultLevel = GetForceKernelLevel();
+    int mismatches = 0;
+    double buildSeconds = 0.0;
+    double sampleSeconds[4] = {}; // Per SimdLevel
+    SetForceSources(points, rng);
+    for (int frame = 0; frame < frames; frame++) {
+        auto start = std::chrono::steady_clock::now();
+        BuildForceField(frame / 60.0);
+        buildSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::fill(vxRef.begin(), vxRef.end(), 1.f);
+        std::fill(vyRef.begin(), vyRef.end(), -1.f);
+        ApplyForceFieldScalar(x.data(), y.data(), vxRef.data(), vyRef.data(), x.size(), 1.0f / 60.0f);
+        for (SimdLevel level : { SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON }) {
+            if (!SetForceKernelLevel(level)) continue;
+            std::fill(vx.begin(), vx.end(), 1.f);
+            std::fill(vy.begin(), vy.end(), -1.f);
+            start = std::chrono::steady_clock::now();
+            ApplyForceField(x.data(), y.data(), vx.data(), vy.data(), x.size(), 1.0f / 60.0f);
+            sampleSeconds[static_cast<int>(level)] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (memcmp(vx.data(), vxRef.data(), vx.size() * sizeof(float)) != 0 ||
+                memcmp(vy.data(), vyRef.data(), vy.size() * sizeof(float)) != 0) {
+                fprintf(stderr, "kernel %s differs from scalar at frame %d\n", SimdLevelName(level), frame);
+                mismatches++;
+            }
+        }
+        SetForceKernelLevel(defaultLevel);
+    }
+    ClearForceField();
+
+    const float divergence = TurbulenceDivergence();
+    const float still = SmokeDrift(false);
+    const float blown = SmokeDrift(true);
+    printf("build_us_per_frame=%.1f mismatches=%d\n", buildSeconds * 1e6 / frames, mismatches);
+    for (SimdLevel level : { SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON }) {
+        if (sampleSeconds[static_cast<int>(level)] == 0.0) continue;
+        printf("kernel=%s sample_ns_per_particle=%.2f%s\n", SimdLevelName(level),
+               sampleSeconds[static_cast<int>(level)] * 1e9 / (static_cast<double>(frames) * x.size()),
+               level == defaultLevel ? " (default)" : "");
+    }
+    printf("turbulence_divergence=%.2e smoke_mean_x=%.1f with_wind=%.1f\n", divergence, still, blown);
+
+    const bool ok = mismatches == 0 && divergence <= FORCE_MAX_DIVERGENCE && blown > still + 10.f;
+    return ok ? 0 : 2;
+}
+
+//------------------------------------------------------------------
+// Raster check
+//------------------------------------------------------------------
+#define RASTER_CHECK_SIZE 64 // Pixels per side of the test area
+
+struct RasterCoverage {
+    std::vector<int> hits; // Per pixel of the test area
+    int badSpans;          // Empty, out of order or outside the clip
+    int lastRow;
+    Rect clip;
+};
+
+static void CountSpan(int y, int x0, int x1, void* context)
+{
+    RasterCoverage& coverage = *static_cast<RasterCoverage*>(context);
+    if (x0 >= x1 || y < coverage.lastRow || y < coverage.clip.top || y >= coverage.clip.bottom ||
+        x0 < coverage.clip.left || x1 > coverage.clip.right) {
+        coverage.badSpans++;
+        return;
+    }
+    coverage.lastRow = y;
+    for (int x = x0; x < x1; x++) coverage.hits[static_cast<size_t>(y) * RASTER_CHECK_SIZE + x]++;
+}
+
+// Twice the signed area of (a, b, p)
+static int64_t EdgeValue(RasterVertex a, RasterVertex b, int64_t px, int64_t py)
+{
+    return (static_cast<int64_t>(b.x) - a.x) * (py - a.y) - (static_cast<int64_t>(b.y) - a.y) * (px - a.x);
+}
+
+// Pixel center on the edge: inside if nudging it right (or, on a
+// horizontal edge, down) moves it inside, which is the top-left rule
+static bool EdgeCovers(RasterVertex a, RasterVertex b, int64_t px, int64_t py)
+{
+    const int64_t e = EdgeValue(a, b, px, py);
+    if (e != 0) return e > 0;
+    return b.y < a.y || (b.y == a.y && b.x > a.x);
+}
+
+// Brute force: every pixel center of the clip against the three edges
+static bool ReferenceCovers(RasterVertex a, RasterVertex b, RasterVertex c, int x, int y)
+{
+    const int64_t area = EdgeValue(a, b, c.x, c.y);
+    if (area == 0) return false;
+    if (area < 0) std::swap(b, c);
+    const int64_t px = static_cast<int64_t>(x) * RASTER_ONE;
+    const int64_t py = static_cast<int64_t>(y) * RASTER_ONE;
+    return EdgeCovers(a, b, px, py) && EdgeCovers(b, c, px, py) && EdgeCovers(c, a, px, py);
+}
+
+// Vertex anywhere in and a little around the test area, in 1/16 pixel
+static RasterVertex RandomVertex(Rng& rng, bool snapToPixel)
+{
+    const int span = (RASTER_CHECK_SIZE + 16) * RASTER_ONE;
+    RasterVertex v;
+    v.x = static_cast<int32_t>(rng.NextInt(span)) - 8 * RASTER_ONE;
+    v.y = static_cast<int32_t>(rng.NextInt(span)) - 8 * RASTER_ONE;
+    if (snapToPixel) {
+        v.x &= ~(RASTER_ONE - 1);
+        v.y &= ~(RASTER_ONE - 1);
+    }
+    return v;
+}
+
+// Rasterizes the triangles into one coverage count and compares it
+// against the reference; returns the number of wrong pixels
+static int CheckTriangles(const RasterVertex* v, int triangles, const Rect& clip, RasterCoverage& coverage)
+{
+    std::fill(coverage.hits.begin(), coverage.hits.end(), 0);
+    coverage.clip = clip;
+    for (int t = 0; t < triangles; t++) {
+        coverage.lastRow = clip.top;
+        RasterizeTriangle(v[t * 3], v[t * 3 + 1], v[t * 3 + 2], clip, CountSpan, &coverage);
+    }
+
+    int wrong = 0;
+    for (int y = 0; y < RASTER_CHECK_SIZE; y++) {
+        for (int x = 0; x < RASTER_CHECK_SIZE; x++) {
+            int expected = 0;
+            const bool inClip = x >= clip.left && x < clip.right && y >= clip.top && y < clip.bottom;
+            for (int t = 0; t < triangles && inClip; t++) {
+                if (ReferenceCovers(v[t * 3], v[t * 3 + 1], v[t * 3 + 2], x, y)) expected++;
+            }
+            if (coverage.hits[static_cast<size_t>(y) * RASTER_CHECK_SIZE + x] != expected) wrong++;
+        }
+    }
+    return wrong;
+}
+
+// Brute force for lines: along the major axis, the pixel nearest to the
+// exact line, halfway cases toward the end with the larger major
+// coordinate
+static bool ReferenceLineCovers(int x0, int y0, int x1, int y1, int x, int y)
+{
+    const bool xMajor = abs(x1 - x0) >= abs(y1 - y0);
+    int u0 = xMajor ? x0 : y0, v0 = xMajor ? y0 : x0;
+    int u1 = xMajor ? x1 : y1, v1 = xMajor ? y1 : x1;
+    if (u1 < u0) {
+        std::swap(u0, u1);
+        std::swap(v0, v1);
+    }
+    const int u = xMajor ? x : y, v = xMajor ? y : x;
+    if (u < u0 || u > u1) return false;
+    if (u0 == u1) return v == v0;
+
+    // Exact minor coordinate v0 + n / du; candidates either side of it
+    const int64_t du = u1 - u0, dv = v1 - v0;
+    const int64_t n = (u - u0) * dv;
+    const int64_t below = v0 + (n >= 0 ? n / du : -((-n + du - 1) / du));
+    const int64_t above = (n % du == 0) ? below : below + 1;
+    const int64_t distBelow = n - (below - v0) * du; // >= 0
+    const int64_t distAbove = (above - v0) * du - n; // >= 0
+    int64_t nearest = distBelow < distAbove ? below : above;
+    if (distBelow == distAbove) nearest = dv > 0 ? above : below;
+    return v == nearest;
+}
+
+#define RASTER_CHECK_MARGIN 8 // Untouchable pixels around the test area
+
+// Draws the segment both ways round into a test area with a margin;
+// returns the number of pixels that differ from the reference either way
+static int CheckLine(int x0, int y0, int x1, int y1, const Rect& clip)
+{
+    const int stride = RASTER_CHECK_SIZE + 2 * RASTER_CHECK_MARGIN;
+    std::vector<uint32_t> pixels(static_cast<size_t>(stride) * stride);
+    uint32_t* origin = pixels.data() + RASTER_CHECK_MARGIN * stride + RASTER_CHECK_MARGIN;
+    int wrong = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        std::fill(pixels.begin(), pixels.end(), 0u);
+        if (pass == 0) FillLine(origin, stride, x0, y0, x1, y1, clip, 1);
+        else           FillLine(origin, stride, x1, y1, x0, y0, clip, 1);
+
+        for (int y = -RASTER_CHECK_MARGIN; y < RASTER_CHECK_SIZE + RASTER_CHECK_MARGIN; y++) {
+            for (int x = -RASTER_CHECK_MARGIN; x < RASTER_CHECK_SIZE + RASTER_CHECK_MARGIN; x++) {
+                const bool inClip = x >= clip.left && x < clip.right && y >= clip.top && y < clip.bottom;
+                const uint32_t expected = (inClip && ReferenceLineCovers(x0, y0, x1, y1, x, y)) ? 1 : 0;
+                if (origin[y * stride + x] != expected) wrong++;
+            }
+        }
+    }
+    return wrong;
+}
+
+static int RunRasterCheck(int cases)
+{
+    Rng rng(7);
+    RasterCoverage coverage;
+    coverage.hits.assign(RASTER_CHECK_SIZE * RASTER_CHECK_SIZE, 0);
+    coverage.badSpans = 0;
+
+    const Rect full = { 0, 0, RASTER_CHECK_SIZE, RASTER_CHECK_SIZE };
+    int wrongSingle = 0, wrongShared = 0, degenerateDrawn = 0, wrongLines = 0;
+    for (int i = 0; i < cases; i++) {
+        // Random clip, sometimes the whole area
+        Rect clip = full;
+        if (i & 1) {
+            clip.left   = rng.NextInt(RASTER_CHECK_SIZE / 2);
+            clip.top    = rng.NextInt(RASTER_CHECK_SIZE / 2);
+            clip.right  = clip.left + 1 + rng.NextInt(RASTER_CHECK_SIZE - clip.left);
+            clip.bottom = clip.top + 1 + rng.NextInt(RASTER_CHECK_SIZE - clip.top);
+        }
+        const bool snap = (i % 3) == 0;
+
+        // One triangle against the reference
+        RasterVertex v[6];
+        for (int k = 0; k < 3; k++) v[k] = RandomVertex(rng, snap);
+        if (CheckTriangles(v, 1, clip, coverage) != 0) wrongSingle++;
+
+        // Two triangles sharing the edge v0-v2, one on each side: pixels
+        // along it must be drawn once, not twice or never
+        v[3] = v[0];
+        v[4] = RandomVertex(rng, snap);
+        v[5] = v[2];
+        if (EdgeValue(v[0], v[2], v[1].x, v[1].y) * EdgeValue(v[0], v[2], v[4].x, v[4].y) < 0 &&
+            CheckTriangles(v, 2, clip, coverage) != 0) {
+            wrongShared++;
+        }
+
+        // Zero area: collinear (including coincident) vertices
+        RasterVertex d[3];
+        d[0] = RandomVertex(rng, snap);
+        const int32_t stepX = static_cast<int32_t>(rng.NextInt(9)) - 4;
+        const int32_t stepY = static_cast<int32_t>(rng.NextInt(9)) - 4;
+        for (int k = 1; k < 3; k++) {
+            const int32_t n = static_cast<int32_t>(rng.NextInt(40)) - 20;
+            d[k].x = d[0].x + stepX * n * RASTER_ONE / 4;
+            d[k].y = d[0].y + stepY * n * RASTER_ONE / 4;
+        }
+        if (CheckTriangles(d, 1, full, coverage) != 0) degenerateDrawn++;
+
+        // A line segment, every fourth one reaching far outside
+        const int reach = (i % 4 == 3) ? 4000 : RASTER_CHECK_SIZE + 16;
+        const int lx0 = rng.NextInt(reach) - (reach - RASTER_CHECK_SIZE) / 2;
+        const int ly0 = rng.NextInt(reach) - (reach - RASTER_CHECK_SIZE) / 2;
+        const int lx1 = (i % 5 == 4) ? lx0 : rng.NextInt(reach) - (reach - RASTER_CHECK_SIZE) / 2;
+        const int ly1 = rng.NextInt(reach) - (reach - RASTER_CHECK_SIZE) / 2;
+        if (CheckLine(lx0, ly0, lx1, ly1, clip) != 0) wrongLines++;
+    }
+
+    printf("cases=%d wrong_single=%d wrong_shared=%d degenerate_drawn=%d wrong_lines=%d bad_spans=%d\n",
+           cases, wrongSingle, wrongShared, degenerateDrawn, wrongLines, coverage.badSpans);
+    return (wrongSingle | wrongShared | degenerateDrawn | wrongLines | coverage.badSpans) == 0 ? 0 : 2;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && strcmp(argv[1], "--record") == 0) {
+        int effect = 3, frames = 600;
+        bool parsed = argc >= 3 && argc <= 5;
+        if (argc > 3) parsed = ParseInt(argv[3], &effect) && parsed;
+        if (argc > 4) parsed = ParseInt(argv[4], &frames) && parsed;
+        if (!parsed || effect < 1 || effect > 6 || frames < 1) {
+            fprintf(stderr, "usage: %s --record <file> [effect 1-6] [frames]\n", argv[0]);
+            return 1;
+        }
+        return RunRecording(argv[2], effect, frames);
+    }
+    if (argc > 1 && strcmp(argv[1], "--emitters") == 0) {
+        int count = 200, frames = 300;
+        bool parsed = argc <= 4;
+        if (argc > 2) parsed = ParseInt(argv[2], &count) && parsed;
+        if (argc > 3) parsed = ParseInt(argv[3], &frames) && parsed;
+        if (!parsed || count < 1 || count > MAX_EMITTERS || frames < 2) {
+            fprintf(stderr, "usage: %s --emitters [count 1-%d] [frames]\n", argv[0], MAX_EMITTERS);
+            return 1;
+        }
+        printf("emitters=%d frames=%d size=%dx%d\n", count, frames, s_width, s_height);
+        return RunEmitterCheck(count, frames);
+    }
+    if (argc > 1 && strcmp(argv[1], "--dirty") == 0) {
+        int effect = 0;
+        if ((argc > 2 && !ParseInt(argv[2], &effect)) || effect < 0 || effect > 6) {
+            fprintf(stderr, "usage: %s --dirty [effect 1-6, 0 = all]\n", argv[0]);
+            return 1;
+        }
+        printf("sizes=1920x1080/7680x2160\n");
+        return RunDirtyCheck(effect);
+    }
+    if (argc > 1 && strcmp(argv[1], "--profiler") == 0) {
+        int events = 200000;
+        if (argc > 3 || (argc > 2 && !ParseInt(argv[2], &events)) || events <= 0) {
+            fprintf(stderr, "usage: %s --profiler [events per thread]\n", argv[0]);
+            return 1;
+        }
+        return RunProfilerCheck(events);
+    }
+    if (argc > 1 && strcmp(argv[1], "--kernels") == 0) {
+        int cases = 2000;
+        if (argc > 3 || (argc > 2 && !ParseInt(argv[2], &cases)) || cases <= 0) {
+            fprintf(stderr, "usage: %s --kernels [cases]\n", argv[0]);
+            return 1;
+        }
+        return RunKernelCheck(cases);
+    }
+    if (argc > 1 && strcmp(argv[1], "--blend") == 0) {
+        int cases = 20000;
+        if (argc > 3 || (argc > 2 && !ParseInt(argv[2], &cases)) || cases <= 0) {
+            fprintf(stderr, "usage: %s --blend [cases]\n", argv[0]);
+            return 1;
+        }
+        return RunBlendCheck(cases);
+    }
+    if (argc > 1 && strcmp(argv[1], "--forces") == 0) {
+        int points = 8, frames = 60;
+        bool parsed = argc <= 4;
+        if (argc > 2) parsed = ParseInt(argv[2], &points) && parsed;
+        if (argc > 3) parsed = ParseInt(argv[3], &frames) && parsed;
+        if (!parsed || points < 0 || points > FORCE_MAX_POINTS || frames < 1) {
+            fprintf(stderr, "usage: %s --forces [points 0-%d] [frames]\n", argv[0], FORCE_MAX_POINTS);
+            return 1;
+        }
+        printf("points=%d frames=%d size=%dx%d\n", points, frames, s_width, s_height);
+        return RunForceCheck(points, frames);
+    }
+    if (argc > 1 && strcmp(argv[1], "--raster") == 0) {
+        int cases = 20000;
+        if (argc > 3 || (argc > 2 && !ParseInt(argv[2], &cases)) || cases <= 0) {
+            fprintf(stderr, "usage: %s --raster [cases]\n", argv[0]);
+            return 1;
+        }
+        return RunRasterCheck(cases);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--governor") == 0) {
+        int effect = 4, frames = 600;
+        double budgetMs = GOVERNOR_DEFAULT_BUDGET_SECONDS * 1000.0;
+        bool parsed = argc <= 5;
+        if (argc > 2) parsed = ParseInt(argv[2], &effect) && parsed;
+        if (argc > 3) parsed = ParseDouble(argv[3], &budgetMs) && parsed;
+        if (argc > 4) parsed = ParseInt(argv[4], &frames) && parsed;
+        if (!parsed || effect < 1 || effect > 6 || budgetMs <= 0.0 || frames < 2) {
+            fprintf(stderr, "usage: %s --governor [effect 1-6] [budget ms] [frames]\n", argv[0]);
+            return 1;
+        }
+        SetCursorSource(SyntheticCursor);
+        SetActiveParticleSystem(effect);
+        printf("effect=%d budget_ms=%.2f frames=%d\n", effect, budgetMs, frames);
+        return RunGovernorCheck(budgetMs / 1000.0, frames);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--surface") == 0) {
+        const bool fit = argc > 2 && strcmp(argv[2], "fit") == 0;
+        int effect = 1, frames = 300;
+        bool parsed = argc >= 3 && argc <= 7 && (fit || strcmp(argv[2], "desktop") == 0);
+        if (argc > 3) parsed = ParseInt(argv[3], &effect) && parsed;
+        if (argc > 4) parsed = ParseInt(argv[4], &frames) && parsed;
+        if (argc > 5) parsed = ParseInt(argv[5], &s_width) && parsed;
+        if (argc > 6) parsed = ParseInt(argv[6], &s_height) && parsed;
+        if (!parsed || effect < 1 || effect > 6 || frames <= 0 || s_width <= 0 || s_height <= 0) {
+            fprintf(stderr, "usage: %s --surface fit|desktop [effect 1-6] [frames] [width] [height]\n", argv[0]);
+            return 1;
+        }
+        SeedParticleRng(1);
+        SetCursorSource(SyntheticCursor);
+        SetActiveParticleSystem(effect);
+        printf("effect=%d frames=%d size=%dx%d\n", effect, frames, s_width, s_height);
+        return RunSurfaceCheck(fit, frames);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--input") == 0) {
+        int effect = 3;
+        double fps = 30.0;
+        bool parsed = argc <= 4;
+        if (argc > 2) parsed = ParseInt(argv[2], &effect) && parsed;
+        if (argc > 3) parsed = ParseDouble(argv[3], &fps) && parsed;
+        if (!parsed || effect < 1 || effect > 6 || effect == 5 || fps <= 0.0) {
+            fprintf(stderr, "usage: %s --input [effect 1-6, not 5] [fps]\n", argv[0]);
+            return 1;
+        }
+        SeedParticleRng(1);
+        SetActiveParticleSystem(effect);
+        printf("effect=%d fps=%.1f\n", effect, fps);
+        return RunInputCheck(static_cast<float>(fps));
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--idle") == 0) {
+        int effect = 1;
+        double moveSeconds = 1.0;
+        bool parsed = argc <= 4;
+        if (argc > 2) parsed = ParseInt(argv[2], &effect) && parsed;
+        if (argc > 3) parsed = ParseDouble(argv[3], &moveSeconds) && parsed;
+        if (!parsed || effect < 1 || effect > 6 || moveSeconds <= 0.0) {
+            fprintf(stderr, "usage: %s --idle [effect 1-6] [move seconds]\n", argv[0]);
+            return 1;
+        }
+        SeedParticleRng(1);
+        SetCursorSource(SyntheticCursor);
+        SetActiveParticleSystem(effect);
+        printf("effect=%d move_seconds=%.2f\n", effect, moveSeconds);
+        return RunIdleCheck(static_cast<float>(moveSeconds));
+    }
+
+    int effect = 1, frames = 300, threads = 1;
+    bool parsed = argc <= 7;
+    if (argc > 1) parsed = ParseInt(argv[1], &effect) && parsed;
+    if (argc > 2) parsed = ParseInt(argv[2], &frames) && parsed;
+    if (argc > 3) parsed = ParseInt(argv[3], &s_width) && parsed;
+    if (argc > 4) parsed = ParseInt(argv[4], &s_height) && parsed;
+    if (argc > 5) parsed = ParseInt(argv[5], &threads) && parsed;
+    double presentHz = 0.0;
+    if (argc > 6) parsed = ParseDouble(argv[6], &presentHz) && parsed;
+    if (!parsed || effect < 1 || effect > 6 || frames <= 0 || s_width <= 0 || s_height <= 0 || threads < 0 ||
+        presentHz < 0.0) {
+        fprintf(stderr, "usage: %s [effect 1-6] [frames] [width] [height] [draw threads] [present Hz]\n", argv[0]);
+        return 1;
+    }
+
+    SeedParticleRng(1);
+    SetDrawThreadCount(threads);
+
+    std::vector<uint32_t> pixels(static_cast<size_t>(s_width) * s_height, 0);
+    Framebuffer fb = {};
+    fb.pixels = pixels.data();
+    fb.width  = s_width;
+    fb.height = s_height;
+    SetFramebuffer(fb);
+    SetCursorSource(SyntheticCursor);
+    SetActiveParticleSystem(effect);
+
+    printf("effect=%d frames=%d size=%dx%d threads=%d\n", effect, frames, s_width, s_height,
+           GetDrawThreadCount());
+
+    if (presentHz > 0.0) {
+        uint32_t checksum = 0;
+        int result = RunPipelined(frames, static_cast<float>(presentHz), &checksum);
+        printf("checksum=%08x\n", checksum);
+        return result;
+    }
+
+    const float dt = 1.0f / 60.0f;
+    size_t totalCleared = 0;
+    size_t peakParticles = 0;
+    for (int frame = 0; frame < frames; frame++) {
+        s_time = frame / 60.0f;
+        SpawnParticlesOnMouseMove();
+        UpdateParticles(dt);
+        DrawParticlesToDIB();
+
+        totalCleared += g_frameStats.bytesCleared;
+        if (GetLiveParticleCount() > peakParticles) peakParticles = GetLiveParticleCount();
+    }
+
+    printf("live=%zu peak=%zu avg_bytes_cleared=%zu\n",
+           GetLiveParticleCount(), peakParticles, totalCleared / frames);
+    SpriteCacheStats sprites = GetSpriteCacheStats();
+    printf("sprite_hits=%zu sprite_misses=%zu sprite_evictions=%zu\n",
+           sprites.hits, sprites.misses, sprites.evictions);
+    printf("checksum=%08x\n", Checksum(pixels));
+    return 0;
+}
@@ -0,0 +1,231 @@
+// tools/replay.cpp
+//
+// Replays a recorded cursor session (session_record.h) through the
+// particle core: every spawn, update, effect switch, budget and detail
+// change the recording engine saw, in order, with the recording's seed
+// and RNG stream, drawing each recorded frame into a framebuffer
+// covering the recorded desktop. Prints the FrameChecksum of every
+// frame's pixels chained into one run hash, the final frame's checksum,
+// time spent per stage and frame-time percentiles, so a session works
+// as a performance workload and as a golden-image test: frames are
+// identical for any draw thread count and on every run.
+//
+// --checksums writes one checksum per frame (hex, one per line);
+// --golden compares against such a file and exits with 2 on the first
+// frame that differs, or if the frame counts differ.
+//
+// Usage: mousetrail_replay <session> [--threads N] [--checksums out.txt]
+//                          [--golden in.txt]
+
+#include "particles.h"
+#include "cursor_input.h"
+#include "rng.h"
+#include "session_record.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Cursor source answering with the session's recorded samples
+static Point s_sample = { 0, 0 };
+static bool  s_hasSample = false;
+
+static bool RecordedCursor(Point* pt)
+{
+    *pt = s_sample;
+    return s_hasSample;
+}
+
+static double PercentileMs(std::vector<double> ms, double pct)
+{
+    if (ms.empty()) return 0.0;
+    std::sort(ms.begin(), ms.end());
+    size_t i = static_cast<size_t>(pct / 100.0 * (ms.size() - 1) + 0.5);
+    return ms[i];
+}
+
+static double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool ReadGolden(const char* path, std::vector<uint64_t>& checksums)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+    unsigned long long value;
+    while (fscanf(file, "%llx", &value) == 1) {
+        checksums.push_back(value);
+    }
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    const char* sessionPath = nullptr;
+    const char* checksumPath = nullptr;
+    const char* goldenPath = nullptr;
+    int threads = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--checksums") == 0 && i + 1 < argc) {
+            checksumPath = argv[++i];
+        } else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+            goldenPath = argv[++i];
+        } else if (argv[i][0] != '-' && !sessionPath) {
+            sessionPath = argv[i];
+        } else {
+            sessionPath = nullptr;
+            break;
+        }
+    }
+    if (!sessionPath || threads < 0) {
+        fprintf(stderr, "usage: %s <session> [--threads N] [--checksums out.txt] [--golden in.txt]\n", argv[0]);
+        return 1;
+    }
+
+    SessionReader reader;
+    if (!reader.Open(sessionPath)) {
+        fprintf(stderr, "%s: %s\n", sessionPath, reader.Error());
+        return 1;
+    }
+    std::vector<uint64_t> golden;
+    if (goldenPath && !ReadGolden(goldenPath, golden)) {
+        fprintf(stderr, "cannot read %s\n", goldenPath);
+        return 1;
+    }
+    FILE* checksumFile = nullptr;
+    if (checksumPath && !(checksumFile = fopen(checksumPath, "w"))) {
+        fprintf(stderr, "cannot write %s\n", checksumPath);
+        return 1;
+    }
+
+    // The recorded desktop, drawn into one framebuffer
+    const SessionHeader& header = reader.Header();
+    const Rect& desktop = header.desktop;
+    std::vector<uint32_t> pixels(static_cast<size_t>(desktop.right - desktop.left) * (desktop.bottom - desktop.top), 0);
+    FrameTarget target = {};
+    target.fb.pixels  = pixels.data();
+    target.fb.width   = desktop.right - desktop.left;
+    target.fb.height  = desktop.bottom - desktop.top;
+    target.fb.originX = desktop.left;
+    target.fb.originY = desktop.top;
+    ClearDirtyRegion(target.drawn);
+
+    // Where the recording started from
+    CursorEventQueue* queue = new CursorEventQueue();
+    SetCursorEventQueue(header.queuedInput ? queue : nullptr);
+    SetCursorSource(RecordedCursor);
+    SetDrawThreadCount(threads);
+    ClearParticles();
+    SetThreadRngStream(header.rngStream);
+    SeedParticleRng(header.seed);
+
+    double spawnSeconds = 0.0, updateSeconds = 0.0, drawSeconds = 0.0;
+    double frameSeconds = 0.0; // Work since the last frame drawn
+    std::vector<double> frameMs;
+    uint64_t checksum = 0;
+    uint64_t runHash = 0xCBF29CE484222325ull;
+    size_t records = 0, frames = 0, mismatchFrame = 0;
+    bool mismatch = false;
+
+    SessionRecord record;
+    while (reader.Next(&record)) {
+        records++;
+        auto start = std::chrono::steady_clock::now();
+        switch (record.type) {
+        case SessionRecordType::CURSOR_EVENT: {
+            CursorEvent e;
+            e.time = record.time;
+            e.x = static_cast<float>(record.x);
+            e.y = static_cast<float>(record.y);
+            queue->Push(e);
+            break;
+        }
+        case SessionRecordType::CURSOR_SAMPLE:
+            s_sample.x = record.x;
+            s_sample.y = record.y;
+            s_hasSample = true;
+            break;
+        case SessionRecordType::NO_CURSOR:
+            s_hasSample = false;
+            break;
+        case SessionRecordType::SPAWN:
+            SpawnParticlesUntil(record.time);
+            spawnSeconds += SecondsSince(start);
+            frameSeconds += SecondsSince(start);
+            break;
+        case SessionRecordType::UPDATE:
+            UpdateParticles(record.value);
+            updateSeconds += SecondsSince(start);
+            frameSeconds += SecondsSince(start);
+            break;
+        case SessionRecordType::DRAW: {
+            DrawParticlesToTarget(target, record.value);
+            const double seconds = SecondsSince(start);
+            drawSeconds += seconds;
+            frameMs.push_back((frameSeconds + seconds) * 1000.0);
+            frameSeconds = 0.0;
+
+            checksum = FrameChecksum(target);
+            runHash = (runHash ^ checksum) * 0x100000001B3ull;
+            if (checksumFile) fprintf(checksumFile, "%016" PRIx64 "\n", checksum);
+            if (goldenPath && !mismatch && (frames >= golden.size() || golden[frames] != checksum)) {
+                mismatch = true;
+                mismatchFrame = frames;
+            }
+            frames++;
+            break;
+        }
+        case SessionRecordType::EFFECT:
+            SetActiveParticleSystem(record.id);
+            break;
+        case SessionRecordType::DETAIL:
+            SetDetailLevel(record.value);
+            break;
+        case SessionRecordType::BUDGET:
+            SetParticleBudget(static_cast<ParticleType>(record.id), static_cast<size_t>(record.amount));
+            break;
+        case SessionRecordType::POLICY:
+            SetOverflowPolicy(static_cast<ParticleType>(record.id), static_cast<OverflowPolicy>(record.amount));
+            break;
+        case SessionRecordType::CLEAR:
+            ClearParticles();
+            break;
+        }
+    }
+    if (checksumFile) fclose(checksumFile);
+    SetCursorEventQueue(nullptr);
+    delete queue;
+    if (reader.Error()) {
+        fprintf(stderr, "%s: %s after %zu records\n", sessionPath, reader.Error(), records);
+        return 1;
+    }
+
+    printf("session=%s bytes=%zu records=%zu frames=%zu threads=%d\n",
+           sessionPath, reader.Size(), records, frames, GetDrawThreadCount());
+    printf("spawn_ms=%.1f update_ms=%.1f draw_ms=%.1f\n",
+           spawnSeconds * 1000.0, updateSeconds * 1000.0, drawSeconds * 1000.0);
+    printf("frame_p50_ms=%.3f frame_p90_ms=%.3f frame_p99_ms=%.3f frame_max_ms=%.3f\n",
+           PercentileMs(frameMs, 50), PercentileMs(frameMs, 90), PercentileMs(frameMs, 99),
+           PercentileMs(frameMs, 100));
+    printf("checksum=%016" PRIx64 " run_hash=%016" PRIx64 "\n", checksum, runHash);
+
+    if (goldenPath) {
+        if (!mismatch && frames != golden.size()) {
+            mismatch = true;
+            mismatchFrame = std::min(frames, golden.size());
+        }
+        if (mismatch) {
+            printf("golden: frame %zu differs (%zu frames, %zu golden)\n", mismatchFrame, frames, golden.size());
+            return 2;
+        }
+        printf("golden: %zu frames match\n", frames);
+    }
+    return 0;
+}